@@ -595,10 +595,6 @@ static void EXTI14_IRQHandler(void)
 {
 }
 
-static void MDMA_IRQHandler(void)
-{
-}
-
 static void SDMMC2_IRQHandler(void)
 {
 }
@@ -138,28 +138,6 @@ typedef struct {
    uint32_t ADDRMAP11;
 } HAL_DDR_MapTypeDef;
 
-typedef struct {
-   uint32_t SCHED;
-   uint32_t SCHED1;
-   uint32_t PERFHPR1;
-   uint32_t PERFLPR1;
-   uint32_t PERFWR1;
-   uint32_t PCFGR_0;
-   uint32_t PCFGW_0;
-   uint32_t PCFGQOS0_0;
-   uint32_t PCFGQOS1_0;
-   uint32_t PCFGWQOS0_0;
-   uint32_t PCFGWQOS1_0;
-#ifdef DDR_DUAL_AXI_PORT
-   uint32_t PCFGR_1;
-   uint32_t PCFGW_1;
-   uint32_t PCFGQOS0_1;
-   uint32_t PCFGQOS1_1;
-   uint32_t PCFGWQOS0_1;
-   uint32_t PCFGWQOS1_1;
-#endif /* DDR_DUAL_AXI_PORT */
-} HAL_DDR_PerfTypeDef;
-
 typedef struct {
    uint32_t PGCR;
    uint32_t ACIOCR;
@@ -656,6 +634,33 @@ static HAL_StatusTypeDef set_reg(reg_type type, uint32_t param)
    return HAL_OK;
 }
 
+/**
+ * @brief  Get DDR Registers into a parameter structure
+ * @param  type Register Type
+ * @param  param Parameter structure address
+ * @retval HAL Status
+ */
+static HAL_StatusTypeDef get_reg(reg_type type, uint32_t param)
+{
+   uint8_t i;
+   uint32_t base_addr     = get_base_addr(ddr_registers[type].base);
+   const reg_desc_t *desc = ddr_registers[type].desc;
+
+   for (i = 0; i < ddr_registers[type].size; i++) {
+      if (desc[i].par_offset == INVALID_OFFSET) {
+         return HAL_ERROR;
+      } else {
+         uint32_t address = param + (uint32_t)desc[i].par_offset;
+         uint32_t *ptr    = (uint32_t *)address;
+
+         *ptr = READ_REG(
+             *(volatile uint32_t *)(base_addr + (uint32_t)desc[i].offset));
+      }
+   }
+
+   return HAL_OK;
+}
+
 static HAL_StatusTypeDef ddrphy_idone_wait(void)
 {
    uint32_t pgsr;
@@ -1972,17 +1977,25 @@ HAL_StatusTypeDef HAL_DDR_Init(DDR_InitTypeDef *iddr)
       pir |= DDRPHYC_PIR_RVTRN;
    }
 
-   ret = HAL_DDR_PHY_Init(pir);
-   if (ret != HAL_OK) {
-      return ret;
-   }
+   if (iddr->trained != NULL) {
+      /* Restore the results of an earlier training instead */
+      WRITE_REG(DDRPHYC->DX0DQSTR, iddr->trained[0]);
+      WRITE_REG(DDRPHYC->DX1DQSTR, iddr->trained[1]);
+      WRITE_REG(DDRPHYC->DX0DQTR, iddr->trained[2]);
+      WRITE_REG(DDRPHYC->DX1DQTR, iddr->trained[3]);
+   } else {
+      ret = HAL_DDR_PHY_Init(pir);
+      if (ret != HAL_OK) {
+         return ret;
+      }
 
-   /* 11. monitor PUB PGSR.IDONE to poll cpmpletion of training
-    *     sequence
-    */
-   ret = ddrphy_idone_wait();
-   if (ret != HAL_OK) {
-      return ret;
+      /* 11. monitor PUB PGSR.IDONE to poll cpmpletion of training
+       *     sequence
+       */
+      ret = ddrphy_idone_wait();
+      if (ret != HAL_OK) {
+         return ret;
+      }
    }
 
    /* Refresh compensation: forcing refresh command */
@@ -2240,6 +2253,55 @@ HAL_DDR_SelfRefreshModeTypeDef HAL_DDR_SR_ReadMode(void)
    return ddr_sr_read_mode();
 }
 
+/**
+ * @brief  Read the performance (scheduler and port QoS) registers.
+ * @param  perf Where to store them.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_DDR_Perf_Get(HAL_DDR_PerfTypeDef *perf)
+{
+   return get_reg(REG_PERF, (uint32_t)perf);
+}
+
+/**
+ * @brief  Reprogram the performance registers of the running controller.
+ *         Nothing may access DDR until this returns: the caller runs from
+ *         SYSRAM with interrupts masked and the data cache cleaned.
+ * @param  perf New register values; SCHED.lpr_num_entries must be
+ *         unchanged, as it is static and sizes the CAM.
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_DDR_Perf_Set(const HAL_DDR_PerfTypeDef *perf)
+{
+   HAL_StatusTypeDef ret;
+
+   if (((perf->SCHED ^ READ_REG(DDRCTRL->SCHED)) &
+        DDRCTRL_SCHED_LPR_NUM_ENTRIES_Msk) != 0U) {
+      return HAL_ERROR;
+   }
+
+   /**
+    * manage quasi-dynamic registers modification
+    * sched, perfhpr1, perflpr1, perfwr1, pcfgqos, pcfgwqos: Group 3
+    */
+   if (set_qd3_update_conditions() != 0) {
+      enable_host_interface();
+      enable_axi_port();
+      return HAL_ERROR;
+   }
+
+   ret = set_reg(REG_PERF, (uint32_t)perf);
+
+   if (unset_qd3_update_conditions() != HAL_OK) {
+      /* Let traffic through again whatever the controller took. */
+      enable_host_interface();
+      enable_axi_port();
+      ret = HAL_ERROR;
+   }
+
+   return ret;
+}
+
 /**
  * @}
  */
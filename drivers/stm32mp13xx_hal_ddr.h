@@ -68,6 +68,31 @@ typedef enum {
    HAL_DDR_INVALID_MODE         = 0x3U, /*!< DDR Invalid Self Refresh Mode */
 } HAL_DDR_SelfRefreshModeTypeDef;
 
+/**
+ * @brief  DDR controller performance registers
+ */
+typedef struct {
+   uint32_t SCHED;
+   uint32_t SCHED1;
+   uint32_t PERFHPR1;
+   uint32_t PERFLPR1;
+   uint32_t PERFWR1;
+   uint32_t PCFGR_0;
+   uint32_t PCFGW_0;
+   uint32_t PCFGQOS0_0;
+   uint32_t PCFGQOS1_0;
+   uint32_t PCFGWQOS0_0;
+   uint32_t PCFGWQOS1_0;
+#ifdef DDR_DUAL_AXI_PORT
+   uint32_t PCFGR_1;
+   uint32_t PCFGW_1;
+   uint32_t PCFGQOS0_1;
+   uint32_t PCFGQOS1_1;
+   uint32_t PCFGWQOS0_1;
+   uint32_t PCFGWQOS1_1;
+#endif /* DDR_DUAL_AXI_PORT */
+} HAL_DDR_PerfTypeDef;
+
 /**
  * @brief  DDR Initialization Structure definition
  */
@@ -95,8 +120,19 @@ typedef struct {
                         Specifies if backup should be cleared after
                         DDR initialization (DDR lost content case).
                         Clear requested if true. */
+
+   const uint32_t *trained; /*!< [input]
+                                 DX0DQSTR, DX1DQSTR, DX0DQTR and DX1DQTR
+                                 from an earlier DQS training, or NULL.
+                                 If given, they are written back instead
+                                 of running the training; the memory
+                                 tests at the end of the sequence are
+                                 then the only check that they still
+                                 hold. */
 } DDR_InitTypeDef;
 
+#define HAL_DDR_TRAINED_REGS 4U
+
 /**
  * @}
  */
@@ -129,6 +165,8 @@ HAL_StatusTypeDef HAL_DDR_SR_Entry(uint32_t *zq0cr0_zdata);
 HAL_StatusTypeDef HAL_DDR_SR_Exit(void);
 HAL_StatusTypeDef HAL_DDR_SR_SetMode(HAL_DDR_SelfRefreshModeTypeDef mode);
 HAL_DDR_SelfRefreshModeTypeDef HAL_DDR_SR_ReadMode(void);
+HAL_StatusTypeDef HAL_DDR_Perf_Get(HAL_DDR_PerfTypeDef *perf);
+HAL_StatusTypeDef HAL_DDR_Perf_Set(const HAL_DDR_PerfTypeDef *perf);
 
 /**
  * @}
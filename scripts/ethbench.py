@@ -0,0 +1,159 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+PC side of the bootloader's `eth_bench` command.
+
+Each mode pairs with one on the board (frame format in src/eth_bench.h):
+    ethbench.py eth0 rx [secs]          count the board's TX flood (mode 0)
+    ethbench.py eth0 tx [size] [secs]   flood the board (mode 1)
+    ethbench.py eth0 echo [secs]        answer the board's pings (mode 2)
+    ethbench.py eth0 ping [size] [n]    ping the board (mode 3)
+
+Start the receiving or answering side first. Needs Linux and root (or
+CAP_NET_RAW) for the raw socket. The PC's own numbers include the kernel
+and Python overhead, so for latency the board-side ping (mode 2 against
+`echo` here) is the one to quote.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from ethload import Link
+
+ETHERTYPE = 0x88B6
+HDR_FMT   = '>BBHII'          # op, 0, 0, seq, timestamp
+HDR_SZ    = 12
+ETH_HDR   = 14
+WIRE      = 24                # preamble, FCS and inter-frame gap, bytes
+
+OP_DATA = 1
+OP_PING = 2
+OP_PONG = 3
+
+BROADCAST = b'\xff' * 6
+
+
+def header(dst, src, op, seq):
+    us = int(time.perf_counter() * 1e6) & 0xFFFFFFFF
+    return (dst + src + struct.pack('>H', ETHERTYPE) +
+            struct.pack(HDR_FMT, op, 0, 0, seq, us))
+
+
+def parse(f):
+    """(src mac, op, seq) or None."""
+    if f is None or len(f) < ETH_HDR + HDR_SZ:
+        return None
+    op, _, _, seq, _ = struct.unpack(HDR_FMT, f[ETH_HDR:ETH_HDR + HDR_SZ])
+    return f[6:12], op, seq
+
+
+def report(n, nbytes, dt):
+    dt = dt or 1e-9
+    print(f'  {n} frames in {dt * 1000:.0f} ms: {n / dt:.0f} frames/s')
+    print(f'  {nbytes * 8 / dt / 1e6:.1f} Mb/s of frames, '
+          f'{(nbytes + n * WIRE) * 8 / dt / 1e6:.1f} Mb/s on the wire')
+
+
+def rx(link, secs):
+    print(f'RX: counting data frames for {secs} s after the first')
+    n = nbytes = 0
+    first = last = t0 = None
+    while t0 is None or time.monotonic() - t0 < secs:
+        f = link.recv(1.0 if t0 is None else
+                      max(0, secs - (time.monotonic() - t0)))
+        p = parse(f)
+        if not p or p[1] != OP_DATA:
+            continue
+        if t0 is None:
+            t0, first = time.monotonic(), p[2]
+        n, nbytes, last = n + 1, nbytes + len(f), p[2]
+    report(n, nbytes, time.monotonic() - t0)
+    print(f'  {last - first + 1 - n} lost')
+
+
+def tx(link, size, secs):
+    print(f'TX flood: {size}-byte frames for {secs} s')
+    pad = bytes(size - ETH_HDR - HDR_SZ)
+    n = 0
+    t0 = time.monotonic()
+    while time.monotonic() - t0 < secs:
+        link.send(header(BROADCAST, link.mac, OP_DATA, n) + pad)
+        n += 1
+    report(n, n * size, time.monotonic() - t0)
+
+
+def echo(link, secs):
+    print(f'Echo: answering pings for {secs} s')
+    n = 0
+    t0 = time.monotonic()
+    while time.monotonic() - t0 < secs:
+        f = link.recv(0.5)
+        p = parse(f)
+        if not p or p[1] != OP_PING:
+            continue
+        link.send(p[0] + link.mac + f[12:14] + bytes([OP_PONG]) + f[15:])
+        n += 1
+    print(f'  {n} pings answered')
+
+
+def ping(link, size, count):
+    print(f'Ping-pong: {count} pings of {size} bytes')
+    pad = bytes(size - ETH_HDR - HDR_SZ)
+    board, rtts, lost = BROADCAST, [], 0
+    for i in range(count):
+        t0 = time.perf_counter()
+        link.send(header(board, link.mac, OP_PING, i) + pad)
+        while True:
+            left = 0.1 - (time.perf_counter() - t0)
+            p = parse(link.recv(left) if left > 0 else None)
+            if p is None and left <= 0:
+                lost += 1
+                break
+            if p and p[1] == OP_PONG and p[2] == i:
+                rtts.append((time.perf_counter() - t0) * 1e6)
+                board = p[0]
+                break
+    if not rtts:
+        print('  no replies')
+        return
+    print(f'  {len(rtts)} replies, {lost} lost; RTT min {min(rtts):.0f} '
+          f'avg {sum(rtts) / len(rtts):.0f} max {max(rtts):.0f} us')
+    edges = [16 << b for b in range(10)]
+    hist = [0] * (len(edges) + 1)
+    for r in rtts:
+        hist[sum(r >= e for e in edges)] += 1
+    for b, h in enumerate(hist):
+        if h:
+            label = f'< {edges[b]:4d}' if b < len(edges) else f'>={edges[-1]:4d}'
+            print(f'  {label} us: {h:6d} ' + '#' * -(-h * 40 // len(rtts)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('iface', help='network interface, e.g. eth0')
+    ap.add_argument('mode', choices=['rx', 'tx', 'echo', 'ping'])
+    ap.add_argument('args', nargs='*', type=int,
+                    help='size and/or seconds or count, as for the board')
+    args = ap.parse_args()
+
+    link = Link(args.iface, ETHERTYPE)
+    a = args.args
+    if args.mode == 'rx':
+        rx(link, a[0] if a else 10)
+    elif args.mode == 'echo':
+        echo(link, a[0] if a else 30)
+    else:
+        size = a[0] if a else 1514
+        if not 60 <= size <= 1514:
+            sys.exit('frame size must be 60 to 1514 bytes')
+        if args.mode == 'tx':
+            tx(link, size, a[1] if len(a) > 1 else 5)
+        else:
+            ping(link, size, a[1] if len(a) > 1 else 1000)
+
+
+if __name__ == '__main__':
+    main()
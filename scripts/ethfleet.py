@@ -0,0 +1,266 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Flash one image to a rack of boards at once over Ethernet multicast.
+
+Run `mcload 1` on every board (plain `mcload` only receives), then:
+    sudo ethfleet.py eth0 sdcard.simg --boards 20
+
+The image goes out once to the group 03:53:54:4D:88:B5 at a paced rate.
+At the end of each pass every board reports the chunks it is missing, and
+the next pass resends only the union of those, until all boards hold the
+whole image (see src/ethload.h for the frame format). Every frame carries
+the CRC-32 of the whole image, which each board checks before it writes
+the image to its SD card or NAND. Without --boards, the transfer ends
+when every board that answered is complete.
+
+--loopback simulates a rack in this process, each board behind its own
+lossy link, to exercise the repair logic without hardware:
+    ethfleet.py --loopback --boards 20 --loss 0.02 image.bin
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+import zlib
+
+from ethload import (CHUNK, ST_DONE, ST_RECEIVING, ST_REFUSED, Link, frame,
+                     parse)
+
+OP_MDATA = 5
+OP_MEND  = 6
+OP_MREP  = 7
+
+GROUP    = bytes([0x03, 0x53, 0x54, 0x4D, 0x88, 0xB5])
+INFO_FMT = '>IHHI'            # image length, chunk size, 0, CRC-32
+INFO_SZ  = struct.calcsize(INFO_FMT)
+MC_CHUNK = CHUNK - INFO_SZ
+WIRE     = 24                 # preamble, FCS and inter-frame gap, bytes
+
+REPORT_S  = 0.15              # wait for reports after each END
+END_TRIES = 3
+PASSES    = 50
+
+
+class Pacer:
+    """Spread frames out to a given line rate."""
+
+    def __init__(self, bps):
+        self.bps, self.t = bps, time.perf_counter()
+
+    def wait(self, nbytes):
+        self.t = max(self.t, time.perf_counter() - 0.001)
+        self.t += (nbytes + WIRE) * 8 / self.bps
+        ahead = self.t - time.perf_counter()
+        if ahead > 0.001:
+            time.sleep(ahead)
+        while time.perf_counter() < self.t:
+            pass
+
+
+def ranges_to_chunks(ranges):
+    out = set()
+    for first, count in ranges:
+        out.update(range(first, first + count))
+    return out
+
+
+def send_fleet(link, data, boards=None, bps=80e6, chunk=MC_CHUNK):
+    """Multicast data until every board has it; returns the set of boards
+    (MAC addresses) that completed."""
+    session = random.randrange(1, 0x10000)
+    nchunks = (len(data) + chunk - 1) // chunk
+    info = struct.pack(INFO_FMT, len(data), chunk, 0, zlib.crc32(data))
+    pacer = Pacer(bps)
+
+    done, refused, seen = set(), set(), set()
+    todo = list(range(nchunks))
+    t0 = time.monotonic()
+
+    for npass in range(1, PASSES + 1):
+        for i in todo:
+            f = frame(GROUP, link.mac, OP_MDATA, session, i,
+                      info + data[i * chunk:(i + 1) * chunk])
+            pacer.wait(len(f))
+            link.send(f)
+
+        # collect reports; boards that already finished need not answer
+        missing = {}
+        for _ in range(END_TRIES):
+            link.send(frame(GROUP, link.mac, OP_MEND, session, npass, info))
+            t_end = time.monotonic() + REPORT_S
+            while time.monotonic() < t_end:
+                p = parse(link.recv(max(0, t_end - time.monotonic())) or b'')
+                if not p or p[1] != OP_MREP or p[3] != session:
+                    continue
+                mac, status, payload = p[0], p[2], p[5]
+                seen.add(mac)
+                if status == ST_DONE:
+                    done.add(mac)
+                    missing.pop(mac, None)
+                elif status == ST_REFUSED:
+                    refused.add(mac)
+                elif status == ST_RECEIVING:
+                    n = (len(payload) - 4) // 8
+                    missing[mac] = struct.unpack(f'>{2 * n}I',
+                                                 payload[4:4 + 8 * n])
+            if seen and seen - done - refused <= set(missing):
+                break
+
+        print(f'pass {npass}: {len(todo)} chunks sent, '
+              f'{len(done)}/{boards or len(seen)} boards done')
+        if boards is not None and len(done) >= boards:
+            break
+        if boards is None and seen and seen <= done | refused:
+            break
+
+        need = set()
+        for mac, r in missing.items():
+            if mac not in done:
+                need |= ranges_to_chunks(zip(r[0::2], r[1::2]))
+        # nobody heard anything yet: start over for late boards
+        todo = sorted(need) if need or seen else list(range(nchunks))
+    else:
+        print('ethfleet: giving up')
+
+    dt = time.monotonic() - t0
+    for mac in sorted(refused):
+        print(f'  {mac.hex(":")} refused the image (too large?)')
+    for mac in sorted(seen - done - refused):
+        print(f'  {mac.hex(":")} incomplete')
+    print(f'ethfleet: {len(data)} bytes to {len(done)} boards in {dt:.3f} s, '
+          f'{len(data) / dt / 1e6 if dt else 0:.2f} MB/s')
+    return done
+
+
+class Board(threading.Thread):
+    """The firmware receiver (mcload in ethload.c), for --loopback."""
+
+    def __init__(self, link):
+        super().__init__(daemon=True)
+        self.link, self.session, self.status = link, None, ST_RECEIVING
+        self.data = None
+
+    def report(self):
+        ranges, i = [], 0
+        while i < self.chunks and len(ranges) < 256:
+            if self.have[i]:
+                i += 1
+                continue
+            first = i
+            while i < self.chunks and not self.have[i]:
+                i += 1
+            ranges += [first, i - first]
+        self.link.send(frame(self.sender, self.link.mac, OP_MREP,
+                             self.session, sum(self.have),
+                             struct.pack(f'>I{len(ranges)}I', self.chunks,
+                                         *ranges), self.status))
+
+    def run(self):
+        while True:
+            p = parse(self.link.recv(None) or b'')
+            if not p or p[1] not in (OP_MDATA, OP_MEND):
+                continue
+            src, op, _, session, seq, payload = p
+            if session != self.session:
+                length, self.chunk, _, self.crc = struct.unpack(
+                    INFO_FMT, payload[:INFO_SZ])
+                self.sender, self.session, self.len = src, session, length
+                self.chunks = -(-length // self.chunk)
+                self.have = bytearray(self.chunks)
+                self.data = bytearray(length)
+                self.status = ST_DONE if not self.chunks else ST_RECEIVING
+            if op == OP_MEND:
+                self.report()
+            elif self.status == ST_RECEIVING and not self.have[seq]:
+                off = seq * self.chunk
+                self.data[off:off + self.chunk] = \
+                    payload[INFO_SZ:INFO_SZ + min(self.chunk, self.len - off)]
+                self.have[seq] = 1
+                if all(self.have):
+                    self.status = ST_DONE
+                    self.report()
+
+
+class Rack:
+    """Sender side of the loopback: frames fan out to every board, each
+    copy dropped at random; replies come back on one shared socket."""
+
+    def __init__(self, n, loss):
+        self.mac, self.loss = b'\x02\x00\x00\x00\x00\x01', loss
+        self.up, up_w = socket.socketpair(socket.AF_UNIX, socket.SOCK_DGRAM)
+        self.down, self.boards = [], []
+        for k in range(n):
+            a, b = socket.socketpair(socket.AF_UNIX, socket.SOCK_DGRAM)
+            self.down.append(a)
+            self.boards.append(Board(BoardLink(b, up_w, k, loss)))
+
+    def send(self, f):
+        for s in self.down:
+            if random.random() >= self.loss:
+                s.send(f)
+
+    def recv(self, timeout):
+        self.up.settimeout(timeout)
+        try:
+            return self.up.recv(2048)
+        except (socket.timeout, BlockingIOError):
+            return None
+
+
+class BoardLink:
+    """Board side of the loopback."""
+
+    def __init__(self, down, up, k, loss):
+        self.down, self.up, self.loss = down, up, loss
+        self.mac = bytes([0x02, 0, 0, 0, 1, k])
+
+    def send(self, f):
+        if random.random() >= self.loss:
+            self.up.send(f)
+
+    def recv(self, timeout):
+        self.down.settimeout(timeout)
+        return self.down.recv(2048)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('iface', nargs='?', help='network interface, e.g. eth0')
+    ap.add_argument('image', help='file to send')
+    ap.add_argument('--boards', type=int, help='number of boards to wait for')
+    ap.add_argument('--rate', type=float, default=80,
+                    help='send rate in Mb/s (default 80)')
+    ap.add_argument('--loopback', action='store_true',
+                    help='simulate a rack in-process')
+    ap.add_argument('--loss', type=float, default=0.0,
+                    help='loopback frame loss probability per board')
+    args = ap.parse_args()
+
+    data = open(args.image, 'rb').read()
+    if not args.loopback:
+        if args.iface is None:
+            ap.error('iface is required without --loopback')
+        done = send_fleet(Link(args.iface), data, args.boards,
+                          args.rate * 1e6)
+        sys.exit(0 if args.boards is None or len(done) >= args.boards
+                 else 1)
+
+    rack = Rack(args.boards or 4, args.loss)
+    for b in rack.boards:
+        b.start()
+    send_fleet(rack, data, args.boards, args.rate * 1e6)
+    bad = [b for b in rack.boards if bytes(b.data or b'') != data or
+           zlib.crc32(b.data) != b.crc]
+    if bad:
+        sys.exit(f'ethfleet: {len(bad)} loopback boards hold a bad image')
+    print(f'ethfleet: loopback images verified on {len(rack.boards)} boards')
+
+
+if __name__ == '__main__':
+    main()
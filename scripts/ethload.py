@@ -0,0 +1,181 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Send an image to the bootloader's `ethload` command over raw Ethernet.
+
+The protocol is described in src/ethload.h. Frames go out on EtherType
+0x88B5 through an AF_PACKET socket, so this needs Linux and root (or
+CAP_NET_RAW):
+    sudo ethload.py eth0 image.bin
+
+The board is found by broadcasting START; after that, frames go to the
+MAC address that answered. On the board, run `ethload` first.
+
+The board side, src/ethload.c, is tested on the host by replaying packet
+captures through it (`make net_test`, see test/net).
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import time
+
+ETHERTYPE = 0x88B5
+ETH_HDR   = 14
+HDR_FMT   = '>BBHI'           # op, status, session, seq
+HDR_SZ    = 8
+MTU       = 1500
+CHUNK     = MTU - HDR_SZ
+
+OP_START = 1
+OP_DATA  = 2
+OP_ACK   = 3
+OP_POLL  = 4
+
+ST_RECEIVING = 0
+ST_DONE      = 1
+ST_REFUSED   = 2
+
+BROADCAST = b'\xff' * 6
+RTO       = 0.05              # resend a chunk at most this often
+FAST_RTO  = 0.002             # ... or this often once it is known lost
+POLL_S    = 0.02              # ask for an ACK after this long without one
+GIVE_UP_S = 5.0
+
+
+def frame(dst, src, op, session, seq, payload=b'', status=0):
+    return (dst + src + struct.pack('>H', ETHERTYPE) +
+            struct.pack(HDR_FMT, op, status, session, seq) + payload)
+
+
+def parse(f):
+    """(src mac, op, status, session, seq, payload) or None."""
+    if len(f) < ETH_HDR + HDR_SZ or \
+       struct.unpack('>H', f[12:14])[0] != ETHERTYPE:
+        return None
+    op, status, session, seq = struct.unpack(HDR_FMT, f[ETH_HDR:ETH_HDR +
+                                                       HDR_SZ])
+    return f[6:12], op, status, session, seq, f[ETH_HDR + HDR_SZ:]
+
+
+class Link:
+    """Raw socket on an interface."""
+
+    def __init__(self, iface, ethertype=ETHERTYPE):
+        self.sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW,
+                                  socket.htons(ethertype))
+        self.sock.bind((iface, ethertype))
+        self.mac = self.sock.getsockname()[4][:6]
+
+    def send(self, f):
+        self.sock.send(f)
+
+    def recv(self, timeout):
+        self.sock.settimeout(timeout)
+        try:
+            return self.sock.recv(2048)
+        except (socket.timeout, BlockingIOError):
+            return None
+
+
+def send_image(link, data, chunk=CHUNK, window=None):
+    """Stream data to the board; returns the seconds it took."""
+    session = random.randrange(1, 0x10000)
+    nchunks = (len(data) + chunk - 1) // chunk
+    start = struct.pack('>IH', len(data), chunk)
+
+    # find the board
+    board = None
+    for _ in range(50):
+        link.send(frame(BROADCAST, link.mac, OP_START, session, 0, start))
+        t_end = time.monotonic() + 0.2
+        while board is None and time.monotonic() < t_end:
+            p = parse(link.recv(0.05) or b'')
+            if p and p[1] == OP_ACK and p[3] == session:
+                board, status, win = p[0], p[2], struct.unpack(
+                    '>QI', p[5][:12])[1]
+        if board is not None:
+            break
+    if board is None:
+        sys.exit('ethload: no answer from the board')
+    if status == ST_REFUSED:
+        sys.exit('ethload: board refused the image (too large?)')
+    window = min(window or win, win)
+
+    t0 = time.monotonic()
+    nxt = 0                   # board's first missing chunk
+    held = 0                  # its bitmap of chunks past nxt
+    sent = 0                  # chunks sent at least once
+    last_tx = {}              # chunk -> time it was last sent
+    last_rx = t0
+    t_print = t0
+    resent = 0
+    done = status == ST_DONE
+
+    def send_chunk(i):
+        link.send(frame(board, link.mac, OP_DATA, session, i,
+                        data[i * chunk:(i + 1) * chunk]))
+        last_tx[i] = time.monotonic()
+
+    while not done:
+        now = time.monotonic()
+
+        # resend what the board reported missing (quickly if it already
+        # holds a later chunk), then fill the window
+        top = nxt + held.bit_length()
+        for i in range(nxt, sent):
+            if i > nxt and held >> (i - nxt - 1) & 1:
+                continue
+            if now - last_tx[i] >= (FAST_RTO if i < top else RTO):
+                send_chunk(i)
+                resent += 1
+        while sent < min(nchunks, nxt + window + 1):
+            send_chunk(sent)
+            sent += 1
+
+        f = link.recv(POLL_S)
+        if f is None:
+            if time.monotonic() - last_rx > GIVE_UP_S:
+                sys.exit('ethload: board stopped answering')
+            link.send(frame(board, link.mac, OP_POLL, session, 0))
+            continue
+        while f is not None:
+            p = parse(f)
+            if p and p[1] == OP_ACK and p[3] == session:
+                last_rx = time.monotonic()
+                if p[4] >= nxt:
+                    nxt = p[4]
+                    held = struct.unpack('>Q', p[5][:8])[0]
+                for i in [i for i in last_tx if i < nxt]:
+                    del last_tx[i]
+                done = p[2] == ST_DONE
+            f = link.recv(0) if not done else None
+
+        if time.monotonic() - t_print >= 0.5:
+            t_print = time.monotonic()
+            pct = 100 * nxt // max(nchunks, 1)
+            print(f'\r{pct:3d}%  {nxt * chunk >> 10} KiB', end='', flush=True)
+
+    dt = time.monotonic() - t0
+    print(f'\rethload: {len(data)} bytes in {dt:.3f} s, '
+          f'{len(data) / dt / 1e6 if dt else 0:.2f} MB/s, '
+          f'{resent} chunks resent')
+    return dt
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('iface', help='network interface, e.g. eth0')
+    ap.add_argument('image', help='file to send')
+    ap.add_argument('--window', type=int, help='chunks in flight (max 64)')
+    args = ap.parse_args()
+
+    data = open(args.image, 'rb').read()
+    send_image(Link(args.iface), data, window=args.window)
+
+
+if __name__ == '__main__':
+    main()
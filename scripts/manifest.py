@@ -0,0 +1,74 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Boot image manifest (layout in src/manifest.h): the length and SHA-256 of
+each image, which the bootloader checks as it loads them. sdimage.py and
+nandimage.py write it; standalone use prints one:
+    manifest.py build/sdcard.img            (SD image, sector 1)
+    manifest.py build/nand.img --nand       (NAND image, PT block)
+"""
+
+import argparse
+import hashlib
+import struct
+
+MAGIC       = 0x4D414E49  # "MANI"
+VERSION     = 1
+MAX_IMAGES  = 4
+SD_LBA      = 1
+NAND_OFFSET = 4096        # within the partition table block
+
+HDR_FMT   = '<III'
+ENTRY_FMT = '<16sI32s'
+SIZE      = (struct.calcsize(HDR_FMT) + MAX_IMAGES *
+             struct.calcsize(ENTRY_FMT) + 32)
+
+
+def make_manifest(images):
+    """images: list of (name, data). Returns the manifest bytes."""
+    if len(images) > MAX_IMAGES:
+        raise ValueError(f'at most {MAX_IMAGES} images')
+    body = struct.pack(HDR_FMT, MAGIC, VERSION, len(images))
+    for name, data in images:
+        body += struct.pack(ENTRY_FMT, name.encode('ascii')[:16], len(data),
+                            hashlib.sha256(data).digest())
+    body += b'\0' * struct.calcsize(ENTRY_FMT) * (MAX_IMAGES - len(images))
+    return body + hashlib.sha256(body).digest()
+
+
+def parse_manifest(raw):
+    """Returns a list of (name, size, digest), or None if raw is not one."""
+    magic, version, n = struct.unpack_from(HDR_FMT, raw)
+    if magic != MAGIC or version != VERSION or n > MAX_IMAGES:
+        return None
+    if hashlib.sha256(raw[:SIZE - 32]).digest() != raw[SIZE - 32:SIZE]:
+        return None
+    out = []
+    for i in range(n):
+        off = struct.calcsize(HDR_FMT) + i * struct.calcsize(ENTRY_FMT)
+        name, size, digest = struct.unpack_from(ENTRY_FMT, raw, off)
+        out.append((name.rstrip(b'\0').decode(), size, digest))
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('image', help='SD or NAND image')
+    ap.add_argument('--nand', action='store_true',
+                    help='NAND image (manifest in the PT block)')
+    args = ap.parse_args()
+
+    from nandimage import BLOCK, BLOCK_PT
+    off = BLOCK_PT * BLOCK + NAND_OFFSET if args.nand else SD_LBA * 512
+    with open(args.image, 'rb') as f:
+        f.seek(off)
+        entries = parse_manifest(f.read(SIZE))
+    if entries is None:
+        raise SystemExit(f'{args.image}: no valid manifest')
+    for name, size, digest in entries:
+        print(f'{name:<16} {size:>10}  {digest.hex()}')
+
+
+if __name__ == '__main__':
+    main()
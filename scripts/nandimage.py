@@ -16,15 +16,19 @@ Block layout (matches nand_pt.h):
 import argparse
 import struct
 import sys
+import zlib
 from pathlib import Path
 
+from manifest import NAND_OFFSET, make_manifest
+from sparse import write_sparse
+
 # NAND geometry (must match board.h)
 PAGE  = 4096
 BLOCK = 64 * PAGE          # 256 KiB per block
 
 # Partition table constants (must match nand_pt.h)
 PT_MAGIC     = 0x4E414E44  # "NAND"
-PT_VERSION   = 1
+PT_VERSION   = 2
 PT_MAX_PARTS = 8
 
 BLOCK_BOOT       = 0
@@ -34,8 +38,9 @@ BLOCK_KERNEL     = 4
 KERNEL_MAX_BLOCKS = 64   # kernel partition is always this many blocks; rootfs follows after
 BLOCK_ROOTFS     = BLOCK_KERNEL + KERNEL_MAX_BLOCKS  # 68
 
-# struct nand_part_t:  char name[16], uint32 start_block, uint32 num_blocks
-PART_FMT  = '<16sII'
+# struct nand_part_t:  char name[16], uint32 start_block, num_blocks, size,
+#                      crc32
+PART_FMT  = '<16sIIII'
 # struct nand_pt_t header: uint32 magic, version, total_blocks, num_parts
 PT_HDR_FMT = '<IIII'
 
@@ -53,22 +58,22 @@ def write_block(img, block_idx, data):
 
 def make_partition_table(total_blocks, parts):
     """
-    parts: list of (name_str, start_block, num_blocks)
+    parts: list of (name_str, start_block, num_blocks, data or None)
     Returns bytes for the full nand_pt_t struct.
     """
     header = struct.pack(PT_HDR_FMT, PT_MAGIC, PT_VERSION,
                          total_blocks, len(parts))
     parts_data = b''
-    for name, start, n in parts:
+    for name, start, n, data in parts:
         name_b = (name.encode('ascii') + b'\x00' * 16)[:16]
-        parts_data += struct.pack(PART_FMT, name_b, start, n)
+        size, crc = (len(data), zlib.crc32(data)) if data else (0, 0)
+        parts_data += struct.pack(PART_FMT, name_b, start, n, size, crc)
     # Pad to PT_MAX_PARTS entries
-    empty = struct.pack(PART_FMT, b'\x00' * 16, 0, 0)
+    empty = struct.pack(PART_FMT, b'\x00' * 16, 0, 0, 0, 0)
     parts_data += empty * (PT_MAX_PARTS - len(parts))
 
     body = header + parts_data
-    checksum = sum(body) & 0xFFFFFFFF
-    return body + struct.pack('<I', checksum)
+    return body + struct.pack('<I', zlib.crc32(body))
 
 
 def main():
@@ -83,6 +88,8 @@ def main():
                         help='Kernel image')
     parser.add_argument('--rootfs', metavar='FILE',
                         help='Root filesystem image')
+    parser.add_argument('--sparse', action='store_true',
+                        help='Write an Android sparse image')
     args = parser.parse_args()
 
     img_path = Path(args.image)
@@ -91,13 +98,14 @@ def main():
 
     parts = []
     placements = []   # (label, block, raw_size_bytes)
+    images = []       # (name, data) checked by the bootloader as it loads
 
     with img_path.open('r+b') as img:
         # Bootloader: primary at block 0, redundant at block 1
         boot_data = Path(args.boot).read_bytes()
         write_block(img, BLOCK_BOOT,     boot_data)
         write_block(img, BLOCK_BOOT + 1, boot_data)
-        parts.append(('bootloader', BLOCK_BOOT, 2))
+        parts.append(('bootloader', BLOCK_BOOT, 2, boot_data))
         placements.append((Path(args.boot).name + ' [0]', BLOCK_BOOT,     len(boot_data)))
         placements.append((Path(args.boot).name + ' [1]', BLOCK_BOOT + 1, len(boot_data)))
 
@@ -105,7 +113,8 @@ def main():
         if args.dtb:
             dtb_data = Path(args.dtb).read_bytes()
             write_block(img, BLOCK_DTB, dtb_data)
-            parts.append(('dtb', BLOCK_DTB, nblocks(len(dtb_data))))
+            parts.append(('dtb', BLOCK_DTB, nblocks(len(dtb_data)), dtb_data))
+            images.append(('dtb', dtb_data))
             placements.append((Path(args.dtb).name, BLOCK_DTB, len(dtb_data)))
 
         # Kernel at block 4; always occupies KERNEL_MAX_BLOCKS regardless of actual size
@@ -117,7 +126,8 @@ def main():
                       file=sys.stderr)
                 sys.exit(1)
             write_block(img, BLOCK_KERNEL, kernel_data)
-            parts.append(('kernel', BLOCK_KERNEL, kernel_blks))
+            parts.append(('kernel', BLOCK_KERNEL, kernel_blks, kernel_data))
+            images.append(('kernel', kernel_data))
             placements.append((Path(args.kernel).name, BLOCK_KERNEL, len(kernel_data)))
 
         # Rootfs always starts at BLOCK_ROOTFS (block 68) for a fixed MTD layout
@@ -127,16 +137,23 @@ def main():
             rootfs_data = Path(args.rootfs).read_bytes()
             write_block(img, BLOCK_ROOTFS, rootfs_data)
             rootfs_blks = nblocks(len(rootfs_data))
-            parts.append(('rootfs', BLOCK_ROOTFS, rootfs_blks))
+            parts.append(('rootfs', BLOCK_ROOTFS, rootfs_blks, rootfs_data))
             placements.append((Path(args.rootfs).name, BLOCK_ROOTFS, len(rootfs_data)))
             total_blocks = BLOCK_ROOTFS + rootfs_blks
 
-        # Partition table at block 2 (written last, after total_blocks is known)
-        parts.append(('ptable', BLOCK_PT, 1))
+        # Partition table at block 2 (written last, after total_blocks is known),
+        # image manifest in the same block
+        parts.append(('ptable', BLOCK_PT, 1, None))
         pt_bytes = make_partition_table(total_blocks, parts)
-        write_block(img, BLOCK_PT, pt_bytes)
+        pt_block = pt_bytes.ljust(NAND_OFFSET, b'\xff') + make_manifest(images)
+        write_block(img, BLOCK_PT, pt_block)
         placements.append(('partition table', BLOCK_PT, len(pt_bytes)))
 
+    # Only the written blocks go into a sparse image
+    if args.sparse:
+        write_sparse(img_path, [(blk * BLOCK, nblocks(size) * BLOCK)
+                                for _, blk, size in placements])
+
     # Summary
     placements.sort(key=lambda x: x[1])
     print()
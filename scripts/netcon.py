@@ -0,0 +1,79 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Host side of the bootloader's `netcon` UDP console, for one board or a rack.
+
+Run `netcon <this host's IP as hex>` on each board, then:
+    netcon.py                      print every board's output
+    netcon.py --log logs/          also keep one log file per board
+    netcon.py --to 192.168.1.100   send typed lines to one board only
+
+Output is printed line by line, prefixed with the board's address. Each
+line typed here is sent to every board seen so far (or the --to board) as
+a command, ended with '\r' as the UART console expects. Ctrl-D quits.
+"""
+
+import argparse
+import os
+import select
+import socket
+import sys
+
+PORT = 6666
+
+
+class Board:
+    def __init__(self, addr, logdir):
+        self.addr, self.partial = addr, b''
+        self.log = None
+        if logdir:
+            self.log = open(os.path.join(logdir, f'{addr[0]}.log'), 'ab')
+
+    def feed(self, data):
+        if self.log:
+            self.log.write(data)
+            self.log.flush()
+        lines = (self.partial + data).split(b'\n')
+        self.partial = lines.pop()
+        for line in lines:
+            text = line.rstrip(b'\r').decode('utf-8', 'replace')
+            print(f'{self.addr[0]:>15} | {text}')
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('--port', type=int, default=PORT,
+                    help=f'UDP port to listen on (default {PORT})')
+    ap.add_argument('--to', help='send commands to this board only')
+    ap.add_argument('--log', metavar='DIR', help='write per-board logs here')
+    args = ap.parse_args()
+
+    if args.log:
+        os.makedirs(args.log, exist_ok=True)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('', args.port))
+    boards = {}
+
+    while True:
+        ready, _, _ = select.select([sock, sys.stdin], [], [])
+        if sock in ready:
+            data, addr = sock.recvfrom(2048)
+            if addr not in boards:
+                boards[addr] = Board(addr, args.log)
+            boards[addr].feed(data)
+        if sys.stdin in ready:
+            line = sys.stdin.readline()
+            if not line:
+                break
+            cmd = line.rstrip('\n').encode() + b'\r'
+            if args.to:
+                sock.sendto(cmd, (args.to, PORT))
+            else:
+                for addr in boards:
+                    sock.sendto(cmd, addr)
+
+
+if __name__ == '__main__':
+    main()
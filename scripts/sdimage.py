@@ -4,8 +4,14 @@
 import sys
 from pathlib import Path
 
+from manifest import SD_LBA, make_manifest
+from sparse import write_sparse
+
 SECTOR = 512
 
+# partition names as the bootloader knows them, in MBR order
+PART_NAMES = ["kernel", "dtb", "mbr3", "mbr4"]
+
 # preferred LBAs for binaries
 LBA1 = 128   # always used
 LBA2 = 640   # used if possible
@@ -63,7 +69,8 @@ def create_mbr(img, partitions):
 
 def main():
     if len(sys.argv) < 3:
-        print("Usage: sdimage.py image.img file1 [file2 ...] [--partition part1 ...]")
+        print("Usage: sdimage.py image.img file1 [file2 ...] [--partition part1 ...]"
+              " [--sparse]")
         sys.exit(1)
 
     img_path = Path(sys.argv[1])
@@ -73,10 +80,14 @@ def main():
     files = []
     partitions_args = []
     saw_partition = False
+    sparse = False
 
     i = 0
     while i < len(args):
-        if args[i] == "--partition":
+        if args[i] == "--sparse":
+            sparse = True
+            i += 1
+        elif args[i] == "--partition":
             saw_partition = True
             i += 1
             while i < len(args) and not args[i].startswith("--"):
@@ -98,6 +109,7 @@ def main():
 
     placements = []
     partition_infos = []
+    manifest_images = []
 
     with img_path.open("r+b") as img:
         current_lba = 0
@@ -125,6 +137,9 @@ def main():
             lba = choose_lba(current_lba, current_lba, p.name)  # no preferred LBA yet
             size = write_aligned(img, lba, data)
             current_lba = lba + (size // SECTOR)
+            if len(manifest_images) < len(PART_NAMES):
+                manifest_images.append(
+                    (PART_NAMES[len(manifest_images)], data))
             partition_infos.append({
                 "name": p.name,
                 "lba": lba,
@@ -133,9 +148,20 @@ def main():
                 "boot": False
             })
 
-        # --- write MBR for partitions ---
+        # --- write MBR for partitions, and their digests for the loader ---
         if partition_infos:
             create_mbr(img, partition_infos)
+            write_aligned(img, SD_LBA, make_manifest(manifest_images))
+
+    # --- only the written ranges go into a sparse image ---
+    if sparse:
+        extents = [(lba * SECTOR, size) for _, lba, size in placements]
+        extents += [(p["lba"] * SECTOR, p["sectors"] * SECTOR)
+                    for p in partition_infos]
+        if partition_infos:
+            extents.append((0, SECTOR))
+            extents.append((SD_LBA * SECTOR, SECTOR))
+        write_sparse(img_path, extents)
 
     # --- summary ---
     print("\n{:<25} {:<8} {:<10} {:<8}".format("File", "LBA", "Size", "Blocks"))
@@ -0,0 +1,105 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Android sparse image writer (the format `sparse` and fastboot accept).
+
+Only the parts of an image that were actually written need to be sent:
+everything else becomes a DONT_CARE chunk, which the bootloader skips
+without touching the medium. Blocks that hold a single repeated 32-bit
+word become FILL chunks, the rest RAW.
+
+Standalone use converts a whole raw image (no DONT_CARE ranges):
+    sparse.py raw.img out.simg
+"""
+
+import struct
+import sys
+from pathlib import Path
+
+SPARSE_MAGIC = 0xED26FF3A
+FILE_HDR_SZ  = 28
+CHUNK_HDR_SZ = 12
+BLK_SZ       = 4096
+
+CHUNK_RAW       = 0xCAC1
+CHUNK_FILL      = 0xCAC2
+CHUNK_DONT_CARE = 0xCAC3
+
+
+def fill_word(block):
+    """The 32-bit word block is made of, or None."""
+    word = block[:4]
+    if block == word * (len(block) // 4):
+        return struct.unpack('<I', word)[0]
+    return None
+
+
+def written_blocks(extents, nblk):
+    """Per-block flags from a list of (byte_offset, byte_length)."""
+    used = bytearray(nblk)
+    for off, length in extents:
+        first = off // BLK_SZ
+        last = min(nblk, (off + length + BLK_SZ - 1) // BLK_SZ)
+        for b in range(first, last):
+            used[b] = 1
+    return used
+
+
+def make_sparse(data, extents=None):
+    """Return data as a sparse image. extents lists the (offset, length)
+    byte ranges that were written; None means all of it."""
+    data = bytes(data) + b'\x00' * ((-len(data)) % BLK_SZ)
+    nblk = len(data) // BLK_SZ
+    if extents is None:
+        extents = [(0, len(data))]
+    used = written_blocks(extents, nblk)
+
+    # runs of (kind, fill word, first block, block count)
+    runs = []
+    for b in range(nblk):
+        if not used[b]:
+            kind, word = CHUNK_DONT_CARE, None
+        else:
+            word = fill_word(data[b * BLK_SZ:(b + 1) * BLK_SZ])
+            kind = CHUNK_RAW if word is None else CHUNK_FILL
+        if runs and runs[-1][0] == kind and runs[-1][1] == word:
+            runs[-1][3] += 1
+        else:
+            runs.append([kind, word, b, 1])
+
+    chunks = []
+    for kind, word, first, n in runs:
+        if kind == CHUNK_RAW:
+            body = data[first * BLK_SZ:(first + n) * BLK_SZ]
+        elif kind == CHUNK_FILL:
+            body = struct.pack('<I', word)
+        else:
+            body = b''
+        chunks.append(struct.pack('<HHII', kind, 0, n,
+                                  CHUNK_HDR_SZ + len(body)) + body)
+
+    header = struct.pack('<IHHHHIIII', SPARSE_MAGIC, 1, 0, FILE_HDR_SZ,
+                         CHUNK_HDR_SZ, BLK_SZ, nblk, len(chunks), 0)
+    return header + b''.join(chunks)
+
+
+def write_sparse(path, extents):
+    """Rewrite the raw image at path as a sparse image in place."""
+    path = Path(path)
+    raw_size = path.stat().st_size
+    out = make_sparse(path.read_bytes(), extents)
+    path.write_bytes(out)
+    print(f'sparse: {raw_size} -> {len(out)} bytes')
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("Usage: sparse.py raw.img out.simg")
+        sys.exit(1)
+    out = make_sparse(Path(sys.argv[1]).read_bytes())
+    Path(sys.argv[2]).write_bytes(out)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,103 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Decode the bootloader's binary TRACE() ring against its ELF file.
+
+    tracedump.py build/main.elf bootlog.bin
+
+bootlog.bin is a copy of the 1 MiB ring at 0xDFF00000, e.g. read under
+Linux with `dd if=/dev/mem of=bootlog.bin bs=1M skip=3583 count=1`. The
+records only hold the addresses of their format strings (and of any %s
+arguments); those are looked up in the ELF, which must be the one that
+was running.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = 0x54524331
+HDR = struct.Struct('<8I')
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+CONV = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)'
+                  r'(?:hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+class Elf:
+    """Address-to-bytes map of the ELF's loaded sections."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1:
+            raise ValueError(f'{path}: not a 32-bit ELF file')
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            sh = struct.unpack_from('<10I', data, shoff + i * shentsize)
+            typ, flags, addr, off, size = sh[1], sh[2], sh[3], sh[4], sh[5]
+            if flags & SHF_ALLOC and typ != SHT_NOBITS and size:
+                self.sections.append((addr, data[off:off + size]))
+
+    def string(self, addr):
+        for base, blob in self.sections:
+            if base <= addr < base + len(blob):
+                end = blob.find(b'\0', addr - base)
+                return blob[addr - base:end].decode('utf-8', 'replace')
+        return f'<0x{addr:08x}?>'
+
+
+def format_event(elf, fmt_addr, args):
+    args = iter(args)
+
+    def conv(m):
+        flags, kind = m.group(1), m.group(2)
+        if kind == '%':
+            return '%'
+        a = next(args, 0)
+        if kind == 's':
+            return ('%' + flags + 's') % elf.string(a)
+        if kind == 'p':
+            return f'0x{a:08x}'
+        if kind in 'di' and a & 0x80000000:
+            a -= 1 << 32
+        if kind == 'u':
+            kind = 'd'
+        return ('%' + flags + kind) % a
+
+    return CONV.sub(conv, elf.string(fmt_addr))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('elf', help='bootloader ELF (build/main.elf)')
+    ap.add_argument('dump', help='raw copy of the trace ring')
+    ap.add_argument('-n', type=int, help='only the newest N events')
+    args = ap.parse_args()
+
+    elf = Elf(args.elf)
+    with open(args.dump, 'rb') as f:
+        ring = f.read()
+
+    magic, rec_size, nrec, head, freq = HDR.unpack_from(ring)[:5]
+    if magic != MAGIC or rec_size != 32:
+        sys.exit(f'{args.dump}: no trace ring (magic 0x{magic:08x})')
+    count = min(head, nrec)
+    if args.n is not None:
+        count = min(count, args.n)
+
+    for seq in range(head - count, head):
+        off = HDR.size + (seq % nrec) * rec_size
+        ts_lo, ts_hi, fmt, nargs, *a = struct.unpack_from('<8I', ring, off)
+        t = ((ts_hi << 32) | ts_lo) / freq
+        print(f'[{t:12.6f}] {format_event(elf, fmt, a[:nargs])}')
+    print(f'{count} of {head} events', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -57,30 +57,22 @@ def download(dev, num, data, do_print=False):
     # Response: ACK
     get_ack(dev, " command")
 
-    # Packet number
+    # Packet number, then checksum byte: XOR (byte 3 to byte 6)
     i0 = (num >> 0*8) & 0xff
     i1 = (num >> 1*8) & 0xff
     i2 = (num >> 2*8) & 0xff
-    dev.write_raw(struct.pack("BBBB", 0x00, i2, i1, i0))
-
-    # Checksum byte: XOR (byte 3 to byte 6)
-    dev.write_raw(struct.pack("B", i2 ^ i1 ^ i0))
+    dev.write_raw(struct.pack("BBBBB", 0x00, i2, i1, i0, i2 ^ i1 ^ i0))
 
     # Response: ACK
     get_ack(dev, " packet number")
 
-    # Packet size (0 < N < 255)
-    dev.write_raw(struct.pack("B", len(data) - 1))
-
-    # N-1 data bytes
-    for d in data:
-        dev.write_raw(struct.pack("B", d))
-
-    # Checksum byte: XOR (byte 8 to Last-1)
+    # Packet size (0 < N < 255), N-1 data bytes, and checksum byte: XOR
+    # (byte 8 to Last-1), all in one write
     checksum = len(data) - 1
     for d in data:
         checksum ^= d
-    dev.write_raw(struct.pack("B", checksum))
+    dev.write_raw(struct.pack("B", len(data) - 1) + bytes(data) +
+                  struct.pack("B", checksum))
 
     # Response: ACK
     get_ack(dev, " data")
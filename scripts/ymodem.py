@@ -0,0 +1,153 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Send a file into the board's DDR over the serial console with YMODEM-1K.
+
+    python3 ymodem.py -c COM20 -f build/zImage -a 0xC2000000
+
+With the bootloader at its prompt, this raises the console to --baud
+(default 3 Mbaud) with the `baud` command, runs `ymodem`, sends the file
+in 1024-byte blocks with CRC-16, and sets the console back to 115200 baud.
+Any YMODEM sender (`sb`, Tera Term) works with the `ymodem` command too;
+this one just writes each block in one go and skips the manual steps.
+"""
+
+import argparse
+import binascii
+import os
+import time
+
+import pyvisa
+
+SOH = 0x01
+STX = 0x02
+EOT = 0x04
+ACK = 0x06
+NAK = 0x15
+CAN = 0x18
+CRC = ord('C')
+
+RETRIES = 10
+
+
+def block(num, data, size):
+    data = data.ljust(size, b'\x1a' if num else b'\0')
+    num &= 0xFF
+    head = bytes([STX if size == 1024 else SOH, num, 0xFF - num])
+    return head + data + binascii.crc_hqx(data, 0).to_bytes(2, 'big')
+
+
+def read_byte(dev):
+    try:
+        return dev.read_bytes(1)[0]
+    except pyvisa.errors.VisaIOError:
+        return None
+
+
+def read_until(dev, text, timeout):
+    got = b''
+    t_end = time.monotonic() + timeout
+    while text not in got:
+        if time.monotonic() > t_end:
+            raise RuntimeError(f'no {text!r} from the board, got {got!r}')
+        b = read_byte(dev)
+        if b is not None:
+            got += bytes([b])
+    return got
+
+
+def wait_for(dev, wanted, timeout=10):
+    t_end = time.monotonic() + timeout
+    while time.monotonic() < t_end:
+        b = read_byte(dev)
+        if b in wanted:
+            return b
+        if b == CAN:
+            raise RuntimeError('board cancelled the transfer')
+    raise RuntimeError('timeout waiting for the board')
+
+
+def send_block(dev, blk):
+    for _ in range(RETRIES):
+        dev.write_raw(blk)
+        r = wait_for(dev, (ACK, NAK))
+        if r == ACK:
+            return
+    raise RuntimeError('too many retries')
+
+
+def send_file(dev, name, data):
+    wait_for(dev, (CRC,))
+    header = name.encode() + b'\0' + str(len(data)).encode()
+    send_block(dev, block(0, header, 128))
+    wait_for(dev, (CRC,))
+
+    t0 = time.monotonic()
+    off, num = 0, 1
+    while off < len(data):
+        size = 1024 if len(data) - off > 128 else 128
+        send_block(dev, block(num, data[off:off + size], size))
+        off, num = off + size, num + 1
+        if num % 64 == 0:
+            print(f'\r{off >> 10} KiB', end='', flush=True)
+    dt = time.monotonic() - t0
+
+    dev.write_raw(bytes([EOT]))
+    wait_for(dev, (ACK,))
+    wait_for(dev, (CRC,))
+    send_block(dev, block(0, b'', 128))
+    print(f'\r{len(data)} bytes in {dt:.2f} s, '
+          f'{len(data) / dt / 1e3 if dt else 0:.0f} kB/s')
+
+
+def set_baud(dev, baud):
+    dev.write_raw(f'baud {baud}\r'.encode())
+    read_until(dev, b'baud\r\n', 2)
+    dev.baud_rate = baud
+    time.sleep(0.05)
+    read_until(dev, b'dropped\r\n', 2)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    ap.add_argument('-c', '--com_port', required=True, help='serial port')
+    ap.add_argument('-f', '--file', required=True, help='file to send')
+    ap.add_argument('-a', '--addr', type=lambda s: int(s, 0),
+                    help='DDR address (default the download buffer)')
+    ap.add_argument('-b', '--baud', type=int, default=3000000,
+                    help='transfer baud rate (default 3000000)')
+    ap.add_argument('--stay', action='store_true',
+                    help='leave the console at the transfer baud rate')
+    args = ap.parse_args()
+
+    with open(args.file, 'rb') as f:
+        data = f.read()
+
+    rm = pyvisa.ResourceManager()
+    with rm.open_resource(args.com_port) as dev:
+        dev.baud_rate = 115200
+        dev.parity = pyvisa.constants.Parity.none
+        dev.stop_bits = pyvisa.constants.StopBits.one
+        dev.read_termination = None
+        dev.timeout = 200
+
+        # clear the read buffer
+        while read_byte(dev) is not None:
+            pass
+
+        if args.baud != 115200:
+            set_baud(dev, args.baud)
+        cmd = 'ymodem' if args.addr is None else f'ymodem {args.addr:#x}'
+        dev.write_raw(f'{cmd}\r'.encode())
+        read_until(dev, b'send a file now', 2)
+        read_until(dev, b'\r\n', 2)
+        send_file(dev, os.path.basename(args.file), data)
+        read_until(dev, b'ymodem: ', 5)
+        print(read_until(dev, b'\r\n', 1).decode(errors='replace').strip())
+        if args.baud != 115200 and not args.stay:
+            set_baud(dev, 115200)
+
+
+if __name__ == '__main__':
+    main()
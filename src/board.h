@@ -258,7 +258,6 @@
 #define FMC_PLANE_SIZE_BLOCKS 1024U
 #define FMC_PLANE_NBR         2U
 #define FMC_SECTOR_SIZE       512U
-#define FMC_SCRATCH_ADDR      DEF_DDR_BASE
 
 #else
 
@@ -514,7 +513,6 @@
 #define FMC_PLANE_SIZE_BLOCKS 1024U
 #define FMC_PLANE_NBR         2U
 #define FMC_SECTOR_SIZE       512U
-#define FMC_SCRATCH_ADDR      DEF_DDR_BASE
 
 #endif
 
@@ -8,9 +8,13 @@
  */
 
 #include "boot.h"
+#include "console.h"
+#include "ddr_map.h"
 #include "defaults.h"
+#include "dtb.h"
 #include "printf.h"
 #include "stm32mp135fxx_ca7.h"
+#include "trace.h"
 #include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -41,7 +45,16 @@ void boot_jump(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    if ((argc == 1) && (arg1 >= DRAM_MEM_BASE))
       addr = arg1;
 
+   /* Hand the regions Linux must leave alone, such as the event log, on
+    * as reserved-memory; quietly skipped when no DTB was loaded. */
+   TRACE("boot: jump to 0x%08lx", addr);
+   const struct ddr_region *g;
+   for (uint32_t i = 0U; (g = ddr_map_get(i)) != NULL; i++)
+      if (g->flags & DDR_MAP_KEEP)
+         (void)dtb_reserve(g->name, g->addr, g->size);
+
    my_printf("Jumping to address 0x%" PRIX32 "...\r\n", addr);
+   uart_flush();
 
    // Disable IRQ and FIQ
    __asm volatile("cpsid if\n" ::: "memory");
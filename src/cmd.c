@@ -11,15 +11,30 @@
 #include "board.h"
 #include "boot.h"
 #include "console.h"
+#include "crc.h"
 #include "ddr.h"
+#include "ddr_bench.h"
+#include "ddr_map.h"
+#include "ddr_qos.h"
 #include "defaults.h"
 #include "diag.h"
 #include "eth.h"
+#include "eth_bench.h"
+#include "ethload.h"
+#include "flash.h"
 #include "fmc.h"
+#include "hash.h"
+#include "memtest.h"
+#include "net.h"
+#include "netcon.h"
 #include "printf.h"
 #include "stm32mp13xx_hal.h"
 #include "setup.h"
 #include "stm32mp135fxx_ca7.h"
+#include "tftp.h"
+#include "trace.h"
+#include "warm.h"
+#include "ymodem.h"
 #include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -34,6 +49,11 @@
 #include "lcd.h"
 #endif
 
+/* Seconds autoboot waits for a key to stop it. */
+#ifndef BOOT_TIMEOUT
+#define BOOT_TIMEOUT 3
+#endif
+
 #define CMD_MAX_LEN  32
 #define HISTORY_SIZE 8
 
@@ -139,6 +159,51 @@ static const struct cmd cmd_list[] = {
      .handler      = ddr_align_test,
      },
 
+    {
+     .name         = "ddr_bench",
+     .syntax       = "[mib]",
+     .summary      = "Measure DDR bandwidth and latency",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = ddr_bench_cmd,
+     },
+
+    {
+     .name         = "ddr_qos",
+     .syntax       = "[reg [val]]",
+     .summary      = "Show or set DDR scheduler/QoS registers",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = ddr_qos_cmd,
+     },
+
+    {
+     .name         = "ddr_qos_sweep",
+     .syntax       = "[mib [blocks]]",
+     .summary      = "Benchmark DDR under each QoS variation",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = ddr_qos_sweep_cmd,
+     },
+
+    {
+     .name         = "memtest",
+     .syntax       = "[tests [skip]]",
+     .summary      = "Test DDR (bus, March C-, PRBS)",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = memtest_cmd,
+     },
+
+    {
+     .name         = "ddr_map",
+     .syntax       = "",
+     .summary      = "List the DDR regions in use",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = ddr_map_cmd,
+     },
+
 #ifdef LCD_DISPLAY
     {
      .name         = "backlight",
@@ -169,6 +234,15 @@ static const struct cmd cmd_list[] = {
      },
 
 #ifdef ETHERNET
+    {
+     .name         = "eth_bench",
+     .syntax       = "[mode [size [n]]]",
+     .summary      = "Ethernet benchmark (0 TX, 1 RX, 2 ping, 3 echo)",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = eth_bench_cmd,
+     },
+
     {
      .name         = "send_frame",
      .syntax       = "",
@@ -177,6 +251,60 @@ static const struct cmd cmd_list[] = {
      .num_defaults = 0,
      .handler      = eth_send_test_frame,
      },
+
+    {
+     .name         = "ip",
+     .syntax       = "[addr [mask [gateway]]]",
+     .summary      = "Show or set the IPv4 configuration",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = net_ip_cmd,
+     },
+
+    {
+     .name         = "dhcp",
+     .syntax       = "",
+     .summary      = "Configure IPv4 with DHCP",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = net_dhcp_cmd,
+     },
+
+    {
+     .name         = "tftp",
+     .syntax       = "[server]",
+     .summary      = "Load kernel and DTB over TFTP",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = tftp_cmd,
+     },
+
+    {
+     .name         = "netcon",
+     .syntax       = "[ip [port]]",
+     .summary      = "Console over UDP to a host (ip 0: off)",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = netcon_cmd,
+     },
+
+    {
+     .name         = "ethload",
+     .syntax       = "[addr [max]]",
+     .summary      = "Receive an image over raw Ethernet",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = ethload_cmd,
+     },
+
+    {
+     .name         = "mcload",
+     .syntax       = "[write [addr [max]]]",
+     .summary      = "Receive a multicast image (write 1: and flash it)",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = mcload_cmd,
+     },
 #endif
 
 #ifndef NAND_FLASH
@@ -190,6 +318,15 @@ static const struct cmd cmd_list[] = {
      },
 #endif
 
+    {
+     .name         = "sparse",
+     .syntax       = "[src_addr [start_block]]",
+     .summary      = "Expand sparse image from DDR to SD/NAND",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = flash_sparse_cmd,
+     },
+
     {
      .name         = "lse_init",
      .syntax       = "",
@@ -199,6 +336,51 @@ static const struct cmd cmd_list[] = {
      .handler      = lse_init,
      },
 
+    {
+     .name         = "ymodem",
+     .syntax       = "[addr [max]]",
+     .summary      = "Receive a file into DDR with YMODEM",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = ymodem_cmd,
+     },
+
+    {
+     .name         = "baud",
+     .syntax       = "[rate [policy]]",
+     .summary      = "Console baud rate and TX overflow policy",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = uart_baud_cmd,
+     },
+
+    {
+     .name         = "sha256",
+     .syntax       = "addr len",
+     .summary      = "SHA-256 of a memory range on the HASH peripheral",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = sha256_cmd,
+     },
+
+    {
+     .name         = "crc32",
+     .syntax       = "addr len [c]",
+     .summary      = "CRC-32 (CRC-32C if c) of a memory range",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = crc32_cmd,
+     },
+
+    {
+     .name         = "trace",
+     .syntax       = "[n]",
+     .summary      = "Print the newest n logged events (0 clears)",
+     .defaults     = NULL,
+     .num_defaults = 0,
+     .handler      = trace_cmd,
+     },
+
 #ifdef NAND_FLASH
     {
      .name         = "fmc_erase",
@@ -230,7 +412,7 @@ static const struct cmd cmd_list[] = {
     {
      .name         = "fmc_load",
      .syntax       = "[n_blocks]",
-     .summary      = "Read NAND into DDR buffer",
+     .summary      = "Reload DDR buffer from NAND (drops unflushed writes)",
      .defaults     = NULL,
      .num_defaults = 0,
      .handler      = fmc_load,
@@ -320,29 +502,77 @@ static void line_erase(void)
    cmd_prompt();
 }
 
-void cmd_autoboot(void)
+/* Set once a key stops autoboot. */
+static int boot_stopped;
+
+/* Handed to the image loaders, which call it while their DMA runs: keeps
+ * the network going and notes a key press.  The key itself stays in the
+ * console buffer for cmd_poll. */
+static int boot_poll(void)
 {
+   eth_poll();
 #ifndef BOOT_NOPROMPT
-   my_printf("Press any key to stop autoload ");
-   int boot_ticks = 10000000;
-   while (boot_ticks > 0) {
-      if (boot_ticks % 1000000 == 0)
-         my_printf(".");
-      cmd_poll();
-      if (console_key_pressed()) {
-         my_printf("\n");
-         line_erase();
-         return;
+   if (console_key_pressed())
+      boot_stopped = 1;
+#endif
+   return boot_stopped;
+}
+
+/* Wait until BOOT_TIMEOUT seconds after start, a dot for each second
+ * waited; returns nonzero if a key stops the countdown. */
+static int boot_countdown(uint32_t start)
+{
+#ifdef BOOT_NOPROMPT
+   (void)start;
+   return boot_poll();
+#else
+   const uint32_t first = (HAL_GetTick() - start) / 1000U;
+   uint32_t shown       = first;
+   while (!boot_poll()) {
+      const uint32_t s = (HAL_GetTick() - start) / 1000U;
+      if (s >= BOOT_TIMEOUT) {
+         if (shown != first)
+            my_printf("\r\n");
+         return 0;
       }
-      boot_ticks--;
+      for (; shown < s; shown++)
+         my_printf(".");
    }
+   return 1;
+#endif
+}
+
+void cmd_autoboot(void)
+{
+   const uint32_t start = HAL_GetTick();
+#ifndef BOOT_NOPROMPT
+   my_printf("Press any key to stop autoload\r\n");
+#endif
+#ifdef NETBOOT
+   if (boot_countdown(start) == 0 && tftp_load_two(0) == 0)
+      boot_jump(1, DEF_LINUX_ADDR, 0, 0);
+   if (!boot_stopped)
+      my_printf("Netboot failed, booting from storage\r\n");
+#endif
+   /* The images load during the countdown, which may end first. */
+   int loaded = -1;
+   if (!boot_stopped) {
 #ifdef NAND_FLASH
-   fmc_bload(0, 0, 0, 0);
+      loaded = fmc_load_images(boot_poll);
 #else
-   sd_load_mbr(0, 0, 0, 0);
-#endif
-   boot_jump(1, DEF_LINUX_ADDR, 0, 0);
+      loaded = sd_load_images(boot_poll);
 #endif
+   }
+   if (!boot_stopped && boot_countdown(start) == 0) {
+      if (loaded == 0)
+         boot_jump(1, DEF_LINUX_ADDR, 0, 0);
+      /* Recovery: stay here, where USB and the console can reflash. */
+      my_printf("Boot images bad or missing, not booting\r\n");
+      return;
+   }
+   cmd_poll();
+   my_printf("\n");
+   line_erase();
 }
 
 static void line_load(const char *src)
@@ -671,17 +901,7 @@ void cmd_reset(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    (void)arg3;
 
    my_printf("System reset requested...\r\n");
-
-   /* Ensure previous writes complete */
-   __asm__ volatile("dsb sy"); // data synchronization barrier
-
-   /* Trigger a reset: set SYSRESETREQ via RCC MP_GRSTCSETR */
-   RCC->MP_GRSTCSETR = RCC_MP_GRSTCSETR_MPSYSRST; // reset entire system
-
-   /* Wait indefinitely for reset to occur */
-   while (1) {
-      __asm__ volatile("wfe"); // wait for event (low-power idle)
-   }
+   warm_reset();
 }
 
 // end file cmd.c
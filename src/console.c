@@ -2,32 +2,44 @@
 
 /**
  * @file console.c
- * @brief UART receive buffer and interrupt flag
+ * @brief UART receive and transmit buffers and interrupt flag
  * @author Jakob Kastelic
  * @copyright 2026 Jakob Kastelic
  */
 
 #include "console.h"
+#include "irq.h"
 #include "printf.h"
+#include "stm32mp135fxx_ca7.h"
 #include <stdint.h>
 
-#define RXBUF_SIZE 64U
+#define RXBUF_SIZE 2048U /* a whole YMODEM block */
+#define TXBUF_SIZE 4096U
 
 static volatile uint8_t rx_buf[RXBUF_SIZE];
-static volatile uint8_t rx_head = 0;
-static volatile uint8_t rx_tail = 0;
+static volatile uint32_t rx_head = 0;
+static volatile uint32_t rx_tail = 0;
 
 static volatile int interrupt_flag = 0;
 static volatile int key_flag       = 0;
+static volatile int raw            = 0;
+
+/* Output ring: uart_write_char() appends at tx_head, the TXE interrupt
+ * drains from tx_tail. */
+static volatile uint8_t tx_buf[TXBUF_SIZE];
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static enum uart_tx_policy tx_policy = UART_TX_BLOCK;
+static uint32_t tx_dropped;
 
 void console_push(char c)
 {
-   if (c == 0x03) {
+   if (c == 0x03 && !raw) {
       interrupt_flag = 1;
       my_printf("^C\r\n");
       return;
    }
-   uint8_t next = (rx_head + 1U) % RXBUF_SIZE;
+   const uint32_t next = (rx_head + 1U) % RXBUF_SIZE;
    if (next != rx_tail) {
       rx_buf[rx_head] = (uint8_t)c;
       rx_head         = next;
@@ -58,6 +70,11 @@ int console_rx_empty(void)
    return rx_tail == rx_head;
 }
 
+void console_set_raw(int on)
+{
+   raw = on;
+}
+
 char console_rx_get(void)
 {
    char c  = (char)rx_buf[rx_tail];
@@ -65,4 +82,95 @@ char console_rx_get(void)
    return c;
 }
 
+/* The ring is shared with anything that prints from an interrupt handler
+ * (console_push() echoes ^C), so it is only touched with IRQs masked. */
+
+/* Send the oldest character by polling, whatever the context.  Call with
+ * IRQs masked and the ring not empty. */
+static void tx_drain_one(void)
+{
+   while (!(UART4->ISR & USART_ISR_TXE)) {
+      /* busy wait */
+   }
+   UART4->TDR = tx_buf[tx_tail];
+   tx_tail    = (tx_tail + 1U) % TXBUF_SIZE;
+}
+
+static void tx_put(char ch, enum uart_tx_policy policy)
+{
+   const uint32_t cpsr = irq_save();
+   const uint32_t next = (tx_head + 1U) % TXBUF_SIZE;
+   if (next == tx_tail) {
+      if (policy == UART_TX_DROP) {
+         tx_dropped++;
+         irq_restore(cpsr);
+         return;
+      }
+      if (policy == UART_TX_BLOCK) {
+         tx_drain_one();
+      } else {
+         tx_tail = (tx_tail + 1U) % TXBUF_SIZE;
+         tx_dropped++;
+      }
+   }
+   tx_buf[tx_head] = (uint8_t)ch;
+   tx_head         = next;
+   UART4->CR1 |= USART_CR1_TXEIE;
+   irq_restore(cpsr);
+}
+
+void uart_write_char(char ch)
+{
+   tx_put(ch, tx_policy);
+}
+
+void uart_mirror_char(char ch)
+{
+   /* Never wait: when another console carries the output, UART4 only gets
+    * the characters it has room for. */
+   tx_put(ch, UART_TX_DROP);
+}
+
+void uart_tx_irq(void)
+{
+   /* TXE reads as "TX FIFO not full" with the FIFO enabled. */
+   while (UART4->ISR & USART_ISR_TXE) {
+      if (tx_head == tx_tail) {
+         UART4->CR1 &= ~USART_CR1_TXEIE;
+         return;
+      }
+      UART4->TDR = tx_buf[tx_tail];
+      tx_tail    = (tx_tail + 1U) % TXBUF_SIZE;
+   }
+}
+
+void uart_flush(void)
+{
+   if (!(UART4->CR1 & USART_CR1_UE))
+      return; /* not set up yet */
+   const uint32_t cpsr = irq_save();
+   while (tx_head != tx_tail)
+      tx_drain_one();
+   UART4->CR1 &= ~USART_CR1_TXEIE;
+   while (!(UART4->ISR & USART_ISR_TC)) {
+      /* busy wait */
+   }
+   irq_restore(cpsr);
+}
+
+void uart_set_tx_policy(enum uart_tx_policy policy)
+{
+   tx_policy = policy;
+}
+
+enum uart_tx_policy uart_get_tx_policy(void)
+{
+   return tx_policy;
+}
+
+uint32_t uart_tx_dropped(void)
+{
+   return tx_dropped;
+}
+
 // end file console.c
@@ -2,12 +2,12 @@
 
 /**
  * @file console.h
- * @brief UART receive buffer and interrupt flag
+ * @brief UART receive and transmit buffers and interrupt flag
  * @author Jakob Kastelic
  * @copyright 2026 Jakob Kastelic
  *
  * This module sits below the command interpreter.  It owns the character
- * ring buffer and the Ctrl-C interrupt flag so that:
+ * ring buffers and the Ctrl-C interrupt flag so that:
  *   - setup.c (UART IRQ) can push characters without depending on cmd.h
  *   - fmc.c (long operations) can check for interruption without depending
  *     on cmd.h
@@ -17,6 +17,15 @@
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
+#include <stdint.h>
+
+/* What uart_write_char() does when the TX ring is full. */
+enum uart_tx_policy {
+   UART_TX_BLOCK,     /* send the oldest character by polling, then queue */
+   UART_TX_DROP,      /* discard the new character */
+   UART_TX_OVERWRITE, /* discard the oldest character */
+};
+
 /* Feed one received character into the ring buffer.
  * Ctrl-C (0x03) sets the interrupt flag instead of enqueuing. */
 void console_push(char c);
@@ -31,10 +40,34 @@ int console_key_pressed(void);
 /* Return 1 if the ring buffer has no pending characters. */
 int console_rx_empty(void);
 
+/* Raw mode, for binary transfers: Ctrl-C is queued like any other byte. */
+void console_set_raw(int on);
+
 /* Remove and return the next character from the ring buffer.
  * Undefined behaviour if console_rx_empty() is true. */
 char console_rx_get(void);
 
+/* my_printf output for UART4: queue one character for the TXE interrupt to
+ * send, so printing costs no character times until the 4 KiB ring fills. */
+void uart_write_char(char ch);
+
+/* Queue one output character to UART4 if there is room; for consoles other
+ * than the UART (usb_acm.c, netcon.c) that mirror their output. */
+void uart_mirror_char(char ch);
+
+/* UART4 TXE interrupt: send the next queued character. */
+void uart_tx_irq(void);
+
+/* Send everything queued and wait until it is on the wire; before a jump,
+ * reset or baud rate change, and usable with IRQs masked. */
+void uart_flush(void);
+
+void uart_set_tx_policy(enum uart_tx_policy policy);
+enum uart_tx_policy uart_get_tx_policy(void);
+
+/* Characters discarded on a full ring so far. */
+uint32_t uart_tx_dropped(void);
+
 #endif // CONSOLE_H
 
 // end file console.h
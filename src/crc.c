@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file crc.c
+ * @brief CRC-32 and CRC-32C on the CRC peripheral
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "crc.h"
+#include "irq.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_mdma.h"
+#include "stm32mp13xx_hal_rcc.h"
+#include <stdint.h>
+#include <string.h>
+
+#define CRC_DMA_BLOCK  512U
+#define CRC_DMA_MAX    (4095U * CRC_DMA_BLOCK) /* BlockCount limit */
+#define CRC_TIMEOUT_MS 1000U
+
+/* Polynomial as the unit takes it, and bit-reversed for the table. */
+static const uint32_t poly_hw[]  = {[CRC_32] = 0x04C11DB7U,
+                                    [CRC_32C] = 0x1EDC6F41U};
+static const uint32_t poly_rev[] = {[CRC_32] = 0xEDB88320U,
+                                    [CRC_32C] = 0x82F63B78U};
+
+/* The CRC unit has no request line, so its channel runs on a software
+ * request. */
+static MDMA_HandleTypeDef hmdma_crc;
+static int dma_ready;
+static int dma_busy;
+
+static enum crc_poly poly;
+static uint32_t state; /* reflected, before the final XOR */
+static int hw_on;      /* the unit holds the state, not the variable */
+
+/* What the last feed left for the CPU: the bytes after its DMA part. */
+static const uint8_t *cpu_p;
+static uint32_t cpu_n;
+
+static uint32_t table[256];
+static int table_poly = -1;
+
+static uint32_t sw_update(uint32_t c, const uint8_t *p, uint32_t n)
+{
+   if (table_poly != (int)poly) {
+      for (uint32_t i = 0; i < 256U; i++) {
+         uint32_t v = i;
+         for (int k = 0; k < 8; k++)
+            v = (v >> 1) ^ ((v & 1U) ? poly_rev[poly] : 0U);
+         table[i] = v;
+      }
+      table_poly = (int)poly;
+   }
+   while (n-- > 0U)
+      c = table[(c ^ *p++) & 0xFFU] ^ (c >> 8);
+   return c;
+}
+
+static HAL_StatusTypeDef dma_init(void)
+{
+   hmdma_crc.Instance                      = MDMA_CH_CRC;
+   hmdma_crc.Init.Request                  = MDMA_REQUEST_SW;
+   hmdma_crc.Init.TransferTriggerMode      = MDMA_FULL_TRANSFER;
+   hmdma_crc.Init.Priority                 = MDMA_PRIORITY_MEDIUM;
+   hmdma_crc.Init.SecureMode               = MDMA_SECURE_MODE_DISABLE;
+   hmdma_crc.Init.Endianness               = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+   hmdma_crc.Init.SourceInc                = MDMA_SRC_INC_WORD;
+   hmdma_crc.Init.DestinationInc           = MDMA_DEST_INC_DISABLE;
+   hmdma_crc.Init.SourceDataSize           = MDMA_SRC_DATASIZE_WORD;
+   hmdma_crc.Init.DestDataSize             = MDMA_DEST_DATASIZE_WORD;
+   hmdma_crc.Init.DataAlignment            = MDMA_DATAALIGN_PACKENABLE;
+   hmdma_crc.Init.BufferTransferLength     = 128U;
+   hmdma_crc.Init.SourceBurst              = MDMA_SOURCE_BURST_SINGLE;
+   hmdma_crc.Init.DestBurst                = MDMA_DEST_BURST_SINGLE;
+   hmdma_crc.Init.SourceBlockAddressOffset = 0;
+   hmdma_crc.Init.DestBlockAddressOffset   = 0;
+   return HAL_MDMA_Init(&hmdma_crc);
+}
+
+void crc_start(enum crc_poly p)
+{
+   __HAL_RCC_CRC1_CLK_ENABLE();
+   __HAL_RCC_MDMA_CLK_ENABLE();
+   if (!dma_ready && dma_init() == HAL_OK)
+      dma_ready = 1;
+   if (dma_busy)
+      (void)HAL_MDMA_Abort(&hmdma_crc);
+   dma_busy = 0;
+   cpu_n    = 0U;
+   hw_on    = 0;
+   poly     = p;
+   state    = 0xFFFFFFFFU;
+   CRC1->POL = poly_hw[p];
+}
+
+/* Let the running transfer finish, write the whole words it left, and
+ * take the state back for the odd bytes. */
+static int drain(void)
+{
+   if (dma_busy) {
+      dma_busy = 0;
+      const HAL_StatusTypeDef r = HAL_MDMA_PollForTransfer(
+          &hmdma_crc, HAL_MDMA_FULL_TRANSFER, CRC_TIMEOUT_MS);
+      if (r != HAL_OK) {
+         (void)HAL_MDMA_Abort(&hmdma_crc);
+         hw_on = 0;
+         cpu_n = 0U;
+         return -1;
+      }
+   }
+   if (hw_on) {
+      for (; cpu_n >= 4U; cpu_n -= 4U, cpu_p += 4U) {
+         uint32_t w;
+         memcpy(&w, cpu_p, sizeof(w));
+         CRC1->DR = w;
+      }
+      state = CRC1->DR;
+      hw_on = 0;
+   }
+   state = sw_update(state, cpu_p, cpu_n);
+   cpu_n = 0U;
+   return 0;
+}
+
+static int dma_start(const uint8_t *p, uint32_t n)
+{
+   if (HAL_MDMA_Start(&hmdma_crc, (uint32_t)p, (uint32_t)&CRC1->DR,
+                      CRC_DMA_BLOCK, n / CRC_DMA_BLOCK) != HAL_OK)
+      return -1;
+   dma_busy = 1;
+   return 0;
+}
+
+int crc_feed(const void *buf, uint32_t len)
+{
+   if (drain() != 0)
+      return -1;
+
+   /* The unit works on whole words, so bring p to a word boundary. */
+   const uint8_t *p  = (const uint8_t *)buf;
+   const uint32_t hd = (uint32_t)(-(uintptr_t)p) % 4U;
+   if (len < 4U + hd) {
+      state = sw_update(state, p, len);
+      return 0;
+   }
+   state = sw_update(state, p, hd);
+   p += hd;
+   len -= hd;
+
+   /* Words go in bit-reversed and the result comes out so, which is the
+    * reflected CRC; INIT is in the unit's unreflected order. */
+   CRC1->INIT = __RBIT(state);
+   CRC1->CR   = CRC_CR_REV_IN | CRC_CR_REV_OUT;
+   CRC1->CR |= CRC_CR_RESET;
+   hw_on = 1;
+
+   uint32_t dma_n = 0U;
+   if (dma_ready) {
+      /* MDMA reads DDR, not the cache. */
+      L1C_CleanDCacheAll();
+      dma_n = len - (len % CRC_DMA_BLOCK);
+   }
+   while (dma_n > CRC_DMA_MAX) {
+      if (dma_start(p, CRC_DMA_MAX) != 0 || drain() != 0)
+         return -1;
+      /* drain() took the state back; hand it to the unit again */
+      CRC1->INIT = __RBIT(state);
+      CRC1->CR |= CRC_CR_RESET;
+      hw_on = 1;
+      p += CRC_DMA_MAX;
+      len -= CRC_DMA_MAX;
+      dma_n -= CRC_DMA_MAX;
+   }
+   if (dma_n != 0U && dma_start(p, dma_n) != 0)
+      dma_n = 0U; /* the CPU writes it all instead */
+   cpu_p = p + dma_n;
+   cpu_n = len - dma_n;
+   return 0;
+}
+
+int crc_finish(uint32_t *crc)
+{
+   if (drain() != 0)
+      return -1;
+   *crc = ~state;
+   return 0;
+}
+
+static uint32_t crc_once(enum crc_poly p, const void *buf, uint32_t len)
+{
+   uint32_t c;
+   crc_start(p);
+   if (crc_feed(buf, len) == 0 && crc_finish(&c) == 0)
+      return c;
+   return ~sw_update(0xFFFFFFFFU, (const uint8_t *)buf, len);
+}
+
+uint32_t crc32(const void *buf, uint32_t len)
+{
+   return crc_once(CRC_32, buf, len);
+}
+
+uint32_t crc32c(const void *buf, uint32_t len)
+{
+   return crc_once(CRC_32C, buf, len);
+}
+
+void crc32_cmd(int argc, uint32_t addr, uint32_t len, uint32_t c)
+{
+   if (argc < 2) {
+      my_printf("usage: crc32 addr len [c]\r\n");
+      return;
+   }
+
+   const uint32_t t0 = HAL_GetTick();
+   const uint32_t v  = (argc >= 3 && c != 0U) ? crc32c((const void *)addr, len)
+                                              : crc32((const void *)addr, len);
+   const uint32_t ms = HAL_GetTick() - t0;
+   /* bytes per ms is kB/s */
+   my_printf("%08lx  (%lu ms, %lu kB/s)\r\n", (unsigned long)v,
+             (unsigned long)ms, (unsigned long)((ms != 0U) ? len / ms : 0U));
+}
+
+// end file crc.c
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file crc.h
+ * @brief CRC-32 and CRC-32C on the CRC peripheral
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Both are the reflected, all-ones init and final XOR variants, so crc32()
+ * matches zlib.crc32() and crc32c() matches iSCSI/ext4.  As with hash.h,
+ * crc_feed() leaves MDMA writing the chunk into the CRC unit while the
+ * caller reads the next one; a chunk must stay untouched until the next
+ * crc call.  The few unaligned bytes at either end of a chunk go through a
+ * table on the CPU.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+
+enum crc_poly {
+   CRC_32,  /* 0x04C11DB7, Ethernet/zlib */
+   CRC_32C, /* 0x1EDC6F41, Castagnoli */
+};
+
+/* Start a new CRC. */
+void crc_start(enum crc_poly poly);
+
+/* Add len bytes at buf, returning while the transfer runs.  Returns 0, or
+ * -1 on a DMA error. */
+int crc_feed(const void *buf, uint32_t len);
+
+/* Wait for the data fed so far and store the CRC.  Returns 0, or -1 if
+ * the transfer did not finish. */
+int crc_finish(uint32_t *crc);
+
+/* CRC of one buffer, computed on the CPU alone if the DMA fails. */
+uint32_t crc32(const void *buf, uint32_t len);
+uint32_t crc32c(const void *buf, uint32_t len);
+
+/* crc32 addr len [c]: print the CRC-32 (CRC-32C if c is nonzero) of a
+ * memory range. */
+void crc32_cmd(int argc, uint32_t addr, uint32_t len, uint32_t c);
+
+#endif // CRC_H
+
+// end file crc.h
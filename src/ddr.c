@@ -9,9 +9,12 @@
 
 #include "ddr.h"
 #include "board.h"
+#include "crc.h"
 #include "debug.h"
+#include "dma.h"
 #include "defaults.h"
 #include "printf.h"
+#include "warm.h"
 
 #if DEF_INITRD_END > DEF_DDR_BASE + DDR_MEM_SIZE
 #error "DEF_INITRD_END exceeds DDR"
@@ -22,14 +25,87 @@
 #if DEF_INITRD_ADDR < FMC_DDR_BUF_ADDR + FMC_DDR_BUF_SIZE
 #error "DEF_INITRD_ADDR overlaps USB MSC DDR buffer"
 #endif
+#if DEF_RAMDISK_ADDR + DEF_RAMDISK_SIZE > FMC_DDR_BUF_ADDR
+#error "RAM disk overlaps USB MSC DDR buffer"
+#endif
+#if DEF_FASTBOOT_ADDR + DEF_FASTBOOT_SIZE > DEF_DDR_BASE + DDR_MEM_SIZE
+#error "fastboot download buffer exceeds DDR"
+#endif
+#if DEF_TRACE_ADDR + DEF_TRACE_SIZE > DEF_DDR_BASE + DDR_MEM_SIZE
+#error "trace ring exceeds DDR"
+#endif
+#if DEF_TRACE_ADDR < DEF_INITRD_END ||                                         \
+    DEF_TRACE_ADDR < DEF_FASTBOOT_ADDR + DEF_FASTBOOT_SIZE
+#error "trace ring overlaps the initrd or the download buffer"
+#endif
 #include "stm32mp135fxx_ca7.h"
 #include "stm32mp13xx_hal_ddr.h"
 #include "stm32mp13xx_hal_def.h"
 #include "stm32mp13xx_hal_rcc.h"
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
+#define TRAIN_MAGIC      0x54524E44U /* "TRND" */
+#define TRAIN_CHECK_SIZE 0x10000U    /* bytes tested after a restore */
+
+/* PHY results of the last full DQS training, in backup SRAM. */
+struct ddr_train {
+   uint32_t magic;
+   uint32_t key; /* CRC-32 of phy_config when trained */
+   uint32_t regs[HAL_DDR_TRAINED_REGS];
+   uint32_t crc; /* CRC-32 of all preceding bytes */
+};
+
+static struct ddr_train *const train = (struct ddr_train *)DEF_BKP_TRAIN_ADDR;
+
+/* What the training depends on: changing any of it retrains. */
+static const uint32_t phy_config[] = {
+    DDR_MEM_SPEED, DDR_PGCR,  DDR_ACIOCR, DDR_DXCCR, DDR_DSGCR,
+    DDR_DCR,       DDR_ODTCR, DDR_ZQ0CR1, DDR_DX0GCR, DDR_DX1GCR,
+    DDR_PTR0,      DDR_PTR1,  DDR_PTR2,   DDR_DTPR0, DDR_DTPR1,
+    DDR_DTPR2,     DDR_MR0,   DDR_MR1,    DDR_MR2,   DDR_MR3,
+};
+
+/* Copy cached training results for this configuration into regs. */
+static int train_load(uint32_t key, uint32_t *regs)
+{
+   if (train->magic != TRAIN_MAGIC || train->key != key ||
+       crc32(train, offsetof(struct ddr_train, crc)) != train->crc)
+      return -1;
+   memcpy(regs, train->regs, sizeof(train->regs));
+   return 0;
+}
+
+static void train_save(uint32_t key)
+{
+   train->magic   = TRAIN_MAGIC;
+   train->key     = key;
+   train->regs[0] = DDRPHYC->DX0DQSTR;
+   train->regs[1] = DDRPHYC->DX1DQSTR;
+   train->regs[2] = DDRPHYC->DX0DQTR;
+   train->regs[3] = DDRPHYC->DX1DQTR;
+   train->crc     = crc32(train, offsetof(struct ddr_train, crc));
+}
+
+/* Address-dependent pattern through the stage area, which holds nothing
+ * at this point; the MMU is still off, so this goes to the DRAM. */
+static int train_check(void)
+{
+   volatile uint32_t *const p = (volatile uint32_t *)DEF_STAGE_ADDR;
+   const uint32_t n           = TRAIN_CHECK_SIZE / 4U;
+   for (uint32_t pass = 0; pass < 2U; pass++) {
+      const uint32_t inv = pass ? 0xFFFFFFFFU : 0U;
+      for (uint32_t i = 0; i < n; i++)
+         p[i] = (i * 0x9E3779B9U) ^ inv;
+      for (uint32_t i = 0; i < n; i++)
+         if (p[i] != ((i * 0x9E3779B9U) ^ inv))
+            return -1;
+   }
+   return 0;
+}
+
 void ddr_init(void)
 {
    // MCE and TZC config
@@ -51,15 +127,37 @@ void ddr_init(void)
    // enable clock debug CK_DBG
    RCC->DBGCFGR |= RCC_DBGCFGR_DBGCKEN;
 
-   // init DDR
+   // init DDR, waking it from self-refresh after a warm reset, and with
+   // the PHY training from an earlier boot if there is one
    static DDR_InitTypeDef hddr;
-   hddr.wakeup_from_standby = false;
+   static uint32_t regs[HAL_DDR_TRAINED_REGS];
+   const uint32_t key       = crc32(phy_config, sizeof(phy_config));
+   uint32_t zdata           = 0;
+   hddr.wakeup_from_standby = warm_ddr_sleeping(&zdata);
    hddr.self_refresh        = false;
-   hddr.zdata               = 0;
+   hddr.zdata               = zdata;
    hddr.clear_bkp           = false;
+   hddr.trained             = (train_load(key, regs) == 0) ? regs : NULL;
 
-   if (HAL_DDR_Init(&hddr) != HAL_OK)
+   HAL_StatusTypeDef ret = HAL_DDR_Init(&hddr);
+   if (ret == HAL_OK && hddr.trained && train_check() != 0)
+      ret = HAL_ERROR;
+   if (ret != HAL_OK && (hddr.wakeup_from_standby || hddr.trained)) {
+      // start over with a full init and training
+      my_printf("DDR: %s failed, retraining\r\n",
+                hddr.trained ? "cached training" : "wakeup");
+      hddr.wakeup_from_standby = false;
+      hddr.trained             = NULL;
+      ret                      = HAL_DDR_Init(&hddr);
+   }
+   if (ret != HAL_OK)
       ERROR("DDR Init");
+
+   // the HAL switches the backup SRAM off after a wakeup
+   __HAL_RCC_BKPSRAM_CLK_ENABLE();
+   if (!hddr.trained)
+      train_save(key);
+   warm_ddr_up(hddr.self_refresh);
 }
 
 static void ddr_print(uint32_t addr, uint32_t num_words)
@@ -121,8 +219,8 @@ void ddr_relocate_initrd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    my_printf("relocate_initrd: 0x%08lx -> 0x%08lx (%lu B)\r\n",
              (unsigned long)FMC_DDR_BUF_ADDR, (unsigned long)DEF_INITRD_ADDR,
              (unsigned long)(DEF_INITRD_END - DEF_INITRD_ADDR));
-   memcpy((void *)DEF_INITRD_ADDR, (const void *)FMC_DDR_BUF_ADDR,
-          DEF_INITRD_END - DEF_INITRD_ADDR);
+   dma_copy((void *)DEF_INITRD_ADDR, (const void *)FMC_DDR_BUF_ADDR,
+            DEF_INITRD_END - DEF_INITRD_ADDR);
 }
 
 void ddr_align_test(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ddr_bench.c
+ * @brief DDR bandwidth and latency benchmark
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "ddr_bench.h"
+#include "defaults.h"
+#include "irq.h"
+#include "prng.h"
+#include "printf.h"
+#include "setup.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_mdma.h"
+#include "stm32mp13xx_hal_rcc.h"
+#include <stdint.h>
+#include <string.h>
+
+#define MIB        0x100000U
+#define BENCH_MAX  ((DEF_FASTBOOT_SIZE / 2U) & ~(MIB - 1U))
+#define BENCH_DEF  (16U * MIB)
+#define BENCH_RUNS 3       /* best of */
+#define LINE       64U     /* L1 and L2 line size */
+#define LAT_MIN    0x1000U /* smallest working set */
+#define LAT_LOADS  (1U << 20)
+#define DMA_BLOCK  0x10000U
+#define DMA_MAX    (4096U * DMA_BLOCK) /* BlockCount limit */
+#define DMA_TIMEOUT_MS 2000U
+
+/* Two buffers of BENCH_MAX bytes each in the download area. */
+static uint32_t *const buf_a = (uint32_t *)DEF_FASTBOOT_ADDR;
+static uint32_t *const buf_b = (uint32_t *)(DEF_FASTBOOT_ADDR + BENCH_MAX);
+
+/* Where the read loops leave their result, so none is optimised away. */
+static volatile uint32_t sink;
+
+static MDMA_HandleTypeDef hmdma_bench;
+static int dma_ready;
+
+typedef void (*kern_fn)(uint32_t *d, const uint32_t *s, uint32_t len);
+
+/* The plain C loops must stay loops, not become memcpy() or memset(). */
+#define C_KERNEL                                                               \
+   __attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+
+static void C_KERNEL rd_c(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   uint32_t acc = 0U;
+   (void)d;
+   for (const uint32_t *const e = s + len / 4U; s < e; s++)
+      acc += *s;
+   sink = acc;
+}
+
+static void C_KERNEL wr_c(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   (void)s;
+   for (uint32_t i = 0U; i < len / 4U; i++)
+      d[i] = i;
+}
+
+static void C_KERNEL cp_c(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   for (uint32_t i = 0U; i < len / 4U; i++)
+      d[i] = s[i];
+}
+
+/* 32 bytes per instruction; r7 and r11 are left to the frame pointer. */
+static void rd_ldm(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   const uint32_t *const e = s + len / 4U;
+   (void)d;
+   __asm volatile("1: ldmia %0!, {r3-r6, r8-r10, r12}\n"
+                  "   cmp   %0, %1\n"
+                  "   blo   1b\n"
+                  : "+r"(s)
+                  : "r"(e)
+                  : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                    "memory");
+}
+
+static void wr_stm(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   const uint32_t *const e = d + len / 4U;
+   (void)s;
+   __asm volatile("   mov   r3, #0\n"
+                  "   mov   r4, #0\n"
+                  "   mov   r5, #0\n"
+                  "   mov   r6, #0\n"
+                  "   mov   r8, #0\n"
+                  "   mov   r9, #0\n"
+                  "   mov   r10, #0\n"
+                  "   mov   r12, #0\n"
+                  "1: stmia %0!, {r3-r6, r8-r10, r12}\n"
+                  "   cmp   %0, %1\n"
+                  "   blo   1b\n"
+                  : "+r"(d)
+                  : "r"(e)
+                  : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                    "memory");
+}
+
+static void cp_ldm(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   const uint32_t *const e = s + len / 4U;
+   __asm volatile("1: ldmia %1!, {r3-r6, r8-r10, r12}\n"
+                  "   stmia %0!, {r3-r6, r8-r10, r12}\n"
+                  "   cmp   %1, %2\n"
+                  "   blo   1b\n"
+                  : "+r"(d), "+r"(s)
+                  : "r"(e)
+                  : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                    "memory");
+}
+
+/* 64 bytes (one line) per iteration through q0-q3. */
+static void rd_neon(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   const uint32_t *const e = s + len / 4U;
+   (void)d;
+   __asm volatile("1: vld1.64 {d0-d3}, [%0:128]!\n"
+                  "   vld1.64 {d4-d7}, [%0:128]!\n"
+                  "   cmp     %0, %1\n"
+                  "   blo     1b\n"
+                  : "+r"(s)
+                  : "r"(e)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc",
+                    "memory");
+}
+
+static void wr_neon(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   const uint32_t *const e = d + len / 4U;
+   (void)s;
+   __asm volatile("   vmov.i32 q0, #0\n"
+                  "   vmov.i32 q1, #0\n"
+                  "   vmov.i32 q2, #0\n"
+                  "   vmov.i32 q3, #0\n"
+                  "1: vst1.64 {d0-d3}, [%0:128]!\n"
+                  "   vst1.64 {d4-d7}, [%0:128]!\n"
+                  "   cmp     %0, %1\n"
+                  "   blo     1b\n"
+                  : "+r"(d)
+                  : "r"(e)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc",
+                    "memory");
+}
+
+static void cp_neon(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   const uint32_t *const e = s + len / 4U;
+   __asm volatile("1: vld1.64 {d0-d3}, [%1:128]!\n"
+                  "   vld1.64 {d4-d7}, [%1:128]!\n"
+                  "   vst1.64 {d0-d3}, [%0:128]!\n"
+                  "   vst1.64 {d4-d7}, [%0:128]!\n"
+                  "   cmp     %1, %2\n"
+                  "   blo     1b\n"
+                  : "+r"(d), "+r"(s)
+                  : "r"(e)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc",
+                    "memory");
+}
+
+static void wr_libc(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   (void)s;
+   memset(d, 0, len);
+}
+
+static void cp_libc(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   memcpy(d, s, len);
+}
+
+static const struct {
+   const char *name;
+   kern_fn rd, wr, cp;
+} methods[] = {
+    {"C",       rd_c,    wr_c,    cp_c   },
+    {"ldm/stm", rd_ldm,  wr_stm,  cp_ldm },
+    {"neon",    rd_neon, wr_neon, cp_neon},
+    {"libc",    NULL,    wr_libc, cp_libc},
+};
+
+/* bytes per us is MB/s */
+static uint32_t mbps(uint32_t len, uint64_t ticks)
+{
+   if (ticks == 0U)
+      return 0U;
+   return (uint32_t)((uint64_t)len * (DEF_STGEN_HZ / 1000000U) / ticks);
+}
+
+/* Best of BENCH_RUNS, each starting with nothing of either buffer cached. */
+static uint32_t run(kern_fn k, uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   uint64_t best = UINT64_MAX;
+   for (int i = 0; i < BENCH_RUNS; i++) {
+      L1C_CleanInvalidateDCacheAll();
+      const uint64_t t0 = __get_CNTPCT();
+      k(d, s, len);
+      __DSB();
+      const uint64_t t = __get_CNTPCT() - t0;
+      if (t < best)
+         best = t;
+   }
+   return mbps(len, best);
+}
+
+static HAL_StatusTypeDef dma_init(void)
+{
+   hmdma_bench.Instance                      = MDMA_CH_BENCH;
+   hmdma_bench.Init.Request                  = MDMA_REQUEST_SW;
+   hmdma_bench.Init.TransferTriggerMode      = MDMA_FULL_TRANSFER;
+   hmdma_bench.Init.Priority                 = MDMA_PRIORITY_HIGH;
+   hmdma_bench.Init.SecureMode               = MDMA_SECURE_MODE_DISABLE;
+   hmdma_bench.Init.Endianness               = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+   hmdma_bench.Init.SourceInc                = MDMA_SRC_INC_DOUBLEWORD;
+   hmdma_bench.Init.DestinationInc           = MDMA_DEST_INC_DOUBLEWORD;
+   hmdma_bench.Init.SourceDataSize           = MDMA_SRC_DATASIZE_DOUBLEWORD;
+   hmdma_bench.Init.DestDataSize             = MDMA_DEST_DATASIZE_DOUBLEWORD;
+   hmdma_bench.Init.DataAlignment            = MDMA_DATAALIGN_PACKENABLE;
+   hmdma_bench.Init.BufferTransferLength     = 128U;
+   hmdma_bench.Init.SourceBurst              = MDMA_SOURCE_BURST_16BEATS;
+   hmdma_bench.Init.DestBurst                = MDMA_DEST_BURST_16BEATS;
+   hmdma_bench.Init.SourceBlockAddressOffset = 0;
+   hmdma_bench.Init.DestBlockAddressOffset   = 0;
+   return HAL_MDMA_Init(&hmdma_bench);
+}
+
+/* MDMA copy rate, or 0 if the transfer fails. */
+static uint32_t run_dma(uint32_t *d, const uint32_t *s, uint32_t len)
+{
+   __HAL_RCC_MDMA_CLK_ENABLE();
+   if (!dma_ready && dma_init() == HAL_OK)
+      dma_ready = 1;
+   if (!dma_ready)
+      return 0U;
+   if (len > DMA_MAX)
+      len = DMA_MAX;
+
+   uint64_t best = UINT64_MAX;
+   for (int i = 0; i < BENCH_RUNS; i++) {
+      /* MDMA reads and writes DDR, not the cache. */
+      L1C_CleanInvalidateDCacheAll();
+      const uint64_t t0 = __get_CNTPCT();
+      if (HAL_MDMA_Start(&hmdma_bench, (uint32_t)s, (uint32_t)d, DMA_BLOCK,
+                         len / DMA_BLOCK) != HAL_OK ||
+          HAL_MDMA_PollForTransfer(&hmdma_bench, HAL_MDMA_FULL_TRANSFER,
+                                   DMA_TIMEOUT_MS) != HAL_OK) {
+         (void)HAL_MDMA_Abort(&hmdma_bench);
+         return 0U;
+      }
+      const uint64_t t = __get_CNTPCT() - t0;
+      if (t < best)
+         best = t;
+   }
+   return mbps(len, best);
+}
+
+/* Eight dependent loads per iteration, so the loop costs next to nothing. */
+static const uint32_t *__attribute__((noinline)) chase(const uint32_t *p,
+                                                        uint32_t n)
+{
+   for (n /= 8U; n != 0U; n--) {
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+      p = (const uint32_t *)*p;
+   }
+   return p;
+}
+
+/* Link the ws / LINE nodes of ws bytes at buf into one cycle, in address
+ * order or in random order (Sattolo's shuffle, with scratch for the
+ * permutation), and return tenths of a ns per load around it. */
+static uint32_t latency(uint32_t *buf, uint32_t *scratch, uint32_t ws,
+                        int random)
+{
+   const uint32_t n  = ws / LINE;
+   const uint32_t st = LINE / 4U; /* words between nodes */
+
+   if (random) {
+      uint64_t seed = 0x9E3779B97F4A7C15ULL;
+      for (uint32_t i = 0U; i < n; i++)
+         scratch[i] = i;
+      for (uint32_t i = n - 1U; i > 0U; i--) {
+         uint32_t r;
+         prng_fill((uint8_t *)&r, sizeof(r), &seed);
+         const uint32_t j = r % i;
+         const uint32_t t = scratch[i];
+         scratch[i]       = scratch[j];
+         scratch[j]       = t;
+      }
+      for (uint32_t i = 0U; i < n; i++)
+         buf[i * st] = (uint32_t)&buf[scratch[i] * st];
+   } else {
+      for (uint32_t i = 0U; i < n; i++)
+         buf[i * st] = (uint32_t)&buf[((i + 1U) % n) * st];
+   }
+
+   /* once around to fill the caches and TLB as far as they hold it */
+   L1C_CleanDCacheAll();
+   const uint32_t *p = chase(buf, (n < LAT_LOADS) ? n : LAT_LOADS);
+
+   const uint64_t t0 = __get_CNTPCT();
+   p                 = chase(p, LAT_LOADS);
+   const uint64_t t  = __get_CNTPCT() - t0;
+   sink              = (uint32_t)p;
+
+   /* a tick is 1000 / 24 ns */
+   return (uint32_t)(t * 10000U /
+                     ((DEF_STGEN_HZ / 1000000U) * (uint64_t)LAT_LOADS));
+}
+
+static uint32_t clamp_size(uint32_t size)
+{
+   if (size == 0U)
+      size = BENCH_DEF;
+   if (size > BENCH_MAX)
+      size = BENCH_MAX;
+   return size & ~(LINE - 1U);
+}
+
+void ddr_bench_run(uint32_t size, struct ddr_bench_res *r)
+{
+   const uint32_t sctlr = dcache_on();
+   size                 = clamp_size(size);
+   r->rd                = run(rd_neon, buf_b, buf_a, size);
+   r->wr                = run(wr_neon, buf_b, buf_a, size);
+   r->cp                = run(cp_neon, buf_b, buf_a, size);
+   r->dma               = run_dma(buf_b, buf_a, size);
+   r->lat               = latency(buf_a, buf_b, size, 1);
+   dcache_restore(sctlr);
+}
+
+static void print_rate(uint32_t v)
+{
+   if (v == 0U)
+      my_printf("%9s", "-");
+   else
+      my_printf("%9lu", (unsigned long)v);
+}
+
+static void print_ns(uint32_t v)
+{
+   my_printf("%8lu.%lu", (unsigned long)(v / 10U), (unsigned long)(v % 10U));
+}
+
+void ddr_bench_cmd(int argc, uint32_t mib, uint32_t arg2, uint32_t arg3)
+{
+   (void)arg2;
+   (void)arg3;
+
+   const uint32_t size  = clamp_size((argc >= 1) ? mib * MIB : 0U);
+   const uint32_t sctlr = dcache_on();
+   const int cached     = (__get_SCTLR() & SCTLR_C_Msk) != 0U;
+   my_printf("ddr_bench: %lu MiB at 0x%08lx and 0x%08lx, D-cache %s\r\n",
+             (unsigned long)(size / MIB), (unsigned long)buf_a,
+             (unsigned long)buf_b, cached ? "on" : "off (MMU off)");
+
+   my_printf("%-8s %9s %9s %9s  (MB/s)\r\n", "", "read", "write", "copy");
+   for (uint32_t i = 0U; i < sizeof(methods) / sizeof(methods[0]); i++) {
+      my_printf("%-8s ", methods[i].name);
+      print_rate(methods[i].rd ? run(methods[i].rd, buf_b, buf_a, size) : 0U);
+      print_rate(run(methods[i].wr, buf_b, buf_a, size));
+      print_rate(run(methods[i].cp, buf_b, buf_a, size));
+      my_printf("\r\n");
+   }
+   my_printf("%-8s ", "mdma");
+   print_rate(0U);
+   print_rate(0U);
+   print_rate(run_dma(buf_b, buf_a, size));
+   my_printf("\r\n\r\n");
+
+   if (!cached) {
+      /* every load would go to DDR, so L1 and L2 would not show */
+      my_printf("no latency sweep without the D-cache\r\n");
+      return;
+   }
+   my_printf("%-8s %10s %10s  (ns/load)\r\n", "set", "stride", "random");
+   for (uint32_t ws = LAT_MIN; ws <= size; ws *= 4U) {
+      if (ws >= MIB)
+         my_printf("%4lu MiB ", (unsigned long)(ws / MIB));
+      else
+         my_printf("%4lu KiB ", (unsigned long)(ws / 1024U));
+      print_ns(latency(buf_a, buf_b, ws, 0));
+      print_ns(latency(buf_a, buf_b, ws, 1));
+      my_printf("\r\n");
+   }
+   dcache_restore(sctlr);
+}
+
+// end file ddr_bench.c
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ddr_bench.h
+ * @brief DDR bandwidth and latency benchmark
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Bandwidth is measured over two buffers in the download area, with the
+ * data cache turned on for the run whatever CACHE_USE says, so the
+ * sequential rows show what DDR sustains through L2 and the latency rows
+ * show where L1, L2 and DDR each take over.  All times come from the
+ * 24 MHz system counter.
+ */
+
+#ifndef DDR_BENCH_H
+#define DDR_BENCH_H
+
+#include <stdint.h>
+
+/* Best sequential rates in MB/s, and the random pointer-chase latency in
+ * tenths of a ns, over one working set. */
+struct ddr_bench_res {
+   uint32_t rd;
+   uint32_t wr;
+   uint32_t cp;
+   uint32_t dma;
+   uint32_t lat;
+};
+
+/* Measure NEON read, write and copy, MDMA copy and random latency over
+ * size bytes (at most the benchmark buffer; 0 for the default). */
+void ddr_bench_run(uint32_t size, struct ddr_bench_res *r);
+
+/* ddr_bench [mib]: print the full table over mib MiB (default 16):
+ * sequential read, write and copy in MB/s for plain C, LDM/STM, NEON,
+ * memcpy() and MDMA, then the ns per load of a 64-byte stride and of a
+ * random pointer chase at working sets from 4 KiB up to mib. */
+void ddr_bench_cmd(int argc, uint32_t mib, uint32_t arg2, uint32_t arg3);
+
+#endif // DDR_BENCH_H
+
+// end file ddr_bench.h
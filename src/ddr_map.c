@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ddr_map.c
+ * @brief Named DDR regions
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "ddr_map.h"
+#include "board.h"
+#include "defaults.h"
+#include "printf.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MAP_MAX   16U
+#define MAP_ALIGN 64U                    /* one cache line */
+#define TTB_SIZE  (16384U + 4U * 1024U) /* sysram.ld: L1 and four L2 */
+
+/* MMU translation tables, placed in DDR by sysram.ld. */
+extern uint32_t TTB[];
+
+/* Sorted by address. */
+static struct ddr_region map[MAP_MAX];
+static uint32_t num;
+
+static int find(const char *name)
+{
+   for (uint32_t i = 0U; i < num; i++)
+      if (strcmp(map[i].name, name) == 0)
+         return (int)i;
+   return -1;
+}
+
+static void remove_at(uint32_t i)
+{
+   for (num--; i < num; i++)
+      map[i] = map[i + 1U];
+}
+
+int ddr_map_reserve(const char *name, uint32_t addr, uint32_t size,
+                    uint32_t flags)
+{
+   const uint64_t end = (uint64_t)addr + size;
+   if (size == 0U || addr < DEF_DDR_BASE ||
+       end > (uint64_t)DEF_DDR_BASE + DDR_MEM_SIZE) {
+      my_printf("ddr_map: %s 0x%08lx+0x%lx is not in DDR\r\n", name,
+                (unsigned long)addr, (unsigned long)size);
+      return -1;
+   }
+
+   const int self = find(name);
+   for (uint32_t i = 0U; i < num; i++) {
+      if ((int)i != self && addr < map[i].addr + map[i].size &&
+          map[i].addr < end) {
+         my_printf("ddr_map: %s 0x%08lx-0x%08lx overlaps %s\r\n", name,
+                   (unsigned long)addr, (unsigned long)(end - 1U),
+                   map[i].name);
+         return -1;
+      }
+   }
+
+   if (self >= 0) {
+      remove_at((uint32_t)self);
+   } else if (num == MAP_MAX) {
+      my_printf("ddr_map: no room for %s\r\n", name);
+      return -1;
+   }
+
+   uint32_t i = num++;
+   for (; i > 0U && map[i - 1U].addr > addr; i--)
+      map[i] = map[i - 1U];
+   map[i].name  = name;
+   map[i].addr  = addr;
+   map[i].size  = size;
+   map[i].flags = flags;
+   return 0;
+}
+
+uint32_t ddr_map_alloc(const char *name, uint32_t size, uint32_t align)
+{
+   const int self = find(name);
+   if (self >= 0 && map[self].size >= size)
+      return map[self].addr;
+   if (align < MAP_ALIGN)
+      align = MAP_ALIGN;
+
+   /* first fit */
+   uint32_t at = DEF_POOL_ADDR;
+   for (uint32_t i = 0U; i < num; i++) {
+      if ((int)i == self)
+         continue;
+      at = (at + align - 1U) & ~(align - 1U);
+      if (map[i].addr >= at + size)
+         break;
+      if (map[i].addr + map[i].size > at)
+         at = map[i].addr + map[i].size;
+   }
+   at = (at + align - 1U) & ~(align - 1U);
+
+   if (at + size > DEF_POOL_ADDR + DEF_POOL_SIZE ||
+       ddr_map_reserve(name, at, size, 0U) != 0) {
+      my_printf("ddr_map: no space for %s (%lu B)\r\n", name,
+                (unsigned long)size);
+      return 0U;
+   }
+   return at;
+}
+
+void ddr_map_free(const char *name)
+{
+   const int i = find(name);
+   if (i >= 0)
+      remove_at((uint32_t)i);
+}
+
+const struct ddr_region *ddr_map_get(uint32_t i)
+{
+   return (i < num) ? &map[i] : NULL;
+}
+
+void ddr_map_init(void)
+{
+   num = 0U;
+   (void)ddr_map_reserve("ttb", (uint32_t)TTB, TTB_SIZE, DDR_MAP_LIVE);
+   (void)ddr_map_reserve("bootlog", DEF_TRACE_ADDR, DEF_TRACE_SIZE,
+                         DDR_MAP_LIVE | DDR_MAP_KEEP);
+   (void)ddr_map_reserve("stage", DEF_STAGE_ADDR, DEF_STAGE_SIZE, 0U);
+#ifdef ETHERNET
+   (void)ddr_map_reserve("eth_buf", DEF_ETH_BUF_ADDR, DEF_ETH_BUF_SIZE,
+                         DDR_MAP_LIVE);
+#endif
+#ifdef NAND_FLASH
+   (void)ddr_map_reserve("nand_cache", FMC_DDR_BUF_ADDR, FMC_DDR_BUF_SIZE,
+                         0U);
+#endif
+}
+
+void ddr_map_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   (void)argc;
+   (void)arg1;
+   (void)arg2;
+   (void)arg3;
+
+   uint32_t at = DEF_DDR_BASE;
+   for (uint32_t i = 0U; i <= num; i++) {
+      const uint32_t next = (i < num) ? map[i].addr : DEF_DDR_BASE +
+                                                          DDR_MEM_SIZE;
+      if (next > at)
+         my_printf("0x%08lx-0x%08lx %8lu KiB  -\r\n", (unsigned long)at,
+                   (unsigned long)(next - 1U),
+                   (unsigned long)((next - at) / 1024U));
+      if (i == num)
+         break;
+      my_printf("0x%08lx-0x%08lx %8lu KiB  %s%s%s\r\n",
+                (unsigned long)map[i].addr,
+                (unsigned long)(map[i].addr + map[i].size - 1U),
+                (unsigned long)(map[i].size / 1024U), map[i].name,
+                (map[i].flags & DDR_MAP_KEEP) ? " keep" : "",
+                (map[i].flags & DDR_MAP_LIVE) ? " live" : "");
+      at = map[i].addr + map[i].size;
+   }
+}
+
+// end file ddr_map.c
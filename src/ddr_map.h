@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ddr_map.h
+ * @brief Named DDR regions
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Every buffer the bootloader keeps in DDR, and every image it loads, is
+ * entered here under a name, and no two regions may overlap.  Fixed areas
+ * from defaults.h are reserved where they are; buffers whose place does
+ * not matter are allocated from the pool at the start of DDR; images are
+ * reserved at their load address with their actual size as they load.
+ * Regions flagged DDR_MAP_KEEP are passed on to Linux as reserved-memory.
+ */
+
+#ifndef DDR_MAP_H
+#define DDR_MAP_H
+
+#include <stdint.h>
+
+#define DDR_MAP_KEEP 0x1U /* reserved-memory in the DTB at boot */
+#define DDR_MAP_LIVE 0x2U /* in use by hardware or the MMU: never tested */
+
+struct ddr_region {
+   const char *name; /* also the DTB node name */
+   uint32_t addr;
+   uint32_t size;
+   uint32_t flags;
+};
+
+/* Reserve the fixed areas; call once DDR and the MMU are up. */
+void ddr_map_init(void);
+
+/* Enter [addr, addr + size) as name, moving or resizing the region if name
+ * is already there; name is kept, so it must be a string constant.  Returns
+ * 0, or -1 (with a message) if it leaves DDR or overlaps another region. */
+int ddr_map_reserve(const char *name, uint32_t addr, uint32_t size,
+                    uint32_t flags);
+
+/* Place size bytes in the pool, aligned to align (at least a cache line).
+ * If name is already allocated and large enough, returns it again.
+ * Returns the address, or 0 (with a message) if the pool is full. */
+uint32_t ddr_map_alloc(const char *name, uint32_t size, uint32_t align);
+
+void ddr_map_free(const char *name);
+
+/* Region i in address order, or NULL past the last. */
+const struct ddr_region *ddr_map_get(uint32_t i);
+
+void ddr_map_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#endif // DDR_MAP_H
+
+// end file ddr_map.h
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ddr_qos.c
+ * @brief Runtime tuning of the DDR controller scheduler and port QoS
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "ddr_qos.h"
+#include "board.h"
+#include "console.h"
+#include "ddr_bench.h"
+#include "defaults.h"
+#include "irq.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_ddr.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef NAND_FLASH
+#include "fmc.h"
+#endif
+
+#define MIB          0x100000U
+#define QOS_BLOCKS   16U /* NAND erase blocks per read pass */
+#define QOS_MAX_EDIT 3
+
+enum {
+   R_SCHED,
+   R_SCHED1,
+   R_PERFHPR1,
+   R_PERFLPR1,
+   R_PERFWR1,
+   R_PCFGR_0,
+   R_PCFGW_0,
+   R_PCFGQOS0_0,
+   R_PCFGQOS1_0,
+   R_PCFGWQOS0_0,
+   R_PCFGWQOS1_0,
+   R_NUM,
+};
+
+#define REG(x) {#x, offsetof(HAL_DDR_PerfTypeDef, x), DDR_##x}
+static const struct {
+   const char *name;
+   uint32_t off;   /* in HAL_DDR_PerfTypeDef */
+   uint32_t board; /* as board.h has it */
+} regs[R_NUM] = {
+    [R_SCHED]       = REG(SCHED),
+    [R_SCHED1]      = REG(SCHED1),
+    [R_PERFHPR1]    = REG(PERFHPR1),
+    [R_PERFLPR1]    = REG(PERFLPR1),
+    [R_PERFWR1]     = REG(PERFWR1),
+    [R_PCFGR_0]     = REG(PCFGR_0),
+    [R_PCFGW_0]     = REG(PCFGW_0),
+    [R_PCFGQOS0_0]  = REG(PCFGQOS0_0),
+    [R_PCFGQOS1_0]  = REG(PCFGQOS1_0),
+    [R_PCFGWQOS0_0] = REG(PCFGWQOS0_0),
+    [R_PCFGWQOS1_0] = REG(PCFGWQOS1_0),
+};
+
+/* What ddr_qos_sweep tries, each as up to QOS_MAX_EDIT field changes on
+ * top of the settings in force when it starts. */
+static const struct {
+   const char *name;
+   struct {
+      uint8_t reg;
+      uint32_t mask, val;
+   } edit[QOS_MAX_EDIT];
+} sweep[] = {
+    {"current", {{0}}},
+    {"prefer_wr",
+     {{R_SCHED, DDRCTRL_SCHED_PREFER_WRITE_Msk,
+       DDRCTRL_SCHED_PREFER_WRITE_Msk}}},
+    {"pageclose",
+     {{R_SCHED, DDRCTRL_SCHED_PAGECLOSE_Msk, DDRCTRL_SCHED_PAGECLOSE_Msk}}},
+    {"all_lpr", /* force_low_pri_n is active low */
+     {{R_SCHED, DDRCTRL_SCHED_FORCE_LOW_PRI_N_Msk, 0U}}},
+    {"vpr_hpr", /* the reads that map to VPR become HPR */
+     {{R_PCFGQOS0_0, DDRCTRL_PCFGQOS0_0_RQOS_MAP_REGION1_Msk,
+       2UL << DDRCTRL_PCFGQOS0_0_RQOS_MAP_REGION1_Pos}}},
+    {"runs_16",
+     {{R_PERFHPR1, DDRCTRL_PERFHPR1_HPR_XACT_RUN_LENGTH_Msk,
+       16UL << DDRCTRL_PERFHPR1_HPR_XACT_RUN_LENGTH_Pos},
+      {R_PERFLPR1, DDRCTRL_PERFLPR1_LPR_XACT_RUN_LENGTH_Msk,
+       16UL << DDRCTRL_PERFLPR1_LPR_XACT_RUN_LENGTH_Pos},
+      {R_PERFWR1, DDRCTRL_PERFWR1_W_XACT_RUN_LENGTH_Msk,
+       16UL << DDRCTRL_PERFWR1_W_XACT_RUN_LENGTH_Pos}}},
+    {"starve_lo",
+     {{R_PERFLPR1, DDRCTRL_PERFLPR1_LPR_MAX_STARVE_Msk,
+       0x80UL << DDRCTRL_PERFLPR1_LPR_MAX_STARVE_Pos},
+      {R_PERFWR1, DDRCTRL_PERFWR1_W_MAX_STARVE_Msk,
+       0x100UL << DDRCTRL_PERFWR1_W_MAX_STARVE_Pos}}},
+};
+
+static uint32_t *field(HAL_DDR_PerfTypeDef *p, uint32_t i)
+{
+   return (uint32_t *)((uint8_t *)p + regs[i].off);
+}
+
+/* The update closes the AXI port, and the translation table is in DDR,
+ * so until it is done nothing may reach DDR: not a dirty line, a line
+ * fill or a table walk.  Code, data and stacks are all in SYSRAM. */
+static int apply(const HAL_DDR_PerfTypeDef *p)
+{
+   const uint32_t cpsr  = irq_save();
+   const uint32_t sctlr = __get_SCTLR();
+
+   L1C_CleanInvalidateDCacheAll();
+   __set_SCTLR(sctlr & ~(SCTLR_M_Msk | SCTLR_C_Msk));
+   __ISB();
+   L1C_CleanInvalidateDCacheAll(); /* what the last few stores dirtied */
+
+   const HAL_StatusTypeDef r = HAL_DDR_Perf_Set(p);
+
+   L1C_InvalidateDCacheAll();
+   MMU_InvalidateTLB();
+   __set_SCTLR(sctlr);
+   __ISB();
+
+   irq_restore(cpsr);
+   return (r == HAL_OK) ? 0 : -1;
+}
+
+static void print_reg(HAL_DDR_PerfTypeDef *p, uint32_t i)
+{
+   const uint32_t v = *field(p, i);
+   my_printf("%2lu  #define DDR_%-12s 0x%08lx", (unsigned long)i, regs[i].name,
+             (unsigned long)v);
+   if (v != regs[i].board)
+      my_printf("  /* board.h 0x%08lx */", (unsigned long)regs[i].board);
+   my_printf("\r\n");
+}
+
+void ddr_qos_cmd(int argc, uint32_t reg, uint32_t val, uint32_t arg3)
+{
+   (void)arg3;
+
+   HAL_DDR_PerfTypeDef p;
+   if (HAL_DDR_Perf_Get(&p) != HAL_OK) {
+      my_printf("ddr_qos: cannot read the registers\r\n");
+      return;
+   }
+
+   if (argc < 1) {
+      for (uint32_t i = 0U; i < R_NUM; i++)
+         print_reg(&p, i);
+      return;
+   }
+   if (reg >= R_NUM) {
+      my_printf("ddr_qos: reg is 0 to %u\r\n", R_NUM - 1U);
+      return;
+   }
+
+   if (argc >= 2) {
+      if (reg == R_SCHED &&
+          ((val ^ p.SCHED) & DDRCTRL_SCHED_LPR_NUM_ENTRIES_Msk) != 0U) {
+         my_printf("ddr_qos: lpr_num_entries is static, set it in "
+                   "board.h\r\n");
+         return;
+      }
+      *field(&p, reg) = val;
+      if (apply(&p) != 0)
+         my_printf("ddr_qos: update failed\r\n");
+      (void)HAL_DDR_Perf_Get(&p);
+   }
+   print_reg(&p, reg);
+}
+
+#ifdef NAND_FLASH
+/* kB/s reading NAND into DDR through the FMC sequencer's MDMA, or 0. */
+static uint32_t nand_rate(uint32_t blocks)
+{
+   uint8_t *const dst = (uint8_t *)DEF_FASTBOOT_ADDR;
+   const uint32_t t0  = HAL_GetTick();
+   for (uint32_t i = 0U; i < blocks; i++)
+      if (fmc_read_blocks(i, dst, 1U) != 0)
+         return 0U;
+   const uint32_t ms = HAL_GetTick() - t0;
+   /* bytes per ms is kB/s */
+   return (ms != 0U) ? (uint32_t)((uint64_t)blocks * fmc_block_bytes() / ms)
+                     : 0U;
+}
+#endif
+
+static void print_col(uint32_t v)
+{
+   if (v == 0U)
+      my_printf(" %7s", "-");
+   else
+      my_printf(" %7lu", (unsigned long)v);
+}
+
+void ddr_qos_sweep_cmd(int argc, uint32_t mib, uint32_t blocks, uint32_t arg3)
+{
+   (void)arg3;
+
+   const uint32_t size = (argc >= 1) ? mib * MIB : 0U;
+   if (argc < 2 || blocks == 0U)
+      blocks = QOS_BLOCKS;
+
+   HAL_DDR_PerfTypeDef start;
+   if (HAL_DDR_Perf_Get(&start) != HAL_OK) {
+      my_printf("ddr_qos: cannot read the registers\r\n");
+      return;
+   }
+
+   my_printf("%-10s %7s %7s %7s %7s %7s", "", "read", "write", "copy",
+             "mdma", "ns");
+#ifdef NAND_FLASH
+   my_printf(" %7s", "nand");
+#endif
+   my_printf("  (MB/s; random load ns");
+#ifdef NAND_FLASH
+   my_printf("; NAND read kB/s");
+#endif
+   my_printf(")\r\n");
+
+   for (uint32_t c = 0U; c < sizeof(sweep) / sizeof(sweep[0]); c++) {
+      HAL_DDR_PerfTypeDef p = start;
+      for (int e = 0; e < QOS_MAX_EDIT; e++) {
+         uint32_t *const f = field(&p, sweep[c].edit[e].reg);
+         *f = (*f & ~sweep[c].edit[e].mask) | sweep[c].edit[e].val;
+      }
+
+      my_printf("%-10s", sweep[c].name);
+      if (apply(&p) != 0) {
+         my_printf(" update failed\r\n");
+         continue;
+      }
+
+      struct ddr_bench_res r;
+      ddr_bench_run(size, &r);
+      print_col(r.rd);
+      print_col(r.wr);
+      print_col(r.cp);
+      print_col(r.dma);
+      my_printf(" %5lu.%lu", (unsigned long)(r.lat / 10U),
+                (unsigned long)(r.lat % 10U));
+#ifdef NAND_FLASH
+      print_col(nand_rate(blocks));
+#else
+      (void)blocks;
+#endif
+      my_printf("\r\n");
+
+      if (console_interrupted()) {
+         my_printf("interrupted\r\n");
+         break;
+      }
+   }
+
+   if (apply(&start) != 0)
+      my_printf("ddr_qos: could not restore the settings\r\n");
+}
+
+// end file ddr_qos.c
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ddr_qos.h
+ * @brief Runtime tuning of the DDR controller scheduler and port QoS
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * The uMCTL2 performance registers (DDR_SCHED .. DDR_PCFGWQOS1_0 in
+ * board.h) are quasi-dynamic: they can be rewritten while DDR is up, but
+ * only with the AXI port closed and the controller queues drained, so the
+ * update runs with the MMU and caches off and interrupts masked.  Changes
+ * last until the next DDR init.  SCHED.lpr_num_entries is static and can
+ * only be changed in board.h.
+ */
+
+#ifndef DDR_QOS_H
+#define DDR_QOS_H
+
+#include <stdint.h>
+
+/* ddr_qos [reg [val]]: with no arguments, list the registers as board.h
+ * defines with their board.h values; with reg, show one; with val as
+ * well, write it.  reg is the index in the list. */
+void ddr_qos_cmd(int argc, uint32_t reg, uint32_t val, uint32_t arg3);
+
+/* ddr_qos_sweep [mib [blocks]]: starting from the current settings, try
+ * each of a set of variations and print ddr_bench figures over mib MiB
+ * (default 16) and, in NAND builds, the NAND read rate over blocks erase
+ * blocks (default 16) for each, then go back to the starting settings. */
+void ddr_qos_sweep_cmd(int argc, uint32_t mib, uint32_t blocks,
+                       uint32_t arg3);
+
+#endif // DDR_QOS_H
+
+// end file ddr_qos.h
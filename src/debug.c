@@ -8,6 +8,7 @@
  */
 
 #include "debug.h"
+#include "console.h"
 #include "printf.h"
 #include "stm32mp135fxx_ca7.h"
 #include "stm32mp13xx_hal.h"
@@ -16,6 +17,7 @@
 void error_msg(const char *file, const int line, const char *msg)
 {
    my_printf("File %s line %d: %s.\r\n", file, line, msg);
+   uart_flush();
    while (1) {
       HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_13);
       HAL_Delay(25);
@@ -28,5 +30,6 @@ void error_msg(const char *file, const int line, const char *msg)
       HAL_Delay(100);
 
       my_printf("ERROR: %s\r\n", msg);
+      uart_flush();
    }
 }
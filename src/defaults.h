@@ -15,6 +15,9 @@
 
 #define DEF_PRINT_LEN 128
 
+/* System counter (STGEN) rate; handoff.S programs CNTFRQ to match. */
+#define DEF_STGEN_HZ 24000000U
+
 /* Linux kernel. */
 #define DEF_LINUX_ADDR 0xC2000000U
 #define DEF_LINUX_LEN  15000 /* sectors on SD */
@@ -25,6 +28,33 @@
 #define DEF_DTB_LEN  250 /* sectors on SD */
 #define DEF_DTB_BLK  640 /* starting LBA on SD */
 
+/* USB MSC RAM disk (RAM_DISK builds).  Overlays the kernel and DTB load
+ * addresses, so a kernel written at LBA 0 and a DTB at DEF_RAMDISK_DTB_LBA
+ * can be started with `jump` without touching flash.  Ends where sysram.ld
+ * places the MMU translation tables (DDR_HIGH). */
+#define DEF_RAMDISK_ADDR    DEF_LINUX_ADDR
+#define DEF_RAMDISK_SIZE    0x04000000U /* 64 MiB */
+#define DEF_RAMDISK_DTB_LBA ((DEF_DTB_ADDR - DEF_RAMDISK_ADDR) / 512U)
+
+/* Scratch for assembling one storage block (SD sector or NAND erase block)
+ * while an image is written; clear of the pool below it. */
+#define DEF_STAGE_ADDR 0xC1000000U
+#define DEF_STAGE_SIZE 0x00100000U /* 1 MiB */
+
+/* Where ddr_map_alloc places run-time buffers (LCD framebuffer, FMC block
+ * buffers, SD sector): the start of DDR, up to the stage area. */
+#define DEF_POOL_ADDR DEF_DDR_BASE
+#define DEF_POOL_SIZE (DEF_STAGE_ADDR - DEF_DDR_BASE) /* 16 MiB */
+
+/* Ethernet DMA frame buffers (ETHERNET builds), just above the stage. */
+#define DEF_ETH_BUF_ADDR 0xC1100000U
+#define DEF_ETH_BUF_SIZE 0x00100000U /* 1 MiB */
+
+/* TFTP file names, relative to the server root.  The kernel name is only
+ * used when DHCP does not supply a boot file. */
+#define DEF_TFTP_KERNEL "zImage"
+#define DEF_TFTP_DTB    "board.dtb"
+
 /* USB MSC DDR backing store.  Host writes land here; fmc_flush commits to
  * NAND.  Only active in NAND builds -- EVB uses the SD card directly. */
 #define FMC_DDR_BUF_ADDR 0xC8000000U
@@ -36,4 +66,28 @@
 #define DEF_INITRD_SIZE 0x02000000U /* 32 MiB */
 #define DEF_INITRD_END  (DEF_INITRD_ADDR + DEF_INITRD_SIZE)
 
+/* Binary event log (trace.c) in the last MiB of DDR.  boot_jump() reserves
+ * it in the kernel DTB, so it survives into Linux. */
+#define DEF_TRACE_ADDR 0xDFF00000U
+#define DEF_TRACE_SIZE 0x00100000U /* 1 MiB */
+
+/* Backup SRAM, which keeps its contents across a system reset.
+ * HAL_DDR_Init() saves the start of DDR, which its training overwrites, in
+ * the first 64 bytes; the warm boot record (warm.c) and the cached DDR PHY
+ * training results (ddr.c) follow. */
+#define DEF_BKP_ADDR       0x54000000U
+#define DEF_BKP_WARM_ADDR  (DEF_BKP_ADDR + 0x40U)
+#define DEF_BKP_TRAIN_ADDR (DEF_BKP_ADDR + 0x100U)
+
+/* Download buffer for fastboot and ethload.  SD builds reuse the USB MSC
+ * DDR buffer, which they leave idle; NAND builds need that buffer as the
+ * page cache, so their downloads go to the free DDR above the initrd. */
+#ifndef NAND_FLASH
+#define DEF_FASTBOOT_ADDR FMC_DDR_BUF_ADDR
+#define DEF_FASTBOOT_SIZE FMC_DDR_BUF_SIZE
+#else
+#define DEF_FASTBOOT_ADDR DEF_INITRD_END
+#define DEF_FASTBOOT_SIZE (DEF_TRACE_ADDR - DEF_INITRD_END) /* 95 MiB */
+#endif
+
 #endif // DEFAULTS_H
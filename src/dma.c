@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file dma.c
+ * @brief Memory-to-memory copies on an MDMA channel
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "dma.h"
+#include "irq.h"
+#include "irq_ctrl.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_mdma.h"
+#include "stm32mp13xx_hal_rcc.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DMA_BLOCK 0x10000U /* BlockDataLength limit */
+#define DMA_COUNT 4096U    /* BlockCount limit */
+
+static MDMA_HandleTypeDef hmdma_cpy;
+static int dma_ready;
+static int running;
+
+/* Copies not yet finished; the head is on the channel. */
+static struct dma_req *head;
+static struct dma_req *tail;
+
+void MDMA_IRQHandler(void)
+{
+   HAL_MDMA_IRQHandler(&hmdma_cpy);
+}
+
+/* Widest beats that the addresses and length allow; 16-beat bursts only
+ * for doublewords, where they match the 128-byte buffer. */
+static HAL_StatusTypeDef setup(uint32_t align)
+{
+   MDMA_InitTypeDef *const in = &hmdma_cpy.Init;
+   if ((align & 7U) == 0U) {
+      in->SourceInc      = MDMA_SRC_INC_DOUBLEWORD;
+      in->DestinationInc = MDMA_DEST_INC_DOUBLEWORD;
+      in->SourceDataSize = MDMA_SRC_DATASIZE_DOUBLEWORD;
+      in->DestDataSize   = MDMA_DEST_DATASIZE_DOUBLEWORD;
+      in->SourceBurst    = MDMA_SOURCE_BURST_16BEATS;
+      in->DestBurst      = MDMA_DEST_BURST_16BEATS;
+   } else if ((align & 3U) == 0U) {
+      in->SourceInc      = MDMA_SRC_INC_WORD;
+      in->DestinationInc = MDMA_DEST_INC_WORD;
+      in->SourceDataSize = MDMA_SRC_DATASIZE_WORD;
+      in->DestDataSize   = MDMA_DEST_DATASIZE_WORD;
+      in->SourceBurst    = MDMA_SOURCE_BURST_SINGLE;
+      in->DestBurst      = MDMA_DEST_BURST_SINGLE;
+   } else {
+      in->SourceInc      = MDMA_SRC_INC_BYTE;
+      in->DestinationInc = MDMA_DEST_INC_BYTE;
+      in->SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+      in->DestDataSize   = MDMA_DEST_DATASIZE_BYTE;
+      in->SourceBurst    = MDMA_SOURCE_BURST_SINGLE;
+      in->DestBurst      = MDMA_DEST_BURST_SINGLE;
+   }
+   return HAL_MDMA_Init(&hmdma_cpy);
+}
+
+/* Start the next part of the head copy: as many whole blocks as one
+ * transfer takes, then the rest. */
+static int start(struct dma_req *r)
+{
+   const uint32_t done = r->len - r->left;
+   const uint32_t src  = (uint32_t)r->src + done;
+   const uint32_t dst  = (uint32_t)r->dst + done;
+   uint32_t block      = r->left;
+   uint32_t count      = 1U;
+   if (block > DMA_BLOCK) {
+      count = block / DMA_BLOCK;
+      if (count > DMA_COUNT)
+         count = DMA_COUNT;
+      block = DMA_BLOCK;
+   }
+
+   if (setup(src | dst | block) != HAL_OK)
+      return -1;
+   L1C_CleanInvalidateDCacheAll();
+   if (HAL_MDMA_Start_IT(&hmdma_cpy, src, dst, block, count) != HAL_OK)
+      return -1;
+   r->left -= block * count;
+   running = 1;
+   return 0;
+}
+
+static void finish(int status);
+
+/* Start the head copy if the channel is free; called with IRQs masked. */
+static void kick(void)
+{
+   if (!running && head != NULL && start(head) != 0)
+      finish(-1);
+}
+
+/* The head copy is over: unqueue it, start the next, then report. */
+static void finish(int status)
+{
+   struct dma_req *const r = head;
+   running                 = 0;
+   head                    = r->next;
+   if (head == NULL)
+      tail = NULL;
+   L1C_CleanInvalidateDCacheAll();
+   kick();
+
+   r->status = status;
+   if (r->done != NULL)
+      r->done(r);
+}
+
+static void xfer_cplt(MDMA_HandleTypeDef *h)
+{
+   (void)h;
+   if (head == NULL)
+      return;
+   if (head->left != 0U && start(head) == 0)
+      return;
+   finish((head->left == 0U) ? 0 : -1);
+}
+
+static void xfer_error(MDMA_HandleTypeDef *h)
+{
+   (void)h;
+   if (head != NULL)
+      finish(-1);
+}
+
+static HAL_StatusTypeDef dma_init(void)
+{
+   hmdma_cpy.Instance                      = MDMA_CH_COPY;
+   hmdma_cpy.Init.Request                  = MDMA_REQUEST_SW;
+   hmdma_cpy.Init.TransferTriggerMode      = MDMA_FULL_TRANSFER;
+   hmdma_cpy.Init.Priority                 = MDMA_PRIORITY_HIGH;
+   hmdma_cpy.Init.SecureMode               = MDMA_SECURE_MODE_DISABLE;
+   hmdma_cpy.Init.Endianness               = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+   hmdma_cpy.Init.DataAlignment            = MDMA_DATAALIGN_PACKENABLE;
+   hmdma_cpy.Init.BufferTransferLength     = 128U;
+   hmdma_cpy.Init.SourceBlockAddressOffset = 0;
+   hmdma_cpy.Init.DestBlockAddressOffset   = 0;
+   if (setup(0U) != HAL_OK)
+      return HAL_ERROR;
+   hmdma_cpy.XferCpltCallback  = xfer_cplt;
+   hmdma_cpy.XferErrorCallback = xfer_error;
+
+   IRQ_SetPriority(MDMA_IRQn, PRIO_DMA);
+   IRQ_Enable(MDMA_IRQn);
+   return HAL_OK;
+}
+
+int dma_memcpy(struct dma_req *r)
+{
+   if (r->len == 0U || r->status == DMA_BUSY)
+      return -1;
+
+   __HAL_RCC_MDMA_CLK_ENABLE();
+   if (!dma_ready && dma_init() == HAL_OK)
+      dma_ready = 1;
+   if (!dma_ready)
+      return -1;
+
+   r->status = DMA_BUSY;
+   r->left   = r->len;
+   r->next   = NULL;
+
+   const uint32_t cpsr = irq_save();
+   if (tail != NULL)
+      tail->next = r;
+   else
+      head = r;
+   tail = r;
+   kick();
+   irq_restore(cpsr);
+   return 0;
+}
+
+/* Stop the channel and fail every queued copy. */
+static void abort_all(void)
+{
+   const uint32_t cpsr = irq_save();
+   (void)HAL_MDMA_Abort(&hmdma_cpy);
+   running = 0;
+   while (head != NULL) {
+      struct dma_req *const r = head;
+      head                    = r->next;
+      r->status               = -1;
+      if (r->done != NULL)
+         r->done(r);
+   }
+   tail = NULL;
+   L1C_CleanInvalidateDCacheAll();
+   irq_restore(cpsr);
+}
+
+int dma_wait(struct dma_req *r)
+{
+   const uint32_t ms = 1000U + r->len / (100U * 1000U);
+   const uint32_t t0 = HAL_GetTick();
+   while (r->status == DMA_BUSY) {
+      /* the handler checks the flags itself, so this is harmless when the
+       * interrupt is taken as well */
+      const uint32_t cpsr = irq_save();
+      HAL_MDMA_IRQHandler(&hmdma_cpy);
+      irq_restore(cpsr);
+
+      if (r->status == DMA_BUSY && HAL_GetTick() - t0 > ms) {
+         my_printf("dma: copy to 0x%08lx timed out\r\n",
+                   (unsigned long)r->dst);
+         abort_all();
+      }
+   }
+   return r->status;
+}
+
+void dma_copy(void *dst, const void *src, uint32_t len)
+{
+   struct dma_req r = {.dst = dst, .src = src, .len = len};
+   if (len == 0U)
+      return;
+   if (dma_memcpy(&r) != 0 || dma_wait(&r) != 0) {
+      my_printf("dma: copy failed, using memcpy\r\n");
+      memcpy(dst, src, len);
+   }
+}
+
+// end file dma.c
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file dma.h
+ * @brief Memory-to-memory copies on an MDMA channel
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Copies are queued and run in order on MDMA_CH_COPY, each started from
+ * the completion interrupt of the one before, so a chain of copies runs
+ * while the CPU reads storage or patches the DTB.  MDMA reads and writes
+ * DDR, not the caches: the caches are cleaned before each copy starts and
+ * again when it ends, so neither buffer may be touched until then.
+ */
+
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+
+#define DMA_BUSY 1
+
+struct dma_req {
+   void *dst;
+   const void *src; /* must not overlap dst */
+   uint32_t len;
+   void (*done)(struct dma_req *r); /* if set, called in the interrupt */
+   volatile int status;             /* DMA_BUSY, then 0 or -1 */
+   struct dma_req *next;            /* private */
+   uint32_t left;                   /* private */
+};
+
+/* Queue r, which must stay in place until it is no longer DMA_BUSY.
+ * Returns 0, or -1 if len is 0 or r is already queued. */
+int dma_memcpy(struct dma_req *r);
+
+/* Wait for r, as long as the copy could take at 100 MB/s plus a second;
+ * past that the channel is stopped and every queued copy fails.  Works
+ * with interrupts masked.  Returns r->status. */
+int dma_wait(struct dma_req *r);
+
+/* Copy len bytes and wait, falling back to memcpy if the MDMA fails. */
+void dma_copy(void *dst, const void *src, uint32_t len);
+
+#endif // DMA_H
+
+// end file dma.h
@@ -9,9 +9,7 @@
 
 #include "dtb.h"
 #include "board.h"
-
-#ifdef NAND_FLASH
-
+#include "ddr_map.h"
 #include "defaults.h"
 #include "printf.h"
 #include <stdint.h>
@@ -41,6 +39,8 @@ static inline void fdt_put_be32(uint32_t *p, uint32_t v)
    b[3]       = (uint8_t)v;
 }
 
+#if defined(NAND_FLASH) || defined(FASTBOOT)
+
 /*
  * Remove UBI boot tokens from bootargs string in-place.
  * Drops: "ubi.mtd=rootfs", "root=ubi0:rootfs", "rootfstype=ubifs".
@@ -205,9 +205,225 @@ int dtb_patch_initrd(uint32_t initrd_start, uint32_t initrd_end)
    return 0;
 }
 
-#endif /* NAND_FLASH */
+#endif /* NAND_FLASH || FASTBOOT */
+
+/* Offset of s in the strings block, appended there if missing.  The strings
+ * block must be the last one, as dtc writes it. */
+static int fdt_string(uint8_t *fdt, const char *s, uint32_t *off)
+{
+   const uint32_t total    = fdt_be32((uint32_t *)fdt + 1);
+   const uint32_t off_str  = fdt_be32((uint32_t *)fdt + 3);
+   const uint32_t size_str = fdt_be32((uint32_t *)fdt + 8);
+   char *tab               = (char *)fdt + off_str;
+
+   for (uint32_t i = 0; i < size_str; i += strlen(tab + i) + 1U) {
+      if (strcmp(tab + i, s) == 0) {
+         *off = i;
+         return 0;
+      }
+   }
+   if (off_str + size_str > total)
+      return -1;
+
+   const uint32_t len = strlen(s) + 1U;
+   memcpy(tab + size_str, s, len);
+   fdt_put_be32((uint32_t *)fdt + 8, size_str + len);
+   if (off_str + size_str + len > total)
+      fdt_put_be32((uint32_t *)fdt + 1, off_str + size_str + len);
+   *off = size_str;
+   return 0;
+}
+
+/* Append a NUL-terminated, zero-padded name to a structure block buffer. */
+static uint32_t fdt_put_name(uint32_t *w, const char *name)
+{
+   const uint32_t len   = strlen(name) + 1U;
+   const uint32_t words = (len + 3U) / 4U;
+   w[words - 1U]        = 0U;
+   memcpy(w, name, len);
+   return words;
+}
+
+static uint32_t fdt_put_prop(uint32_t *w, uint32_t nameoff, const uint32_t *val,
+                             uint32_t ncells)
+{
+   fdt_put_be32(w, FDT_PROP);
+   fdt_put_be32(w + 1, ncells * 4U);
+   fdt_put_be32(w + 2, nameoff);
+   for (uint32_t i = 0; i < ncells; i++)
+      fdt_put_be32(w + 3 + i, val[i]);
+   return 3U + ncells;
+}
+
+/* "name@addr", with the unit address in lowercase hex as dtc wants it. */
+static void unit_name(char *buf, const char *name, uint32_t addr)
+{
+   const size_t n = strlen(name);
+   memcpy(buf, name, n);
+   buf[n] = '@';
+
+   int shift = 28;
+   while (shift > 0 && ((addr >> (uint32_t)shift) & 0xFU) == 0U)
+      shift -= 4;
+   char *p = buf + n + 1;
+   for (; shift >= 0; shift -= 4)
+      *p++ = "0123456789abcdef"[(addr >> (uint32_t)shift) & 0xFU];
+   *p = '\0';
+}
+
+/* Walk the structure block for the spot to insert the new node: the end of
+ * /reserved-memory, or of the root node if there is none.  Returns 1 if the
+ * node is already there, -1 if the tree is not one we can patch. */
+static int find_resv(uint32_t *p, const char *strtab, const char *node,
+                     uint32_t **at, int *have_resv)
+{
+   uint32_t *root_end = NULL;
+   uint32_t *resv_end = NULL;
+   int depth          = 0;
+   int in_resv        = 0;
+
+   for (;;) {
+      const uint32_t tok = fdt_be32(p++);
+
+      if (tok == FDT_END)
+         break;
+
+      if (tok == FDT_NOP)
+         continue;
+
+      if (tok == FDT_BEGIN_NODE) {
+         const char *name = (const char *)p;
+         if (depth == 1 && strcmp(name, "reserved-memory") == 0)
+            in_resv = 1;
+         if (in_resv && depth == 2 && strcmp(name, node) == 0)
+            return 1;
+         depth++;
+         p += (strlen(name) + 4U) / 4U;
+         continue;
+      }
 
-/* Suppress -Wpedantic empty translation unit warning. */
-typedef int dtb_dummy;
+      if (tok == FDT_END_NODE) {
+         depth--;
+         if (in_resv && depth == 1) {
+            resv_end = p - 1;
+            in_resv  = 0;
+         }
+         if (depth == 0)
+            root_end = p - 1;
+         continue;
+      }
+
+      if (tok == FDT_PROP) {
+         const uint32_t plen = fdt_be32(p++);
+         const char *pname   = strtab + fdt_be32(p++);
+         /* reg below is written with one address and one size cell */
+         if (in_resv && depth == 2 &&
+             (strcmp(pname, "#address-cells") == 0 ||
+              strcmp(pname, "#size-cells") == 0) &&
+             (plen != 4U || fdt_be32(p) != 1U))
+            return -1;
+         p += (plen + 3U) / 4U;
+         continue;
+      }
+
+      return -1; /* unknown token */
+   }
+
+   *have_resv = (resv_end != NULL);
+   *at        = (resv_end != NULL) ? resv_end : root_end;
+   return (*at != NULL) ? 0 : -1;
+}
+
+int dtb_reserve(const char *name, uint32_t addr, uint32_t size)
+{
+   uint8_t *fdt = (uint8_t *)DEF_DTB_ADDR;
+   uint32_t *h  = (uint32_t *)fdt;
+
+   if (fdt_be32(h) != FDT_MAGIC)
+      return -1;
+
+   /* FDT header: [1] totalsize [2] off_dt_struct [3] off_dt_strings
+    * [4] off_mem_rsvmap [5] version [8] size_dt_strings [9] size_dt_struct;
+    * the struct block is moved up in place, so it must follow the
+    * reservation map and precede the strings. */
+   const uint32_t off_struct  = fdt_be32(h + 2);
+   const uint32_t off_strings = fdt_be32(h + 3);
+   const uint32_t size_struct = fdt_be32(h + 9);
+   if (fdt_be32(h + 5) < 17U || fdt_be32(h + 4) > off_struct ||
+       off_struct + size_struct > off_strings) {
+      my_printf("dtb_reserve: unsupported FDT layout\r\n");
+      return -1;
+   }
+
+   char node[32];
+   unit_name(node, name, addr);
+
+   uint32_t *at  = NULL;
+   int have_resv = 0;
+   const int r   = find_resv((uint32_t *)(fdt + off_struct),
+                             (const char *)fdt + off_strings, node, &at,
+                             &have_resv);
+   if (r == 1)
+      return 0;
+   if (r < 0) {
+      my_printf("dtb_reserve: cannot add %s\r\n", node);
+      return -1;
+   }
+
+   uint32_t s_acells = 0U;
+   uint32_t s_scells = 0U;
+   uint32_t s_ranges = 0U;
+   uint32_t s_reg    = 0U;
+   uint32_t s_nomap  = 0U;
+   if (fdt_string(fdt, "#address-cells", &s_acells) != 0 ||
+       fdt_string(fdt, "#size-cells", &s_scells) != 0 ||
+       fdt_string(fdt, "ranges", &s_ranges) != 0 ||
+       fdt_string(fdt, "reg", &s_reg) != 0 ||
+       fdt_string(fdt, "no-map", &s_nomap) != 0) {
+      my_printf("dtb_reserve: unsupported FDT layout\r\n");
+      return -1;
+   }
+
+   uint32_t w[48];
+   uint32_t n            = 0U;
+   const uint32_t one    = 1U;
+   const uint32_t reg[2] = {addr, size};
+   if (!have_resv) {
+      fdt_put_be32(&w[n++], FDT_BEGIN_NODE);
+      n += fdt_put_name(&w[n], "reserved-memory");
+      n += fdt_put_prop(&w[n], s_acells, &one, 1U);
+      n += fdt_put_prop(&w[n], s_scells, &one, 1U);
+      n += fdt_put_prop(&w[n], s_ranges, NULL, 0U);
+   }
+   fdt_put_be32(&w[n++], FDT_BEGIN_NODE);
+   n += fdt_put_name(&w[n], node);
+   n += fdt_put_prop(&w[n], s_reg, reg, 2U);
+   n += fdt_put_prop(&w[n], s_nomap, NULL, 0U);
+   fdt_put_be32(&w[n++], FDT_END_NODE);
+   if (!have_resv)
+      fdt_put_be32(&w[n++], FDT_END_NODE);
+
+   /* Open a gap for the node and shift the rest of the blob up. */
+   const uint32_t len   = n * 4U;
+   const uint32_t total = fdt_be32(h + 1);
+   uint8_t *gap         = (uint8_t *)at;
+   memmove(gap + len, gap, (size_t)(fdt + total - gap));
+   memcpy(gap, w, len);
+   fdt_put_be32(h + 1, total + len);
+   fdt_put_be32(h + 3, off_strings + len);
+   fdt_put_be32(h + 9, size_struct + len);
+   return 0;
+}
+
+int dtb_claim(void)
+{
+   const uint32_t *h = (const uint32_t *)DEF_DTB_ADDR;
+   if (fdt_be32(h) != FDT_MAGIC) {
+      my_printf("dtb: bad FDT magic\r\n");
+      return -1;
+   }
+   return ddr_map_reserve("dtb", DEF_DTB_ADDR, fdt_be32(h + 1) + DTB_GROW,
+                          0U);
+}
 
 // end file dtb.c
@@ -22,6 +22,23 @@
  */
 int dtb_patch_initrd(uint32_t initrd_start, uint32_t initrd_end);
 
+/*
+ * Add /reserved-memory/name@addr { reg = <addr size>; no-map; } to the DTB
+ * at DEF_DTB_ADDR, creating /reserved-memory if needed, so the kernel keeps
+ * its hands off the region.  The blob grows in place by a few hundred bytes
+ * at most.  Does nothing if the node is already there.  Returns 0 on
+ * success, -1 if there is no DTB or it cannot be patched.
+ */
+int dtb_reserve(const char *name, uint32_t addr, uint32_t size);
+
+/*
+ * Enter the DTB at DEF_DTB_ADDR in the DDR map as "dtb", sized from its
+ * header plus DTB_GROW for what dtb_reserve may add.  Returns 0, or -1 if
+ * there is no DTB or it runs into another region.
+ */
+#define DTB_GROW 0x1000U
+int dtb_claim(void);
+
 #endif /* DTB_H */
 
 // end file dtb.h
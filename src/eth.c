@@ -13,6 +13,7 @@
 #ifdef ETHERNET
 #include "board.h"
 
+#include "defaults.h"
 #include "irq.h"
 #include "irq_ctrl.h"
 #include "printf.h"
@@ -162,9 +163,47 @@ __attribute__((
     aligned(32))) static ETH_DMADescTypeDef rx_dma_desc[ETH_RX_DESC_CNT];
 __attribute__((
     aligned(32))) static ETH_DMADescTypeDef tx_dma_desc[ETH_TX_DESC_CNT];
-__attribute__((aligned(32))) static uint8_t tx_buf[1536];
 __attribute__((aligned(32))) static ETH_BufferTypeDef tx_buf_desc;
 
+/* Frame buffers live in cacheable DDR; each is a whole number of cache lines,
+ * so maintaining one never touches another.  RX has spares so that frames
+ * held by the network stack do not starve the ring. */
+#define ETH_BUF_SIZE 1536U
+#define ETH_RX_BUFS  (ETH_RX_DESC_CNT + 8U)
+#define ETH_TX_BUFS  ETH_TX_DESC_CNT
+#define CACHE_LINE   64U
+
+#if (ETH_RX_BUFS + ETH_TX_BUFS) * ETH_BUF_SIZE > DEF_ETH_BUF_SIZE
+#error "ETH frame buffers do not fit DEF_ETH_BUF_SIZE"
+#endif
+
+static uint8_t mac_addr[6] = {
+    ETH_MAC_ADDR0, ETH_MAC_ADDR1, ETH_MAC_ADDR2,
+    ETH_MAC_ADDR3, ETH_MAC_ADDR4, ETH_MAC_ADDR5,
+};
+
+static uint8_t *rx_free[ETH_RX_BUFS];
+static uint32_t rx_free_cnt;
+static uint16_t rx_len; /* length of the frame being linked, 0 to drop it */
+static uint8_t *tx_free[ETH_TX_BUFS];
+static uint32_t tx_free_cnt;
+
+/* PHY bring-up, advanced by eth_poll(). */
+enum phy_state {
+   PHY_OFF,       /* not started, or failed */
+   PHY_RESET,     /* soft reset issued */
+   PHY_LINK_WAIT, /* auto-negotiating, or cable out */
+   PHY_LINK_UP,   /* MAC started */
+};
+
+#define PHY_POLL_MS  10U  /* link checks while waiting for it */
+#define LINK_POLL_MS 250U /* link checks once it is up */
+
+static enum phy_state phy_state = PHY_OFF;
+static uint32_t phy_t0; /* entry to the current state */
+static uint32_t phy_t_poll;
+static void (*link_fn)(int up);
+
 static void eth_pin_init(void)
 {
    GPIO_InitTypeDef init = {0};
@@ -230,54 +269,45 @@ static void eth_pin_init(void)
 }
 
 /**
- * @brief Initialize LAN8742 PHY over MDIO.
+ * @brief Start the LAN8742 PHY bring-up over MDIO.
  *
- * Performs a software reset, enables auto-negotiation, and verifies
- * that the PHY responds over MDIO. Does not wait for link-up,
- * so can be called with no cable connected.
+ * Only issues the software reset; eth_poll() waits for it to finish,
+ * checks the PHY ID, enables auto-negotiation and then follows the link.
+ * Nothing here waits, so Ethernet costs no boot time with or without a
+ * cable.
  *
- * @retval 0  PHY responded over MDIO, initialization complete.
+ * @retval 0  Reset issued.
  * @retval -1 MDIO access failed.
  */
-static int eth_phy_init(void)
+static int eth_phy_start(void)
 {
-   uint32_t v   = 0;
-   uint32_t id1 = 0;
-   uint32_t id2 = 0;
-   uint32_t t0  = 0;
-
    HAL_ETH_SetMDIOClockRange(&eth_handle);
 
-   /* Reset PHY */
    if (HAL_ETH_WritePHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_BCR,
                                 LAN8742_BCR_SOFT_RESET) != HAL_OK) {
       my_printf("PHY reset write failed\r\n");
       return -1;
    }
+   phy_state = PHY_RESET;
+   phy_t0    = HAL_GetTick();
+   return 0;
+}
 
-   /* Wait for reset to complete (typically a few ms) */
-   t0 = HAL_GetTick();
-   do {
-      if (HAL_ETH_ReadPHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_BCR, &v) !=
-          HAL_OK) {
-         my_printf("PHY BCR read failed\r\n");
-         return -1;
-      }
-      if ((HAL_GetTick() - t0) > ETH_TIMEOUT_MS) {
-         my_printf("PHY reset timeout\r\n");
-         return -1;
-      }
-   } while (v & LAN8742_BCR_SOFT_RESET);
+/* The soft reset has cleared: check the PHY is the expected one and let it
+ * negotiate. */
+static int eth_phy_configure(uint32_t bcr)
+{
+   uint32_t id1 = 0;
+   uint32_t id2 = 0;
 
    /* Enable auto-negotiation */
-   v |= LAN8742_BCR_AUTONEGO_EN;
-   if (HAL_ETH_WritePHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_BCR, v) !=
-       HAL_OK) {
+   if (HAL_ETH_WritePHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_BCR,
+                                bcr | LAN8742_BCR_AUTONEGO_EN) != HAL_OK) {
       my_printf("Enable auto-negotiation failed\r\n");
       return -1;
    }
 
-   /* Optional: read PHY ID to verify MDIO communication */
+   /* Read PHY ID to verify MDIO communication */
    if (HAL_ETH_ReadPHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_PHYI1R,
                                &id1) != HAL_OK ||
        HAL_ETH_ReadPHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_PHYI2R,
@@ -296,13 +326,112 @@ static int eth_phy_init(void)
    return 0;
 }
 
-static void eth_desc_init(void)
+/* Link came up: match the MAC to what was negotiated and start it. */
+static void eth_link_start(void)
+{
+   uint32_t scsr = 0;
+   if (HAL_ETH_ReadPHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_PHYSCSR,
+                               &scsr) != HAL_OK)
+      return;
+   const int speed_100 =
+       (scsr & (LAN8742_PHYSCSR_100BTX_FD | LAN8742_PHYSCSR_100BTX_HD)) != 0U;
+   const int full_duplex =
+       (scsr & (LAN8742_PHYSCSR_10BT_FD | LAN8742_PHYSCSR_100BTX_FD)) != 0U;
+
+   ETH_MACConfigTypeDef mac = {0};
+   (void)HAL_ETH_GetMACConfig(&eth_handle, &mac);
+   mac.Speed      = speed_100 ? ETH_SPEED_100M : ETH_SPEED_10M;
+   mac.DuplexMode = full_duplex ? ETH_FULLDUPLEX_MODE : ETH_HALFDUPLEX_MODE;
+   (void)HAL_ETH_SetMACConfig(&eth_handle, &mac);
+   HAL_ETH_Start(&eth_handle);
+
+   phy_state = PHY_LINK_UP;
+   my_printf("Ethernet link up, %s Mb/s %s duplex (%lu ms)\r\n",
+             speed_100 ? "100" : "10", full_duplex ? "full" : "half",
+             (unsigned long)(HAL_GetTick() - phy_t0));
+   if (link_fn != NULL)
+      link_fn(1);
+}
+
+void eth_poll(void)
 {
-   static uint8_t mac[6] = {
-       ETH_MAC_ADDR0, ETH_MAC_ADDR1, ETH_MAC_ADDR2,
-       ETH_MAC_ADDR3, ETH_MAC_ADDR4, ETH_MAC_ADDR5,
-   };
+   const uint32_t now = HAL_GetTick();
+   uint32_t v         = 0;
+
+   switch (phy_state) {
+      case PHY_RESET:
+         if (HAL_ETH_ReadPHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_BCR,
+                                     &v) != HAL_OK) {
+            my_printf("PHY BCR read failed\r\n");
+            phy_state = PHY_OFF;
+         } else if ((v & LAN8742_BCR_SOFT_RESET) == 0U) {
+            phy_state  = (eth_phy_configure(v) == 0) ? PHY_LINK_WAIT : PHY_OFF;
+            phy_t0     = now;
+            phy_t_poll = now;
+         } else if (now - phy_t0 > ETH_TIMEOUT_MS) {
+            my_printf("PHY reset timeout\r\n");
+            phy_state = PHY_OFF;
+         }
+         break;
+
+      case PHY_LINK_WAIT:
+      case PHY_LINK_UP:
+         /* MDIO reads take tens of microseconds; don't spend them on every
+          * pass of the main loop. */
+         if (now - phy_t_poll <
+             ((phy_state == PHY_LINK_UP) ? LINK_POLL_MS : PHY_POLL_MS))
+            break;
+         phy_t_poll = now;
+         if (HAL_ETH_ReadPHYRegister(&eth_handle, LAN8742_ADDR, LAN8742_BSR,
+                                     &v) != HAL_OK)
+            break;
+         if (phy_state == PHY_LINK_WAIT &&
+             (v & LAN8742_BSR_LINK_STATUS) != 0U &&
+             (v & LAN8742_BSR_AUTONEGO_CPLT) != 0U) {
+            eth_link_start();
+         } else if (phy_state == PHY_LINK_UP &&
+                    (v & LAN8742_BSR_LINK_STATUS) == 0U) {
+            HAL_ETH_Stop(&eth_handle);
+            phy_state = PHY_LINK_WAIT;
+            phy_t0    = now;
+            my_printf("Ethernet link down\r\n");
+            if (link_fn != NULL)
+               link_fn(0);
+         }
+         break;
+
+      default: break;
+   }
+}
+
+int eth_link_up(void)
+{
+   return phy_state == PHY_LINK_UP;
+}
+
+void eth_on_link(void (*fn)(int up))
+{
+   link_fn = fn;
+}
+
+static void dcache_clean(const uint8_t *p, uint32_t len)
+{
+   const uint32_t end = (uint32_t)p + len;
+   for (uint32_t a = (uint32_t)p & ~(CACHE_LINE - 1U); a < end; a += CACHE_LINE)
+      L1C_CleanDCacheMVA((void *)a);
+   __DSB();
+}
+
+static void dcache_invalidate(const uint8_t *p, uint32_t len)
+{
+   const uint32_t end = (uint32_t)p + len;
+   for (uint32_t a = (uint32_t)p & ~(CACHE_LINE - 1U); a < end; a += CACHE_LINE)
+      L1C_InvalidateDCacheMVA((void *)a);
+   __DSB();
+}
 
+static void eth_desc_init(void)
+{
    memset(&tx_conf, 0, sizeof(ETH_TxPacketConfigTypeDef));
    tx_conf.Attributes =
        ETH_TX_PACKETS_FEATURES_CSUM | ETH_TX_PACKETS_FEATURES_CRCPAD;
@@ -310,16 +439,27 @@ static void eth_desc_init(void)
    tx_conf.CRCPadCtrl   = ETH_CRC_PAD_INSERT;
 
    memset(&tx_buf_desc, 0, sizeof(tx_buf_desc));
-   tx_buf_desc.buffer = tx_buf;
-   tx_buf_desc.next   = NULL;
-   tx_conf.TxBuffer   = &tx_buf_desc;
+   tx_conf.TxBuffer = &tx_buf_desc;
+
+   /* Nothing but the DMA writes the RX buffers, so they only ever need
+    * invalidating; start them out with no lines in the cache at all. */
+   uint8_t *buf = (uint8_t *)DEF_ETH_BUF_ADDR;
+   dcache_invalidate(buf, (ETH_RX_BUFS + ETH_TX_BUFS) * ETH_BUF_SIZE);
+   for (rx_free_cnt = 0U; rx_free_cnt < ETH_RX_BUFS; rx_free_cnt++) {
+      rx_free[rx_free_cnt] = buf;
+      buf += ETH_BUF_SIZE;
+   }
+   for (tx_free_cnt = 0U; tx_free_cnt < ETH_TX_BUFS; tx_free_cnt++) {
+      tx_free[tx_free_cnt] = buf;
+      buf += ETH_BUF_SIZE;
+   }
 
    eth_handle.Instance            = ETH;
-   eth_handle.Init.MACAddr        = &mac[0];
+   eth_handle.Init.MACAddr        = &mac_addr[0];
    eth_handle.Init.MediaInterface = HAL_ETH_RMII_MODE;
    eth_handle.Init.TxDesc         = tx_dma_desc;
    eth_handle.Init.RxDesc         = rx_dma_desc;
-   eth_handle.Init.RxBuffLen      = 1536;
+   eth_handle.Init.RxBuffLen      = ETH_BUF_SIZE;
    eth_handle.Init.ClockSelection = ETH_CLK_SRC;
 }
 
@@ -342,12 +482,9 @@ void eth_init(void)
    IRQ_SetPriority(ETH1_IRQn, PRIO_ETH);
    IRQ_Enable(ETH1_IRQn);
 
-   if (eth_phy_init() != 0) {
-      my_printf("eth_phy_init() != 0\r\n");
-      return;
-   }
-
-   HAL_ETH_Start(&eth_handle);
+   /* The MAC is started by eth_poll() once the link is up. */
+   if (eth_phy_start() != 0)
+      my_printf("eth_phy_start() != 0\r\n");
 }
 
 void eth_status(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
@@ -453,6 +590,127 @@ void eth_status(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    my_printf("SYSCFG_PMCSETR = 0x%04" PRIX32 "\r\n", SYSCFG->PMCSETR);
 }
 
+const uint8_t *eth_mac_addr(void)
+{
+   return mac_addr;
+}
+
+void eth_rx_drops(uint32_t *fifo, uint32_t *no_desc)
+{
+   /* Both counters clear on read. */
+   const uint32_t r = ETH->MTLRXQ0MPOCR;
+   *fifo            = _FLD2VAL(ETH_MTLRXQ0MPOCR_OVFPKTCNT, r);
+   *no_desc         = _FLD2VAL(ETH_MTLRXQ0MPOCR_MISPKTCNT, r);
+}
+
+/* Hash filter bin of a multicast address: the top 6 bits of its bit-reversed
+ * Ethernet CRC. */
+static uint32_t mcast_bin(const uint8_t *group)
+{
+   uint32_t crc = 0xFFFFFFFFU;
+   for (uint32_t i = 0; i < 6U; i++) {
+      crc ^= group[i];
+      for (uint32_t b = 0; b < 8U; b++)
+         crc = (crc >> 1) ^ ((crc & 1U) ? 0xEDB88320U : 0U);
+   }
+   return __RBIT(~crc) >> 26;
+}
+
+void eth_mcast_filter(const uint8_t *group)
+{
+   uint32_t hash[2]             = {0U, 0U};
+   ETH_MACFilterConfigTypeDef f = {0};
+   (void)HAL_ETH_GetMACFilterConfig(&eth_handle, &f);
+   if (group != NULL) {
+      const uint32_t bin = mcast_bin(group);
+      hash[bin >> 5]     = 1UL << (bin & 31U);
+   }
+   f.HashMulticast    = (group != NULL) ? ENABLE : DISABLE;
+   f.PassAllMulticast = DISABLE;
+   (void)HAL_ETH_SetHashTable(&eth_handle, hash);
+   (void)HAL_ETH_SetMACFilterConfig(&eth_handle, &f);
+}
+
+/* HAL: a descriptor needs a buffer.  Leaving *buff NULL keeps the descriptor
+ * unbuilt; HAL_ETH_ReadData() retries it on the next call. */
+void HAL_ETH_RxAllocateCallback(ETH_HandleTypeDef *heth, uint8_t **buff)
+{
+   (void)heth;
+   *buff = (rx_free_cnt > 0U) ? rx_free[--rx_free_cnt] : NULL;
+}
+
+/* HAL: a descriptor of the current frame is complete.  Every frame fits one
+ * buffer, so a second one means something oversized: drop it all. */
+void HAL_ETH_RxLinkCallback(ETH_HandleTypeDef *heth, void **pStart, void **pEnd,
+                            uint8_t *buff, uint16_t Length)
+{
+   (void)heth;
+   if (*pStart == NULL) {
+      *pStart = buff;
+      rx_len  = Length;
+   } else {
+      rx_free[rx_free_cnt++] = buff;
+      rx_len                 = 0U;
+   }
+   *pEnd = buff;
+}
+
+/* HAL: a queued frame has gone out. */
+void HAL_ETH_TxFreeCallback(ETH_HandleTypeDef *heth, uint32_t *buff)
+{
+   (void)heth;
+   tx_free[tx_free_cnt++] = (uint8_t *)buff;
+}
+
+const uint8_t *eth_rx(uint16_t *len)
+{
+   void *frame = NULL;
+   if (HAL_ETH_ReadData(&eth_handle, &frame) != HAL_OK)
+      return NULL;
+   if (rx_len == 0U) {
+      eth_rx_done(frame);
+      return NULL;
+   }
+   dcache_invalidate(frame, rx_len);
+   *len = rx_len;
+   return frame;
+}
+
+void eth_rx_done(const uint8_t *frame)
+{
+   rx_free[rx_free_cnt++] = (uint8_t *)frame;
+}
+
+uint8_t *eth_tx_alloc(void)
+{
+   (void)HAL_ETH_ReleaseTxPacket(&eth_handle);
+   return (tx_free_cnt > 0U) ? tx_free[--tx_free_cnt] : NULL;
+}
+
+void eth_tx_drop(uint8_t *frame)
+{
+   tx_free[tx_free_cnt++] = frame;
+}
+
+int eth_tx(uint8_t *frame, uint16_t len)
+{
+   dcache_clean(frame, len);
+
+   tx_buf_desc.buffer = frame;
+   tx_buf_desc.len    = len;
+   tx_buf_desc.next   = NULL;
+   tx_conf.Length     = len;
+   tx_conf.pData      = frame;
+
+   /* Does not wait: the buffer comes back through HAL_ETH_TxFreeCallback()
+    * once the DMA is done with it. */
+   if (HAL_ETH_Transmit_IT(&eth_handle, &tx_conf) != HAL_OK) {
+      eth_tx_drop(frame);
+      return -1;
+   }
+   return 0;
+}
+
 static uint16_t build_test_frame(uint8_t *buf)
 {
    uint32_t i = 0;
@@ -463,10 +721,8 @@ static uint16_t build_test_frame(uint8_t *buf)
    i += sizeof(dst);
 
    // Source MAC: our MAC
-   const uint8_t src[6] = {ETH_MAC_ADDR0, ETH_MAC_ADDR1, ETH_MAC_ADDR2,
-                           ETH_MAC_ADDR3, ETH_MAC_ADDR4, ETH_MAC_ADDR5};
-   memcpy(&buf[i], src, sizeof(src));
-   i += sizeof(src);
+   memcpy(&buf[i], mac_addr, sizeof(mac_addr));
+   i += sizeof(mac_addr);
 
    // Ethertype
    const uint16_t ethertype = 0x88B5;
@@ -493,19 +749,14 @@ void eth_send_test_frame(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    (void)arg2;
    (void)arg3;
 
-   // Build frame in TX buffer
-   const uint16_t len = build_test_frame(tx_buf);
-
-   // Set up buffer descriptor
-   tx_buf_desc.buffer = tx_buf;
-   tx_buf_desc.len    = len;
-   tx_buf_desc.next   = NULL;
-   tx_conf.TxBuffer   = &tx_buf_desc;
-   tx_conf.Length     = len;
+   uint8_t *buf = eth_tx_alloc();
+   if (buf == NULL) {
+      my_printf("No free TX buffer\r\n");
+      return;
+   }
 
-   // Transmit
-   if (HAL_ETH_Transmit(&eth_handle, &tx_conf, ETH_TIMEOUT_MS) != HAL_OK) {
-      my_printf("HAL_ETH_Transmit failed\r\n");
+   if (eth_tx(buf, build_test_frame(buf)) != 0) {
+      my_printf("HAL_ETH_Transmit_IT failed\r\n");
       return;
    }
 
@@ -518,6 +769,10 @@ void eth_init(void)
 {
 }
 
+void eth_poll(void)
+{
+}
+
 void eth_status(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
 {
    (void)argc;
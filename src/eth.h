@@ -12,10 +12,46 @@
 
 #include <stdint.h>
 
+/* eth_init() only starts the PHY reset and returns; eth_poll(), called
+ * from the main loop (net_poll() does so too), finishes the bring-up,
+ * starts the MAC at the negotiated speed once the link is up, and follows
+ * the link from then on. */
 void eth_init(void);
+void eth_poll(void);
+int eth_link_up(void);
+
+/* Have fn(1) called from eth_poll() once the link is up and the MAC
+ * started, and fn(0) when it goes down; NULL for none.  One listener. */
+void eth_on_link(void (*fn)(int up));
 void eth_status(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void eth_send_test_frame(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 
+/* Frames are handed out straight from the DMA rings, without copying.  All
+ * of these are for the main loop only. */
+
+const uint8_t *eth_mac_addr(void);
+
+/* Also receive frames sent to one multicast group address; NULL for none. */
+void eth_mcast_filter(const uint8_t *group);
+
+/* Frames the MAC dropped since the last call: RX FIFO overflows, and frames
+ * that found no free RX descriptor. */
+void eth_rx_drops(uint32_t *fifo, uint32_t *no_desc);
+
+/* Next received frame, or NULL.  The MAC has already dropped frames with a
+ * bad FCS or IPv4/UDP/ICMP checksum.  The buffer belongs to the caller until
+ * eth_rx_done(). */
+const uint8_t *eth_rx(uint16_t *len);
+void eth_rx_done(const uint8_t *frame);
+
+/* A free TX frame buffer (1536 bytes), or NULL while all of them are in
+ * flight.  eth_tx() queues it without waiting and takes it back once sent,
+ * also on failure; eth_tx_drop() returns one unsent.  The MAC pads short
+ * frames and inserts the IPv4 header and payload checksums. */
+uint8_t *eth_tx_alloc(void);
+int eth_tx(uint8_t *frame, uint16_t len);
+void eth_tx_drop(uint8_t *frame);
+
 #endif // ETH_H
 
 // end file eth.h
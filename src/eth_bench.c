@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file eth_bench.c
+ * @brief Ethernet throughput and latency benchmark
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "eth_bench.h"
+#include <stdint.h>
+
+#ifdef ETHERNET
+#include "console.h"
+#include "defaults.h"
+#include "eth.h"
+#include "net.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include <string.h>
+
+#define EB_ETHERTYPE 0x88B6U
+#define EB_HDR       12U
+#define EB_MIN       60U
+#define EB_MAX       1514U
+#define EB_WIRE      24U /* preamble, FCS and inter-frame gap */
+
+#define OP_DATA 1U
+#define OP_PING 2U
+#define OP_PONG 3U
+
+#define PING_TIMEOUT 100000U /* us */
+#define HIST_BINS    11U     /* < 16 us, then doubling up to >= 8192 us */
+
+static uint8_t peer[6] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+
+/* Receive side of the current mode. */
+static struct {
+   uint32_t frames;
+   uint64_t bytes;
+   uint32_t first_seq;
+   uint32_t last_seq;
+   uint32_t t_first;
+   uint32_t pong_seq;
+   int got_pong;
+   uint32_t echoed;
+} rx;
+
+static uint32_t get32(const uint8_t *p)
+{
+   return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+          ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+   p[0] = (uint8_t)(v >> 24);
+   p[1] = (uint8_t)(v >> 16);
+   p[2] = (uint8_t)(v >> 8);
+   p[3] = (uint8_t)v;
+}
+
+static uint32_t now_us(void)
+{
+   return (uint32_t)(__get_CNTPCT() / (DEF_STGEN_HZ / 1000000U));
+}
+
+/* Header of a bench frame to the peer; the rest of the buffer is sent as
+ * it happens to be. */
+static void bench_header(uint8_t *f, uint8_t op, uint32_t seq)
+{
+   memcpy(&f[0], peer, 6U);
+   memcpy(&f[6], eth_mac_addr(), 6U);
+   f[12] = (uint8_t)(EB_ETHERTYPE >> 8);
+   f[13] = (uint8_t)EB_ETHERTYPE;
+
+   uint8_t *h = &f[NET_ETH_HDR];
+   h[0]       = op;
+   h[1]       = 0U;
+   h[2]       = 0U;
+   h[3]       = 0U;
+   put32(&h[4], seq);
+   put32(&h[8], now_us());
+}
+
+static void bench_input(const uint8_t *f, uint32_t len)
+{
+   if (len < NET_ETH_HDR + EB_HDR)
+      return;
+   const uint8_t *h   = &f[NET_ETH_HDR];
+   const uint32_t seq = get32(&h[4]);
+   memcpy(peer, &f[6], 6U);
+
+   if (h[0] == OP_DATA) {
+      if (rx.frames == 0U) {
+         rx.first_seq = seq;
+         rx.t_first   = HAL_GetTick();
+      }
+      rx.frames++;
+      rx.bytes += len;
+      rx.last_seq = seq;
+   } else if (h[0] == OP_PONG) {
+      rx.pong_seq = seq;
+      rx.got_pong = 1;
+   } else if (h[0] == OP_PING) {
+      uint8_t *t = eth_tx_alloc();
+      if (t == NULL)
+         return;
+      memcpy(t, f, len);
+      memcpy(&t[0], peer, 6U);
+      memcpy(&t[6], eth_mac_addr(), 6U);
+      t[NET_ETH_HDR] = OP_PONG;
+      if (eth_tx(t, (uint16_t)len) == 0)
+         rx.echoed++;
+   }
+}
+
+/* Print n events of len bytes in ms as frames/s and Mb/s, both of the
+ * frames themselves and on the wire. */
+static void print_rate(uint32_t n, uint64_t bytes, uint32_t ms)
+{
+   if (ms == 0U)
+      ms = 1U;
+   const uint64_t wire = bytes + (uint64_t)n * EB_WIRE;
+   my_printf("  %lu frames in %lu ms: %lu frames/s\r\n", (unsigned long)n,
+             (unsigned long)ms, (unsigned long)((uint64_t)n * 1000U / ms));
+   my_printf("  %lu Mb/s of frames, %lu Mb/s on the wire\r\n",
+             (unsigned long)(bytes * 8U / 1000U / ms),
+             (unsigned long)(wire * 8U / 1000U / ms));
+}
+
+static void tx_flood(uint32_t size, uint32_t secs)
+{
+   my_printf("TX flood: %lu-byte frames for %lu s\r\n", (unsigned long)size,
+             (unsigned long)secs);
+   uint32_t n        = 0U;
+   uint32_t busy     = 0U;
+   const uint32_t t0 = HAL_GetTick();
+   while (HAL_GetTick() - t0 < secs * 1000U && !console_interrupted()) {
+      uint8_t *f = eth_tx_alloc();
+      if (f == NULL) {
+         busy++;
+         continue;
+      }
+      bench_header(f, OP_DATA, n);
+      if (eth_tx(f, (uint16_t)size) == 0)
+         n++;
+   }
+   const uint32_t ms = HAL_GetTick() - t0;
+   print_rate(n, (uint64_t)n * size, ms);
+   my_printf("  %lu polls found the TX ring full\r\n", (unsigned long)busy);
+}
+
+static void rx_count(uint32_t secs)
+{
+   uint32_t fifo    = 0U;
+   uint32_t no_desc = 0U;
+   eth_rx_drops(&fifo, &no_desc);
+
+   my_printf("RX: counting data frames for %lu s after the first\r\n",
+             (unsigned long)secs);
+   while (!console_interrupted()) {
+      net_poll();
+      if (rx.frames != 0U && HAL_GetTick() - rx.t_first >= secs * 1000U)
+         break;
+   }
+   const uint32_t ms = HAL_GetTick() - rx.t_first;
+   eth_rx_drops(&fifo, &no_desc);
+   if (rx.frames == 0U) {
+      my_printf("  no frames\r\n");
+      return;
+   }
+   print_rate(rx.frames, rx.bytes, ms);
+   const uint32_t span = rx.last_seq - rx.first_seq + 1U;
+   my_printf("  %lu lost, MAC dropped %lu (FIFO full) + %lu (no descriptor)"
+             "\r\n",
+             (unsigned long)(span - rx.frames), (unsigned long)fifo,
+             (unsigned long)no_desc);
+}
+
+/* Wait up to PING_TIMEOUT for a TX buffer, which may never come back if
+ * the link went down with frames queued.  Returns NULL on a timeout, or
+ * with *stop set on Ctrl-C. */
+static uint8_t *tx_wait(int *stop)
+{
+   const uint32_t t0 = now_us();
+   for (;;) {
+      if (console_interrupted()) {
+         *stop = 1;
+         return NULL;
+      }
+      uint8_t *f = eth_tx_alloc();
+      if (f != NULL || now_us() - t0 >= PING_TIMEOUT)
+         return f;
+      net_poll();
+   }
+}
+
+static void ping_pong(uint32_t size, uint32_t count)
+{
+   uint32_t hist[HIST_BINS] = {0};
+   uint32_t lost            = 0U;
+   uint32_t got             = 0U;
+   uint32_t min             = UINT32_MAX;
+   uint32_t max             = 0U;
+   uint64_t sum             = 0U;
+   int stop                 = 0;
+
+   my_printf("Ping-pong: %lu pings of %lu bytes\r\n", (unsigned long)count,
+             (unsigned long)size);
+   for (uint32_t i = 0; i < count && !stop; i++) {
+      uint8_t *f = tx_wait(&stop);
+      if (f == NULL) {
+         if (!stop)
+            lost++;
+         continue;
+      }
+      rx.got_pong = 0;
+      bench_header(f, OP_PING, i);
+      const uint32_t t0 = now_us();
+      if (eth_tx(f, (uint16_t)size) != 0) {
+         lost++;
+         continue;
+      }
+
+      uint32_t dt = 0U;
+      while (!(rx.got_pong && rx.pong_seq == i)) {
+         net_poll();
+         dt = now_us() - t0;
+         if (dt >= PING_TIMEOUT)
+            break;
+      }
+      if (dt >= PING_TIMEOUT) {
+         lost++;
+         continue;
+      }
+
+      got++;
+      sum += dt;
+      min = (dt < min) ? dt : min;
+      max = (dt > max) ? dt : max;
+      uint32_t b = 0U;
+      while (b < HIST_BINS - 1U && dt >= (16U << b))
+         b++;
+      hist[b]++;
+   }
+
+   if (got == 0U) {
+      my_printf("  no replies\r\n");
+      return;
+   }
+   my_printf("  %lu replies, %lu lost; RTT min %lu avg %lu max %lu us\r\n",
+             (unsigned long)got, (unsigned long)lost, (unsigned long)min,
+             (unsigned long)(sum / got), (unsigned long)max);
+   for (uint32_t b = 0; b < HIST_BINS; b++) {
+      if (hist[b] == 0U)
+         continue;
+      if (b < HIST_BINS - 1U)
+         my_printf("  < %4lu us: %6lu ", (unsigned long)(16U << b),
+                   (unsigned long)hist[b]);
+      else
+         my_printf("  >=%4lu us: %6lu ", (unsigned long)(8U << b),
+                   (unsigned long)hist[b]);
+      for (uint32_t k = 0; k < (hist[b] * 40U + got - 1U) / got; k++)
+         my_printf("#");
+      my_printf("\r\n");
+   }
+}
+
+static void echo(uint32_t secs)
+{
+   my_printf("Echo: answering pings for %lu s\r\n", (unsigned long)secs);
+   const uint32_t t0 = HAL_GetTick();
+   while (HAL_GetTick() - t0 < secs * 1000U && !console_interrupted())
+      net_poll();
+   my_printf("  %lu pings answered\r\n", (unsigned long)rx.echoed);
+}
+
+void eth_bench_cmd(int argc, uint32_t mode, uint32_t size, uint32_t n)
+{
+   if (argc < 1)
+      mode = 0U;
+   if (argc < 2)
+      size = EB_MAX;
+   if (size < EB_MIN || size > EB_MAX) {
+      my_printf("Frame size must be %u to %u bytes\r\n", EB_MIN, EB_MAX);
+      return;
+   }
+
+   memset(&rx, 0, sizeof(rx));
+   net_eth_listen(EB_ETHERTYPE, bench_input);
+   switch (mode) {
+      case 0: tx_flood(size, (argc >= 3) ? n : 5U); break;
+      case 1: rx_count((argc >= 3) ? n : 10U); break;
+      case 2: ping_pong(size, (argc >= 3) ? n : 1000U); break;
+      case 3: echo((argc >= 3) ? n : 30U); break;
+      default: my_printf("Unknown mode\r\n"); break;
+   }
+   net_eth_listen(EB_ETHERTYPE, NULL);
+}
+
+#endif // ETHERNET
+
+// end file eth_bench.c
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file eth_bench.h
+ * @brief Ethernet throughput and latency benchmark
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Bench frames use EtherType 0x88B6 and carry, after the Ethernet header,
+ * u8 op, u8 0, u16 0, u32 seq, u32 sender timestamp (network byte order),
+ * padded to the frame size.  Ops: 1 data, 2 ping, 3 pong.  The peer is
+ * scripts/ethbench.py on a PC wired to the board.
+ */
+
+#ifndef ETH_BENCH_H
+#define ETH_BENCH_H
+
+#include <stdint.h>
+
+/* eth_bench [mode [size [n]]], size in bytes from the destination MAC to
+ * the end of the payload (60 to 1514):
+ *   0  TX flood of size-byte frames for n seconds, all TX descriptors busy
+ *   1  count data frames for n seconds from the first one: rate, lost
+ *      sequence numbers and frames the MAC dropped
+ *   2  n pings of size bytes to the peer, RTT histogram
+ *   3  answer pings from the peer for n seconds */
+void eth_bench_cmd(int argc, uint32_t mode, uint32_t size, uint32_t n);
+
+#endif // ETH_BENCH_H
+
+// end file eth_bench.h
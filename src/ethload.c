@@ -0,0 +1,477 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ethload.c
+ * @brief Bulk image download over raw Ethernet frames
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "ethload.h"
+#include <stdint.h>
+
+#ifdef ETHERNET
+#include "board.h"
+#include "console.h"
+#include "crc.h"
+#include "defaults.h"
+#include "eth.h"
+#include "flash.h"
+#include "net.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+#include <string.h>
+
+#define EL_ETHERTYPE 0x88B5U /* IEEE 802 local experimental */
+#define EL_HDR       8U
+#define EL_DATA      (NET_ETH_HDR + EL_HDR)
+#define EL_MAX_CHUNK (NET_MTU - EL_HDR)
+#define EL_WINDOW    64U /* chunks past the first missing one */
+#define EL_ACK_EVERY 16U /* in-order chunks between ACKs */
+#define EL_LINGER_MS 500U
+
+#define OP_START 1U
+#define OP_DATA  2U
+#define OP_ACK   3U
+#define OP_POLL  4U
+#define OP_MDATA 5U
+#define OP_MEND  6U
+#define OP_MREP  7U
+
+#define MC_INFO       12U /* image length, chunk size, CRC-32 */
+#define MC_MAX_CHUNK  (EL_MAX_CHUNK - MC_INFO)
+#define MC_MAX_RANGES 128U
+#define MC_LINGER_MS  1000U
+
+#define ST_RECEIVING 0U
+#define ST_DONE      1U
+#define ST_REFUSED   2U
+
+/* Transfer in progress. */
+static struct {
+   uint8_t *dst;
+   uint32_t max;
+   int started;
+   uint16_t session;
+   uint8_t host[6];
+   uint32_t len;
+   uint32_t chunk;
+   uint32_t chunks;
+   uint32_t next;      /* first chunk not yet held */
+   uint64_t held;      /* bit i: chunk next + 1 + i held */
+   uint32_t since_ack; /* in-order chunks since the last ACK */
+   int gap_acked;      /* current gap already reported */
+   uint8_t status;
+   uint32_t dups;
+   uint32_t t_start;
+   uint32_t t_end;
+} el;
+
+/* Fleet (multicast) transfer in progress.  The received-chunk bitmap lives
+ * in the stage area, which is free until the image is written out. */
+static struct {
+   uint8_t *dst;
+   uint32_t max;
+   int started;
+   uint16_t session;
+   uint8_t sender[6];
+   uint32_t len;
+   uint32_t chunk;
+   uint32_t chunks;
+   uint32_t crc; /* of the whole image, as the sender announces it */
+   uint32_t have;
+   uint8_t *map;
+   uint8_t status;
+   uint32_t t_start;
+   uint32_t t_end;
+} mc;
+
+static const uint8_t mc_group[6] = {0x03U, 0x53U, 0x54U, 0x4DU, 0x88U, 0xB5U};
+
+static uint16_t get16(const uint8_t *p)
+{
+   return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+   return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+          ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+   p[0] = (uint8_t)(v >> 8);
+   p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+   p[0] = (uint8_t)(v >> 24);
+   p[1] = (uint8_t)(v >> 16);
+   p[2] = (uint8_t)(v >> 8);
+   p[3] = (uint8_t)v;
+}
+
+static void send_ack(void)
+{
+   uint8_t *f = eth_tx_alloc();
+   if (f == NULL)
+      return;
+   memcpy(&f[0], el.host, 6U);
+   memcpy(&f[6], eth_mac_addr(), 6U);
+   put16(&f[12], EL_ETHERTYPE);
+
+   uint8_t *h = &f[NET_ETH_HDR];
+   h[0]       = OP_ACK;
+   h[1]       = el.status;
+   put16(&h[2], el.session);
+   put32(&h[4], el.next);
+   put32(&h[8], (uint32_t)(el.held >> 32));
+   put32(&h[12], (uint32_t)el.held);
+   put32(&h[16], EL_WINDOW);
+   (void)eth_tx(f, (uint16_t)(EL_DATA + 12U));
+   el.since_ack = 0U;
+}
+
+static void start_input(const uint8_t *f, const uint8_t *h, uint32_t n,
+                        uint16_t session)
+{
+   /* A repeated START for the running session only asks for an ACK. */
+   if (!el.started || session != el.session) {
+      if (n < 6U)
+         return;
+      memcpy(el.host, &f[6], 6U);
+      el.started   = 1;
+      el.session   = session;
+      el.len       = get32(&h[EL_HDR]);
+      el.chunk     = get16(&h[EL_HDR + 4U]);
+      el.next      = 0U;
+      el.held      = 0U;
+      el.since_ack = 0U;
+      el.gap_acked = 0;
+      el.dups      = 0U;
+      el.t_start   = HAL_GetTick();
+      el.t_end     = el.t_start;
+
+      if (el.len > el.max || el.chunk == 0U || el.chunk > EL_MAX_CHUNK) {
+         el.status = ST_REFUSED;
+         el.chunks = 0U;
+      } else {
+         el.chunks = (el.len + el.chunk - 1U) / el.chunk;
+         el.status = (el.chunks == 0U) ? ST_DONE : ST_RECEIVING;
+      }
+      my_printf("ethload: %lu bytes in %lu-byte chunks%s\r\n",
+                (unsigned long)el.len, (unsigned long)el.chunk,
+                (el.status == ST_REFUSED) ? ", refused" : "");
+   }
+   send_ack();
+}
+
+static void data_input(const uint8_t *p, uint32_t n, uint32_t seq)
+{
+   if (el.status != ST_RECEIVING || seq >= el.chunks || seq < el.next) {
+      el.dups++;
+      return;
+   }
+   const uint32_t off = seq - el.next;
+   if (off > EL_WINDOW)
+      return;
+   if (off > 0U && (el.held & ((uint64_t)1U << (off - 1U))) != 0U) {
+      el.dups++;
+      return;
+   }
+
+   /* Short frames arrive padded, so only check there is enough. */
+   const uint32_t want =
+       (seq == el.chunks - 1U) ? el.len - seq * el.chunk : el.chunk;
+   if (n < want)
+      return;
+   memcpy(&el.dst[seq * el.chunk], p, want);
+
+   if (off > 0U) {
+      el.held |= (uint64_t)1U << (off - 1U);
+      if (!el.gap_acked) {
+         send_ack();
+         el.gap_acked = 1;
+      }
+      return;
+   }
+
+   uint64_t got = 0U;
+   do {
+      el.next++;
+      got = el.held & 1U;
+      el.held >>= 1;
+   } while (got != 0U);
+   el.gap_acked = (el.held != 0U);
+
+   /* Report at once when a gap closes onto the next one, so the host can
+    * resend it without waiting for a timeout. */
+   if (el.next == el.chunks) {
+      el.status = ST_DONE;
+      el.t_end  = HAL_GetTick();
+      send_ack();
+   } else if (el.gap_acked || ++el.since_ack >= EL_ACK_EVERY) {
+      send_ack();
+   }
+}
+
+static void ethload_input(const uint8_t *f, uint32_t len)
+{
+   if (len < EL_DATA)
+      return;
+   const uint8_t *h       = &f[NET_ETH_HDR];
+   const uint16_t session = get16(&h[2]);
+   const uint32_t n       = len - EL_DATA;
+
+   if (h[0] == OP_START) {
+      start_input(f, h, n, session);
+      return;
+   }
+   if (!el.started || session != el.session)
+      return;
+   if (h[0] == OP_DATA)
+      data_input(&h[EL_HDR], n, get32(&h[4]));
+   else if (h[0] == OP_POLL)
+      send_ack();
+}
+
+static void mc_start(const uint8_t *f, const uint8_t *info, uint16_t session)
+{
+   memcpy(mc.sender, &f[6], 6U);
+   mc.started = 1;
+   mc.session = session;
+   mc.len     = get32(&info[0]);
+   mc.chunk   = get16(&info[4]);
+   mc.crc     = get32(&info[8]);
+   mc.have    = 0U;
+   mc.t_start = HAL_GetTick();
+   mc.t_end   = mc.t_start;
+
+   mc.chunks = (mc.chunk != 0U) ? (mc.len + mc.chunk - 1U) / mc.chunk : 0U;
+   if (mc.len > mc.max || mc.chunk == 0U || mc.chunk > MC_MAX_CHUNK ||
+       mc.chunks > DEF_STAGE_SIZE * 8U) {
+      mc.status = ST_REFUSED;
+      mc.chunks = 0U;
+   } else {
+      mc.status = (mc.chunks == 0U) ? ST_DONE : ST_RECEIVING;
+      memset(mc.map, 0, (mc.chunks + 7U) / 8U);
+   }
+   my_printf("mcload: %lu bytes in %lu-byte chunks%s\r\n",
+             (unsigned long)mc.len, (unsigned long)mc.chunk,
+             (mc.status == ST_REFUSED) ? ", refused" : "");
+}
+
+/* Tell the sender how many chunks we hold and which ranges are missing,
+ * as many as fit. */
+static void mc_report(void)
+{
+   uint8_t *f = eth_tx_alloc();
+   if (f == NULL)
+      return;
+   memcpy(&f[0], mc.sender, 6U);
+   memcpy(&f[6], eth_mac_addr(), 6U);
+   put16(&f[12], EL_ETHERTYPE);
+
+   uint8_t *h = &f[NET_ETH_HDR];
+   h[0]       = OP_MREP;
+   h[1]       = mc.status;
+   put16(&h[2], mc.session);
+   put32(&h[4], mc.have);
+   put32(&h[8], mc.chunks);
+
+   uint32_t n = 0U;
+   uint32_t i = 0U;
+   while (i < mc.chunks && n < MC_MAX_RANGES) {
+      if ((i & 7U) == 0U && mc.map[i >> 3] == 0xFFU) {
+         i += 8U;
+         continue;
+      }
+      if (mc.map[i >> 3] & (1U << (i & 7U))) {
+         i++;
+         continue;
+      }
+      const uint32_t first = i;
+      while (i < mc.chunks && !(mc.map[i >> 3] & (1U << (i & 7U))))
+         i++;
+      put32(&h[12U + n * 8U], first);
+      put32(&h[16U + n * 8U], i - first);
+      n++;
+   }
+   (void)eth_tx(f, (uint16_t)(EL_DATA + 4U + n * 8U));
+}
+
+static void mc_data(const uint8_t *p, uint32_t n, uint32_t seq)
+{
+   if (mc.status != ST_RECEIVING || seq >= mc.chunks ||
+       (mc.map[seq >> 3] & (1U << (seq & 7U))))
+      return;
+   const uint32_t want =
+       (seq == mc.chunks - 1U) ? mc.len - seq * mc.chunk : mc.chunk;
+   if (n < want)
+      return;
+   memcpy(&mc.dst[seq * mc.chunk], p, want);
+   mc.map[seq >> 3] |= (uint8_t)(1U << (seq & 7U));
+
+   if (++mc.have == mc.chunks) {
+      mc.status = ST_DONE;
+      mc.t_end  = HAL_GetTick();
+      mc_report();
+   }
+}
+
+static void mcload_input(const uint8_t *f, uint32_t len)
+{
+   if (len < EL_DATA + MC_INFO)
+      return;
+   const uint8_t *h       = &f[NET_ETH_HDR];
+   const uint16_t session = get16(&h[2]);
+   if (h[0] != OP_MDATA && h[0] != OP_MEND)
+      return;
+
+   /* Any frame of a new session starts it, so a board can join late. */
+   if (!mc.started || session != mc.session)
+      mc_start(f, &h[EL_HDR], session);
+   if (h[0] == OP_MDATA)
+      mc_data(&h[EL_HDR + MC_INFO], len - EL_DATA - MC_INFO, get32(&h[4]));
+   else
+      mc_report();
+}
+
+static void print_rate(const char *name, uint32_t len, uint32_t ms)
+{
+   /* bytes per ms is kB/s; in hundredths of MB/s */
+   const uint32_t rate = (ms != 0U) ? len / ms / 10U : 0U;
+   my_printf("\r%s: %lu bytes in %lu ms, %lu.%02lu MB/s", name,
+             (unsigned long)len, (unsigned long)ms,
+             (unsigned long)(rate / 100U), (unsigned long)(rate % 100U));
+}
+
+void ethload_cmd(int argc, uint32_t addr, uint32_t max, uint32_t arg3)
+{
+   (void)arg3;
+   const uint32_t end = DEF_DDR_BASE + DDR_MEM_SIZE;
+   if (argc < 1)
+      addr = DEF_FASTBOOT_ADDR;
+   if (argc < 2)
+      max = DEF_FASTBOOT_SIZE;
+   if (addr < DEF_DDR_BASE || addr >= end || max > end - addr) {
+      my_printf("ethload: 0x%08lx + 0x%lx is outside DDR\r\n",
+                (unsigned long)addr, (unsigned long)max);
+      return;
+   }
+
+   memset(&el, 0, sizeof(el));
+   el.dst = (uint8_t *)addr;
+   el.max = max;
+   net_eth_listen(EL_ETHERTYPE, ethload_input);
+   my_printf("ethload: waiting for host, up to %lu bytes to 0x%08lx\r\n",
+             (unsigned long)max, (unsigned long)addr);
+
+   uint32_t t_print = HAL_GetTick();
+   while (1) {
+      net_poll();
+      const uint32_t now = HAL_GetTick();
+      if (console_interrupted()) {
+         my_printf("\r\nethload: cancelled\r\n");
+         break;
+      }
+      /* Stay a moment to answer the host if the last ACK is lost. */
+      if (el.started && el.status != ST_RECEIVING &&
+          now - el.t_end >= EL_LINGER_MS)
+         break;
+      if (el.started && now - t_print >= 2000U) {
+         my_printf("\r%lu KiB  ", (unsigned long)((el.next * el.chunk) >> 10));
+         t_print = now;
+      }
+   }
+   net_eth_listen(EL_ETHERTYPE, NULL);
+
+   if (el.status == ST_DONE) {
+      print_rate("ethload", el.len, el.t_end - el.t_start);
+      my_printf(", %lu duplicate chunks\r\n", (unsigned long)el.dups);
+   }
+}
+
+void mcload_cmd(int argc, uint32_t write, uint32_t addr, uint32_t max)
+{
+   const uint32_t end = DEF_DDR_BASE + DDR_MEM_SIZE;
+   if (argc < 1)
+      write = 0U;
+   if (argc < 2)
+      addr = DEF_FASTBOOT_ADDR;
+   if (argc < 3)
+      max = DEF_FASTBOOT_SIZE;
+   if (addr < DEF_DDR_BASE || addr >= end || max > end - addr) {
+      my_printf("mcload: 0x%08lx + 0x%lx is outside DDR\r\n",
+                (unsigned long)addr, (unsigned long)max);
+      return;
+   }
+
+   memset(&mc, 0, sizeof(mc));
+   mc.dst = (uint8_t *)addr;
+   mc.max = max;
+   mc.map = (uint8_t *)DEF_STAGE_ADDR;
+   eth_mcast_filter(mc_group);
+   net_eth_listen(EL_ETHERTYPE, mcload_input);
+   my_printf("mcload: waiting for the sender, up to %lu bytes to 0x%08lx\r\n",
+             (unsigned long)max, (unsigned long)addr);
+
+   uint32_t t_print = HAL_GetTick();
+   while (1) {
+      net_poll();
+      const uint32_t now = HAL_GetTick();
+      if (console_interrupted()) {
+         my_printf("\r\nmcload: cancelled\r\n");
+         break;
+      }
+      /* Keep answering for a while in case the last report is lost. */
+      if (mc.started && mc.status != ST_RECEIVING &&
+          now - mc.t_end >= MC_LINGER_MS)
+         break;
+      if (mc.started && now - t_print >= 2000U) {
+         my_printf("\r%lu/%lu chunks  ", (unsigned long)mc.have,
+                   (unsigned long)mc.chunks);
+         t_print = now;
+      }
+   }
+   net_eth_listen(EL_ETHERTYPE, NULL);
+   eth_mcast_filter(NULL);
+
+   if (mc.status != ST_DONE || !mc.started)
+      return;
+   print_rate("mcload", mc.len, mc.t_end - mc.t_start);
+   my_printf("\r\n");
+
+   /* Chunks are only checked one by one on the way in; the image as a
+    * whole must match what the sender announced before it goes out. */
+   const uint32_t crc = crc32(mc.dst, mc.len);
+   if (crc != mc.crc) {
+      my_printf("mcload: crc32 %08lx, sender said %08lx; not written\r\n",
+                (unsigned long)crc, (unsigned long)mc.crc);
+      return;
+   }
+   my_printf("mcload: crc32 %08lx ok\r\n", (unsigned long)crc);
+   if (write == 0U || mc.len == 0U)
+      return;
+
+   struct flash_part p;
+#ifndef NAND_FLASH
+   if (flash_lookup("disk", &p) != 0) {
+#else
+   if (flash_lookup("nand", &p) != 0) {
+#endif
+      my_printf("Boot medium not available\r\n");
+      return;
+   }
+   my_printf("Writing the image to the boot medium ...\r\n");
+   if (flash_write(&p, mc.dst, mc.len) != 0)
+      my_printf("mcload: write error\r\n");
+   else
+      my_printf("Done\r\n");
+}
+
+#endif // ETHERNET
+
+// end file ethload.c
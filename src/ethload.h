@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ethload.h
+ * @brief Bulk image download over raw Ethernet frames
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * A windowed protocol on its own EtherType (0x88B5), for fast flashing on a
+ * production LAN without IP.  The host (scripts/ethload.py) splits the image
+ * into numbered chunks and streams them; each lands at its own offset in
+ * DDR, in whatever order it arrives.  The board acknowledges with the first
+ * missing chunk and a bitmap of the 64 after it, so the host resends only
+ * what was lost.
+ *
+ * Every frame starts with this header, after the Ethernet header, in
+ * network byte order:
+ *
+ *    u8 op, u8 status, u16 session, u32 seq
+ *
+ * START (1)  host: seq 0, then u32 length, u16 chunk size
+ * DATA  (2)  host: chunk seq, at offset seq * chunk
+ * ACK   (3)  board: seq is the first chunk not yet held, then u64 bitmap
+ *            (bit i: chunk seq + 1 + i held), u32 window in chunks;
+ *            status 0 receiving, 1 done, 2 refused
+ * POLL  (4)  host: asks for an ACK
+ *
+ * Fleet flashing (`mcload`) sends one image to a rack of boards at once, to
+ * the multicast group 03:53:54:4D:88:B5 (scripts/ethfleet.py).  Each board
+ * keeps a bitmap of the chunks it holds and, when the sender ends a pass,
+ * reports what is missing so the next pass carries only the union of the
+ * repairs.  Sender frames carry u32 length, u16 chunk size, u16 0 and the
+ * u32 CRC-32 of the whole image after the header, so a board can join at
+ * any point:
+ *
+ * MDATA (5)  sender: chunk seq
+ * MEND  (6)  sender: end of a pass, report now
+ * MREP  (7)  board: seq is the number of chunks held, then u32 chunk count
+ *            and up to 128 missing ranges (u32 first, u32 count); status
+ *            as for ACK
+ */
+
+#ifndef ETHLOAD_H
+#define ETHLOAD_H
+
+#include <stdint.h>
+
+/* Receive one image to addr, at most max bytes (default the download
+ * buffer that fastboot uses, for `sparse` to pick up).  Returns when the
+ * image is complete, or on Ctrl-C. */
+void ethload_cmd(int argc, uint32_t addr, uint32_t max, uint32_t arg3);
+
+/* Join the fleet group and receive one image to addr (default as above),
+ * and check it against the CRC-32 the sender announced.  Only if write is
+ * given and nonzero is it then written to the start of the boot medium,
+ * raw or sparse. */
+void mcload_cmd(int argc, uint32_t write, uint32_t addr, uint32_t max);
+
+#endif // ETHLOAD_H
+
+// end file ethload.h
@@ -0,0 +1,425 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file flash.c
+ * @brief Writing raw and sparse images to the boot medium
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "flash.h"
+#include "board.h"
+#include "defaults.h"
+#include "hash.h"
+#include "irq_ctrl.h"
+#include "manifest.h"
+#include "printf.h"
+#include "sparse.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef NAND_FLASH
+#include "sd.h"
+#else
+#include "crc.h"
+#include "fmc.h"
+#include "nand_pt.h"
+#endif
+
+#define NO_BLOCK UINT32_MAX
+
+#ifndef NAND_FLASH
+#define PAD          0x00U
+#define SD_BOOT_LBA  128U  /* LBA1 of scripts/sdimage.py */
+#define SD_XFER      2048U /* blocks per transfer, inside the HAL timeout */
+#define SPARSE_SRC   DEF_RAMDISK_ADDR
+#define MANIFEST_BLK MANIFEST_SD_LBA
+#define MANIFEST_OFF 0U
+#else
+#define PAD          0xFFU
+#define SPARSE_SRC   FMC_DDR_BUF_ADDR
+#define MANIFEST_BLK NAND_BLOCK_PT
+#define MANIFEST_OFF MANIFEST_NAND_OFFSET
+#endif
+
+/* Image being written: the block only partly covered so far is assembled
+ * in the stage area before it goes out. */
+struct sink {
+   const struct flash_part *part;
+   uint32_t cur;   /* block held in the stage, or NO_BLOCK */
+   int keep;       /* start a staged block from the medium (sparse) */
+   uint64_t done;  /* bytes of output handled */
+   uint32_t t0;
+   uint32_t t_print;
+};
+
+static uint8_t *const stage = (uint8_t *)DEF_STAGE_ADDR;
+
+#ifndef NAND_FLASH
+/* The USB MSC LUN accesses the card from the OTG interrupt; keep it out
+ * while the card is busy here. */
+static int sd_locked(int (*op)(uint32_t, uint8_t *, uint32_t), uint32_t lba,
+                     uint8_t *buf, uint32_t n)
+{
+   while (n > 0U) {
+      const uint32_t k = (n > SD_XFER) ? SD_XFER : n;
+      IRQ_Disable(OTG_IRQn);
+      const int err = op(lba, buf, k);
+      IRQ_Enable(OTG_IRQn);
+      if (err != 0)
+         return -1;
+      lba += k;
+      buf += k * 512U;
+      n -= k;
+   }
+   return 0;
+}
+
+static int sd_write_op(uint32_t lba, uint8_t *buf, uint32_t n)
+{
+   return sd_write_blocks(lba, buf, n);
+}
+#endif
+
+static int store_read(uint32_t blk, uint8_t *buf, uint32_t n)
+{
+#ifndef NAND_FLASH
+   return sd_locked(sd_read_blocks, blk, buf, n);
+#else
+   return fmc_read_blocks(blk, buf, n);
+#endif
+}
+
+static int store_write(uint32_t blk, const uint8_t *buf, uint32_t n)
+{
+#ifndef NAND_FLASH
+   return sd_locked(sd_write_op, blk, (uint8_t *)buf, n);
+#else
+   return fmc_write_blocks(blk, buf, n);
+#endif
+}
+
+static void fill32(uint8_t *dst, uint32_t pattern, uint32_t len)
+{
+   const uint8_t b = (uint8_t)pattern;
+   if (pattern == (uint32_t)b * 0x01010101U) {
+      memset(dst, b, len);
+      return;
+   }
+   for (uint32_t i = 0; i + 4U <= len; i += 4U)
+      memcpy(&dst[i], &pattern, 4U);
+}
+
+static int store_fill(const struct flash_part *p, uint32_t blk, uint32_t n,
+                      uint32_t pattern)
+{
+#ifdef NAND_FLASH
+   if (pattern == 0xFFFFFFFFU)
+      return fmc_erase_blocks(blk, n);
+#endif
+   const uint32_t per = DEF_STAGE_SIZE / p->unit;
+   fill32(stage, pattern, per * p->unit);
+   while (n > 0U) {
+      const uint32_t k = (n > per) ? per : n;
+      if (store_write(blk, stage, k) != 0)
+         return -1;
+      blk += k;
+      n -= k;
+   }
+   return 0;
+}
+
+static void progress(struct sink *s, uint64_t adv)
+{
+   s->done += adv;
+   const uint32_t now = HAL_GetTick();
+   if (now - s->t_print >= 2000U) {
+      my_printf("\r%lu MiB  ", (unsigned long)(s->done >> 20));
+      s->t_print = now;
+   }
+}
+
+static int sink_flush(struct sink *s)
+{
+   if (s->cur == NO_BLOCK)
+      return 0;
+   const uint32_t blk = s->cur;
+   s->cur             = NO_BLOCK;
+   return store_write(s->part->start + blk, stage, 1U);
+}
+
+/* Make block blk the one being assembled.  For a sparse image it starts out
+ * as whatever the medium holds, so DONT_CARE ranges inside it -- e.g. the
+ * parts written by another piece of a split image -- survive. */
+static int sink_stage(struct sink *s, uint32_t blk)
+{
+   if (s->cur == blk)
+      return 0;
+   if (sink_flush(s) != 0)
+      return -1;
+   if (!s->keep || store_read(s->part->start + blk, stage, 1U) != 0)
+      memset(stage, PAD, s->part->unit);
+   s->cur = blk;
+   return 0;
+}
+
+static int sink_write(void *ctx, uint64_t off, const uint8_t *buf,
+                      uint32_t len)
+{
+   struct sink *s      = ctx;
+   const uint32_t unit = s->part->unit;
+   while (len > 0U) {
+      const uint32_t blk = (uint32_t)(off / unit);
+      const uint32_t in  = (uint32_t)(off % unit);
+      uint32_t adv;
+      if (in == 0U && len >= unit) {
+         /* Whole blocks go straight from the image, a stage-sized piece
+          * at a time so that progress gets reported. */
+         adv = len - (len % unit);
+         if (adv > DEF_STAGE_SIZE)
+            adv = DEF_STAGE_SIZE - (DEF_STAGE_SIZE % unit);
+         if (sink_flush(s) != 0 ||
+             store_write(s->part->start + blk, buf, adv / unit) != 0)
+            return -1;
+      } else {
+         adv = (len < unit - in) ? len : unit - in;
+         if (sink_stage(s, blk) != 0)
+            return -1;
+         memcpy(&stage[in], buf, adv);
+      }
+      off += adv;
+      buf += adv;
+      len -= adv;
+      progress(s, adv);
+   }
+   return 0;
+}
+
+static int sink_fill(void *ctx, uint64_t off, uint32_t pattern, uint64_t len)
+{
+   struct sink *s      = ctx;
+   const uint32_t unit = s->part->unit;
+   while (len > 0U) {
+      const uint32_t blk = (uint32_t)(off / unit);
+      const uint32_t in  = (uint32_t)(off % unit);
+      uint64_t adv;
+      if (in == 0U && len >= unit) {
+         const uint32_t n = (uint32_t)(len / unit);
+         adv              = (uint64_t)n * unit;
+         if (sink_flush(s) != 0 ||
+             store_fill(s->part, s->part->start + blk, n, pattern) != 0)
+            return -1;
+      } else {
+         adv = (len < unit - in) ? len : unit - in;
+         if (sink_stage(s, blk) != 0)
+            return -1;
+         fill32(&stage[in], pattern, (uint32_t)adv);
+      }
+      off += adv;
+      len -= adv;
+      progress(s, adv);
+   }
+   return 0;
+}
+
+static const struct sparse_ops sink_ops = {
+    .write = sink_write,
+    .fill  = sink_fill,
+};
+
+/* Keep the image manifest in step with what was just written to a
+ * partition it lists.  A sparse image is never whole in memory, so it
+ * cannot be hashed here; its partition goes back to loading unverified.
+ * Returns 1 if the manifest in the stage changed. */
+static int manifest_entry_update(const char *name, const uint8_t *img,
+                                 uint32_t len, int sparse)
+{
+   manifest_t *m = (manifest_t *)(stage + MANIFEST_OFF);
+   if (manifest_valid(m) != 1)
+      return 0;
+   manifest_entry_t *e = (manifest_entry_t *)manifest_find(m, name);
+   if (!e)
+      return 0;
+
+   if (sparse) {
+      const uint32_t i = (uint32_t)(e - m->images);
+      memmove(e, e + 1, (m->num_images - i - 1U) * sizeof(*e));
+      m->num_images--;
+      memset(&m->images[m->num_images], 0, sizeof(*e));
+      my_printf("manifest: %s is no longer verified\r\n", name);
+   } else {
+      e->size = len;
+      if (hash_sha256(img, len, e->sha256) != 0)
+         return -1;
+   }
+   if (hash_sha256(m, offsetof(manifest_t, sha256), m->sha256) != 0)
+      return -1;
+   return 1;
+}
+
+#ifdef NAND_FLASH
+/* The same for the image size and CRC-32 in the partition table, which
+ * shares the block.  A version 1 table is rewritten as version 2, entry or
+ * not.  Returns 1 if the table changed. */
+static int pt_entry_update(const char *name, const uint8_t *img,
+                           uint32_t len, int sparse)
+{
+   nand_pt_t pt;
+   if (nand_pt_read(stage, &pt) != NULL)
+      return 0;
+   int changed = ((const nand_pt_t *)stage)->version != pt.version;
+   for (uint32_t i = 0; i < pt.num_parts && i < NAND_PT_MAX_PARTS; i++) {
+      nand_part_t *p = &pt.parts[i];
+      if (strncmp(p->name, name, sizeof(p->name)) != 0 ||
+          p->start_block == NAND_BLOCK_PT)
+         continue;
+      p->size  = sparse ? 0U : len;
+      p->crc32 = sparse ? 0U : crc32(img, len);
+      changed  = 1;
+      break;
+   }
+   if (!changed)
+      return 0;
+   pt.crc32 = crc32(&pt, offsetof(nand_pt_t, crc32));
+   memcpy(stage, &pt, sizeof(pt));
+   return 1;
+}
+#endif
+
+/* Bring the image metadata on the medium up to date after a write. */
+static void meta_update(const char *name, const uint8_t *img, uint32_t len,
+                        int sparse)
+{
+   if (store_read(MANIFEST_BLK, stage, 1U) != 0)
+      return;
+   int m = manifest_entry_update(name, img, len, sparse);
+   int t = 0;
+#ifdef NAND_FLASH
+   t = pt_entry_update(name, img, len, sparse);
+#endif
+   if (m < 0 || ((m > 0 || t > 0) && store_write(MANIFEST_BLK, stage, 1U) != 0))
+      my_printf("flash: %s entry not updated\r\n", name);
+}
+
+int flash_lookup(const char *name, struct flash_part *p)
+{
+   p->name = name;
+#ifndef NAND_FLASH
+   static const char *const mbr_names[] = {"kernel", "dtb",  "mbr1",
+                                           "mbr2",   "mbr3", "mbr4"};
+   p->unit = 512U;
+   if (strcmp(name, "disk") == 0) {
+      p->start = 0U;
+      p->count = sd_block_count();
+      return (p->count != 0U) ? 0 : -1;
+   }
+   if (strcmp(name, "bootloader") == 0) {
+      p->start = SD_BOOT_LBA;
+      p->count = DEF_DTB_BLK - SD_BOOT_LBA;
+      return 0;
+   }
+   for (int i = 0; i < 6; i++)
+      if (strcmp(name, mbr_names[i]) == 0)
+         return sd_mbr_partition((i < 2) ? i : i - 2, &p->start, &p->count);
+   return -1;
+#else
+   p->unit = fmc_block_bytes();
+   if (p->unit > DEF_STAGE_SIZE)
+      return -1;
+   return fmc_part_lookup(name, &p->start, &p->count);
+#endif
+}
+
+int flash_read(const struct flash_part *p, uint8_t *dst, uint32_t n)
+{
+   if (n > p->count)
+      return -1;
+   return store_read(p->start, dst, n);
+}
+
+int flash_write(const struct flash_part *p, const uint8_t *img, uint32_t len)
+{
+   const uint64_t size = (uint64_t)p->count * p->unit;
+   struct sink s       = {.part = p, .cur = NO_BLOCK, .t0 = HAL_GetTick()};
+   s.t_print           = s.t0;
+
+   int err;
+   if (sparse_is_image(img, len)) {
+      s.keep = 1;
+      err    = sparse_expand(img, len, size, &sink_ops, &s);
+   } else if (len > size) {
+      my_printf("flash: image is %lu bytes, partition %lu blocks\r\n",
+                (unsigned long)len, (unsigned long)p->count);
+      err = -1;
+   } else {
+      err = sink_write(&s, 0U, img, len);
+   }
+   if (err == 0)
+      err = sink_flush(&s);
+   if (err == 0)
+      meta_update(p->name, img, len, s.keep);
+
+   my_printf("\rflash: %lu KiB %s in %lu ms\r\n",
+             (unsigned long)(s.done >> 10), (err == 0) ? "written" : "FAILED",
+             (unsigned long)(HAL_GetTick() - s.t0));
+   return err;
+}
+
+int flash_erase(const struct flash_part *p)
+{
+#ifndef NAND_FLASH
+   IRQ_Disable(OTG_IRQn);
+   const int err = sd_erase_blocks(p->start, p->count);
+   IRQ_Enable(OTG_IRQn);
+   return err;
+#else
+   return fmc_erase_blocks(p->start, p->count);
+#endif
+}
+
+void flash_sparse_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   (void)arg3;
+   const uint32_t src   = (argc >= 1) ? arg1 : SPARSE_SRC;
+   const uint32_t start = (argc >= 2) ? arg2 : 0U;
+   const uint32_t end   = DEF_DDR_BASE + DDR_MEM_SIZE;
+
+   if (src < DEF_DDR_BASE || src >= end ||
+       !sparse_is_image((const uint8_t *)src, end - src)) {
+      my_printf("No sparse image at 0x%08lx\r\n", (unsigned long)src);
+      return;
+   }
+
+   struct flash_part p;
+#ifndef NAND_FLASH
+   if (flash_lookup("disk", &p) != 0) {
+#else
+   if (flash_lookup("nand", &p) != 0) {
+#endif
+      my_printf("Boot medium not available\r\n");
+      return;
+   }
+   if (start >= p.count) {
+      my_printf("Start block %lu past the end (%lu)\r\n",
+                (unsigned long)start, (unsigned long)p.count);
+      return;
+   }
+   p.start += start;
+   p.count -= start;
+
+   my_printf("Expanding sparse image at 0x%08lx to block %lu ...\r\n",
+             (unsigned long)src, (unsigned long)start);
+   (void)flash_write(&p, (const uint8_t *)src, end - src);
+
+#ifdef NAND_FLASH
+   /* An image staged through the USB drive has overwritten its view of the
+    * NAND. */
+   if (src >= FMC_DDR_BUF_ADDR && src < FMC_DDR_BUF_ADDR + FMC_DDR_BUF_SIZE)
+      fmc_cache_reset();
+#endif
+}
+
+// end file flash.c
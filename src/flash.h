@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file flash.h
+ * @brief Writing raw and sparse images to the boot medium
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * The boot medium is the SD card, or the NAND in NAND_FLASH builds.  Images
+ * are written in its native blocks: 512-byte sectors, or whole erase blocks
+ * addressed by good-block index.
+ */
+
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <stdint.h>
+
+/* A region of the boot medium, in native blocks. */
+struct flash_part {
+   const char *name; /* as given to flash_lookup() */
+   uint32_t start;
+   uint32_t count;
+   uint32_t unit; /* bytes per block */
+};
+
+/* Resolve a partition name.  NAND: any partition table entry, or "nand" for
+ * the whole device.  SD: "kernel" and "dtb" (MBR entries 1-2, as loaded by
+ * `two`), "mbr1" to "mbr4", "bootloader" (LBA 128) or "disk" for the whole
+ * card.  Returns 0 on success. */
+int flash_lookup(const char *name, struct flash_part *p);
+
+/* Read the first n blocks of p into dst.  Returns 0 on success. */
+int flash_read(const struct flash_part *p, uint8_t *dst, uint32_t n);
+
+/* Write the image in img (len bytes) to the start of p.  Android sparse
+ * images are expanded on the fly: DONT_CARE ranges keep what the medium
+ * holds, and FILL ranges are written from a pattern buffer (or erased, for
+ * 0xFF on NAND).  A raw image has its last block padded.  If the image
+ * manifest lists the partition, a raw image gets its entry updated and a
+ * sparse one has it dropped.  Returns 0 on success. */
+int flash_write(const struct flash_part *p, const uint8_t *img, uint32_t len);
+
+/* Erase all of p.  Returns 0 on success. */
+int flash_erase(const struct flash_part *p);
+
+void flash_sparse_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#endif // FLASH_H
+
+// end file flash.h
@@ -14,12 +14,19 @@
 #ifdef NAND_FLASH
 
 #include "console.h"
+#include "crc.h"
+#include "ddr_map.h"
 #include "defaults.h"
+#include "dma.h"
 #include "dtb.h"
+#include "hash.h"
+#include "irq.h"
 #include "irq_ctrl.h"
+#include "manifest.h"
 #include "nand_pt.h"
 #include "printf.h"
 #include "prng.h"
+#include "sparse.h"
 #include "stm32mp135fxx_ca7.h"
 #include "stm32mp13xx_hal.h"
 #include "stm32mp13xx_hal_def.h"
@@ -29,12 +36,12 @@
 #include "stm32mp13xx_hal_nand.h"
 #include "stm32mp13xx_hal_rcc.h"
 #include "stm32mp13xx_ll_fmc.h"
+#include "trace.h"
+#include "warm.h"
 #include <stddef.h>
 #include <string.h>
 
 #define BLOCK_BYTES (FMC_BLOCK_SIZE_PAGES * FMC_PAGE_SIZE_BYTES)
-#define BUF_A_ADDR  (FMC_SCRATCH_ADDR)
-#define BUF_B_ADDR  (FMC_SCRATCH_ADDR + BLOCK_BYTES)
 #define TEST_SEED   UINT64_C(0xCAFEBABEDEADBEEF)
 #define FMC_BBT_RESERVED_BLOCKS 2U
 
@@ -50,9 +57,13 @@ static MDMA_HandleTypeDef hmdma_wr;  /* DDR  -> NAND (data)   */
 static MDMA_HandleTypeDef hmdma_ecc; /* BCH DSR registers -> DDR (ECC read) */
 static uint32_t ecc_buf[ECC_BUF_WORDS];
 
-/* Two DDR scratch buffers, each one full NAND block (256 KB). */
-static uint8_t *const buf_a = (uint8_t *)BUF_A_ADDR;
-static uint8_t *const buf_b = (uint8_t *)BUF_B_ADDR;
+/* Two DDR scratch buffers, each one full NAND block (256 KB), from the
+ * DDR map pool. */
+static uint8_t *buf_a;
+static uint8_t *buf_b;
+
+/* The last partition table read, in the version 2 layout. */
+static nand_pt_t part_table;
 
 /* Bad block table: 1 = bad, 0 = good.  Populated by fmc_init OOB scan. */
 static uint8_t bad[FMC_PLANE_NBR * FMC_PLANE_SIZE_BLOCKS];
@@ -80,9 +91,11 @@ uint32_t fmc_usb_written_bytes(void)
 /* Override the weak MspInit to configure the three MDMA channels needed by
  * the FMC NAND sequencer.
  *
- * HdmaRead  (MDMA_Channel0): FMC NAND data FIFO -> DDR, one sector per trigger.
- * HdmaWrite (MDMA_Channel1): DDR -> FMC NAND data FIFO, one sector per trigger.
- * HdmaEcc   (MDMA_Channel2): FMC BCH DSR registers -> DDR ECC buffer.
+ * HdmaRead  (MDMA_CH_NAND_RD):  FMC NAND data FIFO -> DDR, one sector per
+ *                              trigger.
+ * HdmaWrite (MDMA_CH_NAND_WR):  DDR -> FMC NAND data FIFO, one sector per
+ *                              trigger.
+ * HdmaEcc   (MDMA_CH_NAND_ECC): FMC BCH DSR registers -> DDR ECC buffer.
  *   Each FMC_ERROR trigger fires when one sector's BCH ECC is ready.
  *   We read 5 words (BCHDSR0..4), then SourceBlockAddressOffset resets the
  *   source pointer back to BCHDSR0 for the next sector. */
@@ -110,7 +123,7 @@ HAL_StatusTypeDef HAL_NAND_Sequencer_MspInit(NAND_HandleTypeDef *hnand_arg)
    /* Read: FMC FIFO (fixed) -> DDR (incrementing) */
    d.SourceInc       = MDMA_SRC_INC_DISABLE;
    d.DestinationInc  = MDMA_DEST_INC_WORD;
-   hmdma_rd.Instance = MDMA_Channel0;
+   hmdma_rd.Instance = MDMA_CH_NAND_RD;
    hmdma_rd.Init     = d;
    if (HAL_MDMA_Init(&hmdma_rd) != HAL_OK)
       return HAL_ERROR;
@@ -118,13 +131,13 @@ HAL_StatusTypeDef HAL_NAND_Sequencer_MspInit(NAND_HandleTypeDef *hnand_arg)
    /* Write: DDR (incrementing) -> FMC FIFO (fixed) */
    d.SourceInc       = MDMA_SRC_INC_WORD;
    d.DestinationInc  = MDMA_DEST_INC_DISABLE;
-   hmdma_wr.Instance = MDMA_Channel1;
+   hmdma_wr.Instance = MDMA_CH_NAND_WR;
    hmdma_wr.Init     = d;
    if (HAL_MDMA_Init(&hmdma_wr) != HAL_OK)
       return HAL_ERROR;
 
    /* ECC: BCH DSRs (BCHDSR0..4, incrementing within sector, reset between) */
-   hmdma_ecc.Instance                      = MDMA_Channel2;
+   hmdma_ecc.Instance                      = MDMA_CH_NAND_ECC;
    hmdma_ecc.Init.Request                  = MDMA_REQUEST_FMC_ERROR;
    hmdma_ecc.Init.TransferTriggerMode      = MDMA_BLOCK_TRANSFER;
    hmdma_ecc.Init.Priority                 = MDMA_PRIORITY_HIGH;
@@ -212,6 +225,7 @@ static int is_bad_oob(uint32_t blk)
 
 static void mark_bad_oob(uint32_t blk)
 {
+   TRACE("fmc: blk %lu marked bad", blk);
    uint8_t oob[FMC_OOB_SIZE_BYTES];
    memset(oob, 0xFFU, sizeof(oob));
    oob[0]                = 0x00U;
@@ -251,6 +265,165 @@ static HAL_StatusTypeDef write_block(uint32_t blk, const uint8_t *buf)
    return HAL_OK;
 }
 
+/* Demand-paged view of NAND through the DDR staging buffer.  Each logical
+ * (good) erase block of the buffer is either present -- its DDR copy is
+ * authoritative -- or has not been read from NAND yet.  Host writes into a
+ * block that is not present are accepted without a NAND read only while they
+ * extend the contiguous prefix written so far (cache_fill, in sectors); any
+ * other access is deferred to the main loop, which reads the block and merges
+ * it behind that prefix.  The USB interrupt never touches the NAND itself. */
+#define CACHE_BLOCKS (FMC_DDR_BUF_SIZE / BLOCK_BYTES)
+#define CACHE_SPB    (BLOCK_BYTES / FMC_SECTOR_SIZE)
+#define CACHE_NONE   UINT32_MAX
+
+static uint32_t cache_present[(CACHE_BLOCKS + 31U) / 32U];
+static uint16_t cache_fill[CACHE_BLOCKS];
+static volatile uint32_t cache_busy = CACHE_NONE;
+static uint32_t cache_cursor        = 0U;
+
+static inline int cache_is_present(uint32_t idx)
+{
+   return (int)((cache_present[idx / 32U] >> (idx % 32U)) & 1U);
+}
+
+static inline void cache_set_present(uint32_t idx)
+{
+   cache_present[idx / 32U] |= 1UL << (idx % 32U);
+}
+
+/* Forget the DDR copy, e.g. after the NAND contents changed underneath it. */
+static void cache_invalidate(void)
+{
+   __disable_irq();
+   memset(cache_present, 0, sizeof(cache_present));
+   memset(cache_fill, 0, sizeof(cache_fill));
+   cache_cursor = 0U;
+   __enable_irq();
+}
+
+/* Forget the DDR copy of one block after it was written or erased behind
+ * the cache's back; the prefetcher reads it again. */
+static void cache_drop(uint32_t idx)
+{
+   if (idx >= CACHE_BLOCKS)
+      return;
+   __disable_irq();
+   cache_present[idx / 32U] &= ~(1UL << (idx % 32U));
+   cache_fill[idx] = 0U;
+   if (cache_cursor > idx)
+      cache_cursor = idx;
+   __enable_irq();
+}
+
+/* Read logical block idx into its DDR slot, keeping any sectors the host has
+ * already written.  The data is taken from the good block `slip` positions
+ * before the current mapping (non-zero only while fmc_flush is shifting the
+ * image past a newly bad block).  Returns 0 on success. */
+static int cache_fault_block(uint32_t idx, uint32_t slip)
+{
+   if (cache_is_present(idx))
+      return 0;
+
+   uint8_t *const slot = (uint8_t *)(FMC_DDR_BUF_ADDR + (idx * BLOCK_BYTES));
+   cache_busy          = idx;
+   /* With nothing written yet the slot can be filled directly, since the
+    * USB side defers every access to a busy block. */
+   uint8_t *const dst  = (cache_fill[idx] == 0U) ? slot : buf_a;
+   const uint32_t phys =
+       (idx >= slip) ? lba_to_phys_block(idx - slip) : UINT32_MAX;
+   int ret = 0;
+
+   if (phys == UINT32_MAX)
+      memset(dst, 0xFF, BLOCK_BYTES); /* past the last good block: erased */
+   else if (read_block(phys, dst) != HAL_OK)
+      ret = -1;
+
+   if (ret == 0) {
+      __disable_irq();
+      if (dst != slot) {
+         const uint32_t off = (uint32_t)cache_fill[idx] * FMC_SECTOR_SIZE;
+         memcpy(slot + off, buf_a + off, BLOCK_BYTES - off);
+      }
+      cache_set_present(idx);
+      __enable_irq();
+   }
+   cache_busy = CACHE_NONE;
+   return ret;
+}
+
+// cppcheck-suppress unusedFunction
+int fmc_cache_claim(uint32_t lba, uint32_t sectors, int write)
+{
+   if (!nand_ready || sectors == 0U)
+      return 1;
+
+   const uint32_t first = lba / CACHE_SPB;
+   const uint32_t last  = (lba + sectors - 1U) / CACHE_SPB;
+   if (last >= CACHE_BLOCKS)
+      return 1;
+
+   for (uint32_t b = first; b <= last; b++) {
+      if (cache_is_present(b))
+         continue;
+      if (b == cache_busy)
+         return 0;
+      const uint32_t s = (b == first) ? lba % CACHE_SPB : 0U;
+      const uint32_t e =
+          (b == last) ? ((lba + sectors - 1U) % CACHE_SPB) + 1U : CACHE_SPB;
+      if (write ? (s > cache_fill[b]) : (e > cache_fill[b]))
+         return 0;
+   }
+
+   if (write) {
+      for (uint32_t b = first; b <= last; b++) {
+         if (cache_is_present(b))
+            continue;
+         const uint32_t e =
+             (b == last) ? ((lba + sectors - 1U) % CACHE_SPB) + 1U : CACHE_SPB;
+         if (e > cache_fill[b])
+            cache_fill[b] = (uint16_t)e;
+         if (cache_fill[b] == CACHE_SPB)
+            cache_set_present(b);
+      }
+   }
+   return 1;
+}
+
+int fmc_cache_fault(uint32_t lba, uint32_t sectors)
+{
+   if (!nand_ready || sectors == 0U)
+      return 0;
+
+   const uint32_t first = lba / CACHE_SPB;
+   uint32_t last        = (lba + sectors - 1U) / CACHE_SPB;
+   if (last >= CACHE_BLOCKS)
+      last = CACHE_BLOCKS - 1U;
+
+   for (uint32_t b = first; b <= last; b++)
+      if (cache_fault_block(b, 0U) != 0)
+         return -1;
+   return 0;
+}
+
+void fmc_cache_poll(void)
+{
+   if (!nand_ready)
+      return;
+
+   /* Blocks the host is busy writing are left alone: they are either
+    * completed by the host or merged on demand. */
+   while (cache_cursor < CACHE_BLOCKS &&
+          (cache_is_present(cache_cursor) || cache_fill[cache_cursor] != 0U))
+      cache_cursor++;
+   if (cache_cursor >= CACHE_BLOCKS)
+      return;
+
+   /* A read error leaves the block absent, so a later host read of it
+    * reports a medium error instead of stale data. */
+   (void)cache_fault_block(cache_cursor, 0U);
+   cache_cursor++;
+}
+
 static inline uint32_t le32(const uint8_t *p, uint32_t o)
 {
    return (uint32_t)p[o] | ((uint32_t)p[o + 1] << 8U) |
@@ -282,6 +455,12 @@ void fmc_init(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    (void)arg2;
    (void)arg3;
 
+   const uint32_t scratch = ddr_map_alloc("fmc_buf", 2U * BLOCK_BYTES, 0U);
+   if (scratch == 0U)
+      return;
+   buf_a = (uint8_t *)scratch;
+   buf_b = buf_a + BLOCK_BYTES;
+
    __HAL_RCC_FMC_CLK_ENABLE();
    __HAL_RCC_FMC_FORCE_RESET();
    __HAL_RCC_FMC_RELEASE_RESET();
@@ -412,6 +591,7 @@ void fmc_erase_all(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    uint32_t t_print  = t0;
 
    my_printf("FMC: erasing %lu blocks\r\n", (unsigned long)n);
+   cache_invalidate();
    for (uint32_t blk = 0; blk < n; blk++) {
       if (bad[blk]) {
          my_printf("\rskip %lu (pre-marked bad)\r\n", (unsigned long)blk);
@@ -521,31 +701,21 @@ static void check_partition_table(void)
       my_printf("  read error\r\n");
       return;
    }
-   const nand_pt_t *pt = (const nand_pt_t *)buf_a;
-   if (pt->magic != NAND_PT_MAGIC) {
-      my_printf("  bad magic: 0x%08lx\r\n", (unsigned long)pt->magic);
-      return;
-   }
-   if (pt->version != NAND_PT_VERSION) {
-      my_printf("  unknown version: %lu\r\n", (unsigned long)pt->version);
-      return;
-   }
-   uint32_t sum     = 0;
-   const uint8_t *b = (const uint8_t *)pt;
-   for (uint32_t i = 0; i < (uint32_t)offsetof(nand_pt_t, checksum); i++)
-      sum += b[i];
-   if (sum != pt->checksum) {
-      my_printf("  checksum MISMATCH computed 0x%08lx stored 0x%08lx\r\n",
-                (unsigned long)sum, (unsigned long)pt->checksum);
+   const char *why = nand_pt_read(buf_a, &part_table);
+   if (why != NULL) {
+      my_printf("  %s\r\n", why);
       return;
    }
-   my_printf("  checksum OK  total_blocks %lu  %lu partition(s)\r\n",
+   const nand_pt_t *pt = &part_table;
+   my_printf("  v%lu OK  total_blocks %lu  %lu partition(s)\r\n",
+             (unsigned long)((const nand_pt_t *)buf_a)->version,
              (unsigned long)pt->total_blocks, (unsigned long)pt->num_parts);
    for (uint32_t i = 0; i < pt->num_parts && i < NAND_PT_MAX_PARTS; i++) {
       const nand_part_t *p = &pt->parts[i];
-      my_printf("  [%lu] %-16s  block %lu  len %lu\r\n", (unsigned long)i,
-                p->name, (unsigned long)p->start_block,
-                (unsigned long)p->num_blocks);
+      my_printf("  [%lu] %-16s  block %lu  len %lu  size %lu  crc32 %08lx\r\n",
+                (unsigned long)i, p->name, (unsigned long)p->start_block,
+                (unsigned long)p->num_blocks, (unsigned long)p->size,
+                (unsigned long)p->crc32);
    }
 }
 
@@ -605,10 +775,13 @@ void fmc_test_write(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    uint32_t t_print  = t0;
 
    my_printf("FMC write: %lu blocks\r\n", (unsigned long)n);
+   cache_invalidate();
    for (uint32_t blk = 0; blk < n; blk++) {
       prng_fill(buf_a, BLOCK_BYTES, &prng);
-      if (write_block(blk, buf_a) != HAL_OK)
+      if (write_block(blk, buf_a) != HAL_OK) {
+         TRACE("fmc write: blk %lu failed", blk);
          errors++;
+      }
       const uint32_t now = HAL_GetTick();
       if ((now - t_print) >= 2000U) {
          my_printf("\rblk %lu/%lu  ", (unsigned long)blk + 1UL,
@@ -651,14 +824,19 @@ void fmc_test_read(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    for (uint32_t blk = 0; blk < n; blk++) {
       prng_fill(buf_a, BLOCK_BYTES, &prng);
       if (read_block(blk, buf_b) != HAL_OK) {
+         TRACE("fmc read: blk %lu failed", blk);
          rd_errs++;
          continue;
       }
+      uint32_t blk_errs = 0U;
       for (uint32_t i = 0; i < BLOCK_BYTES; i++) {
          const uint8_t diff = buf_b[i] ^ buf_a[i];
          if (diff)
-            bit_errs += popcount8(diff);
+            blk_errs += popcount8(diff);
       }
+      if (blk_errs != 0U)
+         TRACE("fmc read: blk %lu, %lu bit errs", blk, blk_errs);
+      bit_errs += blk_errs;
       const uint32_t now = HAL_GetTick();
       if ((now - t_print) >= 2000U) {
          my_printf("\rblk %lu/%lu  ", (unsigned long)blk + 1UL,
@@ -707,18 +885,11 @@ void fmc_scan(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
 
 static uint32_t pt_total_blocks(void)
 {
-   const nand_pt_t *const pt =
-       (const nand_pt_t *)(FMC_DDR_BUF_ADDR +
-                           (uint32_t)(NAND_BLOCK_PT * BLOCK_BYTES));
-   if (pt->magic != NAND_PT_MAGIC)
-      return 0;
-   uint32_t sum     = 0;
-   const uint8_t *b = (const uint8_t *)pt;
-   for (uint32_t i = 0; i < (uint32_t)offsetof(nand_pt_t, checksum); i++)
-      sum += b[i];
-   if (sum != pt->checksum)
+   const void *raw = (const void *)(FMC_DDR_BUF_ADDR +
+                                    (uint32_t)(NAND_BLOCK_PT * BLOCK_BYTES));
+   if (nand_pt_read(raw, &part_table) != NULL)
       return 0;
-   return pt->total_blocks;
+   return part_table.total_blocks;
 }
 
 /* Flush one good physical block from DDR src to NAND phys.
@@ -772,6 +943,7 @@ void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    const uint32_t ppb      = hnand.Config.BlockSize;
    const uint32_t total    = hnand.Config.PlaneNbr * hnand.Config.PlaneSize;
    const uint32_t max_blks = FMC_DDR_BUF_SIZE / BLOCK_BYTES;
+   (void)cache_fault_block(NAND_BLOCK_PT, 0U);
    const uint32_t pt_n     = pt_total_blocks();
    uint32_t n              = 0U;
    uint32_t erase_tail      = 0U;
@@ -785,6 +957,12 @@ void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    }
    const uint8_t *const ddr = (const uint8_t *)FMC_DDR_BUF_ADDR;
 
+   (void)cache_fault_block(0U, 0U);
+   if (sparse_is_image(ddr, BLOCK_BYTES)) {
+      my_printf("FMC flush: buffer holds a sparse image, use `sparse`\r\n");
+      return;
+   }
+
    fmc_flush_active = 1;
 
    uint32_t written  = 0;
@@ -793,6 +971,7 @@ void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    uint32_t tail_erased = 0;
    uint32_t good_idx = 0;
    uint32_t phys     = 0;
+   uint32_t slipped  = 0;
    const uint32_t t0 = HAL_GetTick();
    uint32_t t_print  = t0;
 
@@ -800,6 +979,18 @@ void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
 
    while (good_idx < n && phys < total) {
       if (!bad[phys]) {
+         /* Blocks never read or written through USB still match NAND and
+          * can be skipped, as long as the image has not been shifted. */
+         if (!slipped && !cache_is_present(good_idx) &&
+             cache_fill[good_idx] == 0U) {
+            skipped++;
+            good_idx++;
+            phys++;
+            continue;
+         }
+         if (cache_fault_block(good_idx, 0U) != 0)
+            my_printf("\rread error blk %lu (flushing DDR as is)\r\n",
+                      (unsigned long)good_idx);
          const uint8_t *const src = ddr + (good_idx * BLOCK_BYTES);
          const int result         = flush_one_block(phys, src, ppb);
          if (result == 0)
@@ -808,6 +999,16 @@ void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
             bad_new++;
          if (result != -1)
             good_idx++;
+         if (result == -1 && !slipped) {
+            /* Every following block now lands one good block later, on top
+             * of its predecessor's old copy.  Pull the rest of the image
+             * into DDR from the old positions before overwriting them. */
+            my_printf("\rreading remaining blocks before shift\r\n");
+            for (uint32_t i = good_idx + 1U; i < n; i++)
+               if (cache_fault_block(i, 1U) != 0)
+                  my_printf("\rread error blk %lu\r\n", (unsigned long)i);
+            slipped = 1U;
+         }
       }
       phys++;
 
@@ -850,27 +1051,114 @@ void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    my_printf("\r\n");
 }
 
-/* Load all blocks of a NAND partition into DDR. Returns 0 on success. */
-static int load_partition(const char *label, const nand_part_t *p, uint8_t *dst)
+/* Read and verify the partition table from NAND into buf_a, and return it
+ * as version 2.  Returns NULL (after saying why, prefixed by who) if there
+ * is no valid table. */
+static const nand_pt_t *read_pt(const char *who)
+{
+   const uint32_t pt_phys = lba_to_phys_block(NAND_BLOCK_PT);
+   if (pt_phys == UINT32_MAX) {
+      my_printf("%s: cannot find PT block\r\n", who);
+      return NULL;
+   }
+   if (read_block(pt_phys, buf_a) != HAL_OK) {
+      my_printf("%s: PT read error\r\n", who);
+      return NULL;
+   }
+
+   const char *why = nand_pt_read(buf_a, &part_table);
+   if (why != NULL) {
+      my_printf("%s: PT %s\r\n", who, why);
+      return NULL;
+   }
+   if (((const nand_pt_t *)buf_a)->version == NAND_PT_V1)
+      my_printf("%s: v1 PT, no image CRCs until the next flash\r\n", who);
+   return &part_table;
+}
+
+/* Set by fmc_load_images for the duration of the load. */
+static int (*load_poll)(void);
+
+/* Load a NAND partition into DDR: all of it, or only the blocks holding the
+ * image the PT entry and the manifest entry e describe.  Each block is
+ * checked against the PT CRC-32 and hashed for e by DMA while the next one
+ * is read.  Stops before a block if load_poll returns nonzero.  Returns 0
+ * on success. */
+static int load_partition(const char *label, const nand_part_t *p, uint8_t *dst,
+                          const manifest_entry_t *e)
 {
-   for (uint32_t i = 0; i < p->num_blocks; i++) {
+   uint32_t hash_left = e ? e->size : 0U;
+   uint32_t crc_left  = p->size;
+   const uint32_t len = (hash_left > crc_left) ? hash_left : crc_left;
+   uint32_t n         = p->num_blocks;
+   if (len != 0U) {
+      n = (len + BLOCK_BYTES - 1U) / BLOCK_BYTES;
+      if (n > p->num_blocks) {
+         my_printf("bload: %s image size %lu exceeds partition\r\n", label,
+                   (unsigned long)len);
+         return -1;
+      }
+   }
+   if (ddr_map_reserve(label, (uint32_t)dst, n * BLOCK_BYTES, 0U) != 0)
+      return -1;
+   if (e)
+      hash_start();
+   if (crc_left != 0U)
+      crc_start(CRC_32);
+
+   for (uint32_t i = 0; i < n; i++) {
+      if (load_poll != NULL && load_poll() != 0) {
+         my_printf("bload: %s load stopped\r\n", label);
+         return -1;
+      }
       const uint32_t phys = lba_to_phys_block(p->start_block + i);
       if (phys == UINT32_MAX) {
          my_printf("bload: %s block %lu missing\r\n", label, (unsigned long)i);
          return -1;
       }
-      if (read_block(phys, dst + (i * BLOCK_BYTES)) != HAL_OK) {
+      uint8_t *blk = dst + (i * BLOCK_BYTES);
+      if (read_block(phys, blk) != HAL_OK) {
          my_printf("bload: %s read error blk %lu\r\n", label, (unsigned long)i);
          return -1;
       }
+      const uint32_t h = (hash_left < BLOCK_BYTES) ? hash_left : BLOCK_BYTES;
+      const uint32_t c = (crc_left < BLOCK_BYTES) ? crc_left : BLOCK_BYTES;
+      if ((h != 0U && hash_feed(blk, h) != 0) ||
+          (c != 0U && crc_feed(blk, c) != 0)) {
+         my_printf("bload: %s DMA error\r\n", label);
+         return -1;
+      }
+      hash_left -= h;
+      crc_left -= c;
    }
-   return 0;
+
+   if (p->size != 0U) {
+      uint32_t crc;
+      if (crc_finish(&crc) != 0) {
+         my_printf("bload: %s CRC DMA timeout\r\n", label);
+         return -1;
+      }
+      if (crc != p->crc32) {
+         my_printf("%s: crc32 mismatch, want %08lx got %08lx\r\n", label,
+                   (unsigned long)p->crc32, (unsigned long)crc);
+         return -1;
+      }
+      my_printf("%s: %lu bytes, crc32 ok\r\n", label, (unsigned long)p->size);
+   }
+   if (!e)
+      return 0;
+   uint8_t digest[HASH_SHA256_LEN];
+   if (hash_finish(digest) != 0) {
+      my_printf("bload: %s HASH peripheral timeout\r\n", label);
+      return -1;
+   }
+   return hash_verify(label, digest, e);
 }
 
 /* Load DTB partition and patch initrd addresses if present.  DTB is optional;
  * returns 0 if dtb_p is NULL (bare kernel boot). */
-static int load_dtb(const nand_part_t *dtb_p, int have_initrd,
-                    uint32_t initrd_end)
+static int load_dtb(const nand_part_t *dtb_p, const manifest_entry_t *e,
+                    int have_initrd, uint32_t initrd_end)
 {
    if (!dtb_p) {
       my_printf("bload: no dtb partition -- booting without DTB\r\n");
@@ -879,93 +1167,227 @@ static int load_dtb(const nand_part_t *dtb_p, int have_initrd,
    my_printf("bload: DTB  blk %lu+%lu -> 0x%08lx\r\n",
              (unsigned long)dtb_p->start_block,
              (unsigned long)dtb_p->num_blocks, (unsigned long)DEF_DTB_ADDR);
-   if (load_partition("DTB", dtb_p, (uint8_t *)DEF_DTB_ADDR) != 0)
+   if (load_partition("dtb", dtb_p, (uint8_t *)DEF_DTB_ADDR, e) != 0)
       return -1;
+   (void)dtb_claim(); /* down to the DTB's own size */
    if (have_initrd)
       return dtb_patch_initrd(DEF_INITRD_ADDR, initrd_end);
    return 0;
 }
 
-void fmc_bload(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+/* The DTB and kernel part of fmc_load_images. */
+static int load_boot(int have_initrd, uint32_t initrd_end)
 {
-   (void)argc;
-   (void)arg1;
-   (void)arg2;
-   (void)arg3;
+   const nand_pt_t *pt = read_pt("bload");
+   if (!pt)
+      return -1;
+
+   /* The manifest shares the PT block, which read_pt left in buf_a. */
+   const manifest_t *m = (const manifest_t *)(buf_a + MANIFEST_NAND_OFFSET);
+   const int have      = manifest_valid(m);
+   if (have < 0)
+      return -1;
+   if (have == 0)
+      my_printf("bload: no image manifest, loading unverified\r\n");
+
+   /* Find kernel and dtb partitions. */
+   const nand_part_t *kern_p = NULL;
+   const nand_part_t *dtb_p  = NULL;
+   for (uint32_t i = 0; i < pt->num_parts && i < NAND_PT_MAX_PARTS; i++) {
+      if (strcmp(pt->parts[i].name, "kernel") == 0)
+         kern_p = &pt->parts[i];
+      else if (strcmp(pt->parts[i].name, "dtb") == 0)
+         dtb_p = &pt->parts[i];
+   }
+   if (!kern_p) {
+      my_printf("bload: no kernel partition\r\n");
+      return -1;
+   }
+   const manifest_entry_t *dtb_e = have ? manifest_find(m, "dtb") : NULL;
+   if (load_dtb(dtb_p, dtb_e, have_initrd, initrd_end) != 0)
+      return -1;
+
+   /* Load kernel, unless a warm reset kept it in DDR. */
+   const manifest_entry_t *kern_e = have ? manifest_find(m, "kernel") : NULL;
+   if (kern_e && warm_check(DEF_LINUX_ADDR, kern_e)) {
+      if (ddr_map_reserve("kernel", DEF_LINUX_ADDR, kern_e->size, 0U) != 0)
+         return -1;
+   } else {
+      my_printf("bload: kernel blk %lu+%lu -> 0x%08lx\r\n",
+                (unsigned long)kern_p->start_block,
+                (unsigned long)kern_p->num_blocks,
+                (unsigned long)DEF_LINUX_ADDR);
+      if (load_partition("kernel", kern_p, (uint8_t *)DEF_LINUX_ADDR,
+                         kern_e) != 0)
+         return -1;
+      if (kern_e)
+         warm_note(DEF_LINUX_ADDR, kern_e);
+   }
+
+   return 0;
+}
+
+int fmc_load_images(int (*poll)(void))
+{
+   static struct dma_req initrd_cp;
+
    if (!nand_ready) {
       my_printf("FMC: not initialised\r\n");
-      return;
+      return -1;
    }
 
-   /* Relocate initrd from USB DDR buffer if present (gzip magic). */
+   /* Relocate initrd from USB DDR buffer if present (gzip magic).  Sectors
+    * only hold meaningful data once written or paged in, so the rest of it
+    * is paged in before the copy. */
    int have_initrd     = 0;
    uint32_t initrd_end = DEF_INITRD_END; /* updated below if size is known */
-   {
+   if (cache_is_present(0U) || cache_fill[0] != 0U) {
       const uint8_t *h = (const uint8_t *)FMC_DDR_BUF_ADDR;
       if (h[0] == 0x1fU && h[1] == 0x8bU) {
          const uint32_t written = fmc_usb_written_bytes();
          const uint32_t max     = DEF_INITRD_END - DEF_INITRD_ADDR;
          if (written > 0U && written <= max)
             initrd_end = DEF_INITRD_ADDR + written;
+         for (uint32_t b = 0U; b * BLOCK_BYTES < initrd_end - DEF_INITRD_ADDR;
+              b++) {
+            if (poll != NULL && poll() != 0) {
+               my_printf("bload: initrd load stopped\r\n");
+               return -1;
+            }
+            if (cache_fault_block(b, 0U) != 0) {
+               my_printf("bload: initrd read error blk %lu\r\n",
+                         (unsigned long)b);
+               return -1;
+            }
+         }
+         if (ddr_map_reserve("initrd", DEF_INITRD_ADDR,
+                             initrd_end - DEF_INITRD_ADDR, 0U) != 0)
+            return -1;
          my_printf("bload: initrd at 0x%08lx -> 0x%08lx (%lu B)\r\n",
                    (unsigned long)FMC_DDR_BUF_ADDR,
                    (unsigned long)DEF_INITRD_ADDR,
                    (unsigned long)(initrd_end - DEF_INITRD_ADDR));
-         memcpy((void *)DEF_INITRD_ADDR, (const void *)FMC_DDR_BUF_ADDR,
-                initrd_end - DEF_INITRD_ADDR);
+         /* copied while the DTB and kernel are read */
+         initrd_cp = (struct dma_req){
+             .dst = (void *)DEF_INITRD_ADDR,
+             .src = (const void *)FMC_DDR_BUF_ADDR,
+             .len = initrd_end - DEF_INITRD_ADDR,
+         };
+         if (dma_memcpy(&initrd_cp) != 0)
+            memcpy(initrd_cp.dst, initrd_cp.src, initrd_cp.len);
          have_initrd = 1;
       }
    }
 
-   /* Read partition table into buf_a. */
-   const uint32_t pt_phys = lba_to_phys_block(NAND_BLOCK_PT);
-   if (pt_phys == UINT32_MAX) {
-      my_printf("bload: cannot find PT block\r\n");
-      return;
-   }
-   if (read_block(pt_phys, buf_a) != HAL_OK) {
-      my_printf("bload: PT read error\r\n");
-      return;
-   }
+   load_poll   = poll;
+   const int r = load_boot(have_initrd, initrd_end);
+   load_poll   = NULL;
+   if (have_initrd && dma_wait(&initrd_cp) != 0)
+      memcpy(initrd_cp.dst, initrd_cp.src, initrd_cp.len);
+   if (r == 0)
+      my_printf("bload: done\r\n");
+   return r;
+}
 
-   const nand_pt_t *pt = (const nand_pt_t *)buf_a;
-   if (pt->magic != NAND_PT_MAGIC) {
-      my_printf("bload: bad PT magic 0x%08lx\r\n", (unsigned long)pt->magic);
-      return;
-   }
-   uint32_t sum      = 0;
-   const uint8_t *pb = (const uint8_t *)pt;
-   for (uint32_t i = 0; i < (uint32_t)offsetof(nand_pt_t, checksum); i++)
-      sum += pb[i];
-   if (sum != pt->checksum) {
-      my_printf("bload: PT checksum mismatch\r\n");
-      return;
+void fmc_bload(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   (void)argc;
+   (void)arg1;
+   (void)arg2;
+   (void)arg3;
+   (void)fmc_load_images(NULL);
+}
+
+void fmc_cache_reset(void)
+{
+   cache_invalidate();
+   usb_written_end_lba = 0U;
+}
+
+uint32_t fmc_block_bytes(void)
+{
+   return BLOCK_BYTES;
+}
+
+int fmc_part_lookup(const char *name, uint32_t *start, uint32_t *blocks)
+{
+   if (!nand_ready)
+      return -1;
+
+   if (strcmp(name, "nand") == 0) {
+      const uint32_t total = hnand.Config.PlaneNbr * hnand.Config.PlaneSize;
+      uint32_t good        = 0U;
+      for (uint32_t b = 0; b + FMC_BBT_RESERVED_BLOCKS < total; b++)
+         if (!bad[b])
+            good++;
+      *start  = 0U;
+      *blocks = good;
+      return 0;
    }
 
-   /* Find kernel and dtb partitions. */
-   const nand_part_t *kern_p = NULL;
-   const nand_part_t *dtb_p  = NULL;
+   const nand_pt_t *pt = read_pt("fmc");
+   if (!pt)
+      return -1;
    for (uint32_t i = 0; i < pt->num_parts && i < NAND_PT_MAX_PARTS; i++) {
-      if (strcmp(pt->parts[i].name, "kernel") == 0)
-         kern_p = &pt->parts[i];
-      else if (strcmp(pt->parts[i].name, "dtb") == 0)
-         dtb_p = &pt->parts[i];
+      if (strncmp(pt->parts[i].name, name, sizeof(pt->parts[i].name)) == 0) {
+         *start  = pt->parts[i].start_block;
+         *blocks = pt->parts[i].num_blocks;
+         return 0;
+      }
    }
-   if (!kern_p) {
-      my_printf("bload: no kernel partition\r\n");
-      return;
+   return -1;
+}
+
+int fmc_read_blocks(uint32_t good_idx, uint8_t *dst, uint32_t n)
+{
+   if (!nand_ready)
+      return -1;
+
+   for (uint32_t i = 0; i < n; i++) {
+      const uint32_t phys = lba_to_phys_block(good_idx + i);
+      if (phys == UINT32_MAX ||
+          read_block(phys, dst + (i * BLOCK_BYTES)) != HAL_OK)
+         return -1;
    }
-   if (load_dtb(dtb_p, have_initrd, initrd_end) != 0)
-      return;
+   return 0;
+}
 
-   /* Load kernel. */
-   my_printf("bload: kernel blk %lu+%lu -> 0x%08lx\r\n",
-             (unsigned long)kern_p->start_block,
-             (unsigned long)kern_p->num_blocks, (unsigned long)DEF_LINUX_ADDR);
-   if (load_partition("kernel", kern_p, (uint8_t *)DEF_LINUX_ADDR) != 0)
-      return;
+int fmc_write_blocks(uint32_t good_idx, const uint8_t *src, uint32_t n)
+{
+   if (!nand_ready)
+      return -1;
 
-   my_printf("bload: done\r\n");
+   for (uint32_t i = 0; i < n; i++) {
+      const uint32_t phys = lba_to_phys_block(good_idx + i);
+      if (phys == UINT32_MAX ||
+          flush_one_block(phys, src + (i * BLOCK_BYTES),
+                          hnand.Config.BlockSize) != 0) {
+         cache_drop(good_idx + i);
+         return -1;
+      }
+      cache_drop(good_idx + i);
+   }
+   return 0;
+}
+
+int fmc_erase_blocks(uint32_t good_idx, uint32_t n)
+{
+   if (!nand_ready)
+      return -1;
+
+   for (uint32_t i = 0; i < n; i++) {
+      const uint32_t phys = lba_to_phys_block(good_idx + i);
+      if (phys == UINT32_MAX)
+         return -1;
+      cache_drop(good_idx + i);
+      if (erase_block(phys) != HAL_OK) {
+         my_printf("\rnewly bad %lu (erase)\r\n", (unsigned long)phys);
+         mark_bad_oob(phys);
+         bad[phys] = 1;
+         return -1;
+      }
+   }
+   return 0;
 }
 
 void fmc_load(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
@@ -977,34 +1399,25 @@ void fmc_load(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
       return;
    }
 
-   const uint32_t total    = hnand.Config.PlaneNbr * hnand.Config.PlaneSize;
    const uint32_t max_blks = FMC_DDR_BUF_SIZE / BLOCK_BYTES;
    const uint32_t n =
        (argc >= 1 && arg1 > 0 && arg1 <= max_blks) ? arg1 : max_blks;
-   uint8_t *const ddr = (uint8_t *)FMC_DDR_BUF_ADDR;
 
+   /* Start from a clean copy: unflushed USB writes are discarded. */
+   cache_invalidate();
    fmc_flush_active = 1;
 
    uint32_t rd_errs  = 0;
    uint32_t good_idx = 0;
-   uint32_t phys     = 0;
    const uint32_t t0 = HAL_GetTick();
    uint32_t t_print  = t0;
 
    my_printf("FMC load: %lu blocks\r\n", (unsigned long)n);
 
-   while (good_idx < n && phys < total) {
-      if (bad[phys]) {
-         phys++;
-         continue;
-      }
-
-      uint8_t *const dst = ddr + (good_idx * BLOCK_BYTES);
-      if (read_block(phys, dst) != HAL_OK)
+   while (good_idx < n) {
+      if (cache_fault_block(good_idx, 0U) != 0)
          rd_errs++;
-
       good_idx++;
-      phys++;
 
       const uint32_t now = HAL_GetTick();
       if ((now - t_print) >= 2000U) {
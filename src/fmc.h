@@ -19,6 +19,11 @@ void fmc_erase_all(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void fmc_scan(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void fmc_flush(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void fmc_load(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+/* Load the kernel and DTB partitions, checking each against the image
+ * manifest if the NAND has one.  poll, if not NULL, is called between
+ * erase blocks, and the load stops once it returns nonzero.  Returns 0 if
+ * the images are fit to boot. */
+int fmc_load_images(int (*poll)(void));
 void fmc_bload(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void fmc_test_boot(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void fmc_test_write(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
@@ -30,6 +35,33 @@ void fmc_test_read(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void fmc_note_usb_write(uint32_t blk_addr, uint16_t blk_len);
 uint32_t fmc_usb_written_bytes(void);
 
+/* Demand paging of the DDR staging buffer behind the USB MSC LUN.
+ * fmc_cache_claim() is called from the USB interrupt before a transfer and
+ * returns 1 if the sectors can be accessed in DDR right away (for writes,
+ * recording them as host data), or 0 if NAND must be read first.  In that
+ * case the main loop calls fmc_cache_fault(), which returns 0 on success or
+ * -1 on a read error.  fmc_cache_poll() prefetches one erase block per call
+ * in the background. */
+int fmc_cache_claim(uint32_t lba, uint32_t sectors, int write);
+int fmc_cache_fault(uint32_t lba, uint32_t sectors);
+void fmc_cache_poll(void);
+
+/* Drop the whole DDR copy and the USB write high-water mark, after the
+ * buffer was used for something other than mirroring NAND. */
+void fmc_cache_reset(void);
+
+/* Direct access by logical (good) erase block, for writers that bypass the
+ * DDR buffer.  fmc_part_lookup() resolves a partition table name, or "nand"
+ * for every good block, to its first block and length.  The read, write and
+ * erase helpers take whole blocks and return -1 on the first error; a block
+ * that goes bad shifts everything after it, so the caller should then
+ * rewrite the full image. */
+uint32_t fmc_block_bytes(void);
+int fmc_part_lookup(const char *name, uint32_t *start, uint32_t *blocks);
+int fmc_read_blocks(uint32_t good_idx, uint8_t *dst, uint32_t n);
+int fmc_write_blocks(uint32_t good_idx, const uint8_t *src, uint32_t n);
+int fmc_erase_blocks(uint32_t good_idx, uint32_t n);
+
 #ifdef NAND_FLASH
 extern volatile int fmc_flush_active;
 #endif
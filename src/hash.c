@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file hash.c
+ * @brief SHA-256 on the HASH peripheral and boot image verification
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "hash.h"
+#include "irq.h"
+#include "manifest.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_mdma.h"
+#include "stm32mp13xx_hal_rcc.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define HASH_ALGO_SHA256 (HASH_CR_ALGO_0 | HASH_CR_ALGO_1)
+#define HASH_DMA_BLOCK   512U /* one SD sector; NAND pages are multiples */
+#define HASH_DMA_MAX     (4095U * HASH_DMA_BLOCK) /* BlockCount limit */
+#define HASH_TIMEOUT_MS  1000U
+
+static MDMA_HandleTypeDef hmdma_hash;
+static int dma_ready;
+static int dma_busy;
+
+/* What the last feed left for the CPU: the bytes after its DMA part. */
+static const uint8_t *cpu_p;
+static uint32_t cpu_n;
+
+static HAL_StatusTypeDef dma_init(void)
+{
+   hmdma_hash.Instance                      = MDMA_CH_HASH;
+   hmdma_hash.Init.Request                  = MDMA_REQUEST_HASH1_IN;
+   hmdma_hash.Init.TransferTriggerMode      = MDMA_BUFFER_TRANSFER;
+   hmdma_hash.Init.Priority                 = MDMA_PRIORITY_MEDIUM;
+   hmdma_hash.Init.SecureMode               = MDMA_SECURE_MODE_DISABLE;
+   hmdma_hash.Init.Endianness               = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+   hmdma_hash.Init.SourceInc                = MDMA_SRC_INC_WORD;
+   hmdma_hash.Init.DestinationInc           = MDMA_DEST_INC_DISABLE;
+   hmdma_hash.Init.SourceDataSize           = MDMA_SRC_DATASIZE_WORD;
+   hmdma_hash.Init.DestDataSize             = MDMA_DEST_DATASIZE_WORD;
+   hmdma_hash.Init.DataAlignment            = MDMA_DATAALIGN_PACKENABLE;
+   hmdma_hash.Init.BufferTransferLength     = 64U; /* one SHA-256 block */
+   hmdma_hash.Init.SourceBurst              = MDMA_SOURCE_BURST_SINGLE;
+   hmdma_hash.Init.DestBurst                = MDMA_DEST_BURST_SINGLE;
+   hmdma_hash.Init.SourceBlockAddressOffset = 0;
+   hmdma_hash.Init.DestBlockAddressOffset   = 0;
+   return HAL_MDMA_Init(&hmdma_hash);
+}
+
+void hash_start(void)
+{
+   __HAL_RCC_HASH1_CLK_ENABLE();
+   __HAL_RCC_MDMA_CLK_ENABLE();
+   if (!dma_ready && dma_init() == HAL_OK)
+      dma_ready = 1;
+   if (dma_busy)
+      (void)HAL_MDMA_Abort(&hmdma_hash);
+   dma_busy = 0;
+   cpu_n    = 0U;
+
+   /* Bytes in memory order (DATATYPE 8-bit); MDMAT keeps the end of each
+    * DMA transfer from closing the message. */
+   HASH->CR = HASH_ALGO_SHA256 | HASH_CR_DATATYPE_1 | HASH_CR_MDMAT |
+              HASH_CR_INIT;
+}
+
+/* Let the running transfer finish, then write the whole words it left. */
+static int drain(void)
+{
+   if (dma_busy) {
+      dma_busy = 0;
+      const HAL_StatusTypeDef r = HAL_MDMA_PollForTransfer(
+          &hmdma_hash, HAL_MDMA_FULL_TRANSFER, HASH_TIMEOUT_MS);
+      HASH->CR &= ~HASH_CR_DMAE;
+      if (r != HAL_OK) {
+         (void)HAL_MDMA_Abort(&hmdma_hash);
+         return -1;
+      }
+   }
+   for (; cpu_n >= 4U; cpu_n -= 4U, cpu_p += 4U) {
+      uint32_t w;
+      memcpy(&w, cpu_p, sizeof(w));
+      HASH->DIN = w;
+   }
+   return 0;
+}
+
+static int dma_start(const uint8_t *p, uint32_t n)
+{
+   HASH->CR |= HASH_CR_DMAE;
+   if (HAL_MDMA_Start(&hmdma_hash, (uint32_t)p, (uint32_t)&HASH->DIN,
+                      HASH_DMA_BLOCK, n / HASH_DMA_BLOCK) != HAL_OK) {
+      HASH->CR &= ~HASH_CR_DMAE;
+      return -1;
+   }
+   dma_busy = 1;
+   return 0;
+}
+
+int hash_feed(const void *buf, uint32_t len)
+{
+   /* cpu_n left over here means the previous chunk ended mid-word. */
+   if (drain() != 0 || cpu_n != 0U)
+      return -1;
+
+   /* MDMA reads DDR, not the cache. */
+   L1C_CleanDCacheAll();
+
+   const uint8_t *p = (const uint8_t *)buf;
+   uint32_t dma_n   = 0U;
+   if (dma_ready && ((uintptr_t)p % 4U) == 0U)
+      dma_n = len - (len % HASH_DMA_BLOCK);
+   while (dma_n > HASH_DMA_MAX) {
+      if (dma_start(p, HASH_DMA_MAX) != 0 || drain() != 0)
+         return -1;
+      p += HASH_DMA_MAX;
+      len -= HASH_DMA_MAX;
+      dma_n -= HASH_DMA_MAX;
+   }
+   if (dma_n != 0U && dma_start(p, dma_n) != 0)
+      return -1;
+   cpu_p = p + dma_n;
+   cpu_n = len - dma_n;
+   return 0;
+}
+
+int hash_finish(uint8_t digest[HASH_SHA256_LEN])
+{
+   if (drain() != 0)
+      return -1;
+
+   uint32_t nbits = 0U;
+   if (cpu_n != 0U) {
+      uint32_t w = 0U;
+      memcpy(&w, cpu_p, cpu_n);
+      HASH->DIN = w;
+      nbits     = cpu_n * 8U;
+      cpu_n     = 0U;
+   }
+   HASH->STR = nbits;
+   HASH->STR = nbits | HASH_STR_DCAL;
+
+   const uint32_t t0 = HAL_GetTick();
+   while (!(HASH->SR & HASH_SR_DCIS))
+      if (HAL_GetTick() - t0 >= HASH_TIMEOUT_MS)
+         return -1;
+
+   for (uint32_t i = 0; i < HASH_SHA256_LEN / 4U; i++) {
+      const uint32_t w    = HASH_DIGEST->HR[i];
+      digest[4U * i]      = (uint8_t)(w >> 24U);
+      digest[4U * i + 1U] = (uint8_t)(w >> 16U);
+      digest[4U * i + 2U] = (uint8_t)(w >> 8U);
+      digest[4U * i + 3U] = (uint8_t)w;
+   }
+   return 0;
+}
+
+int hash_sha256(const void *buf, uint32_t len,
+                uint8_t digest[HASH_SHA256_LEN])
+{
+   hash_start();
+   if (hash_feed(buf, len) != 0)
+      return -1;
+   return hash_finish(digest);
+}
+
+int manifest_valid(const manifest_t *m)
+{
+   if (m->magic != MANIFEST_MAGIC)
+      return 0;
+
+   uint8_t d[HASH_SHA256_LEN];
+   if (m->version != MANIFEST_VERSION ||
+       m->num_images > MANIFEST_MAX_IMAGES ||
+       hash_sha256(m, offsetof(manifest_t, sha256), d) != 0 ||
+       memcmp(d, m->sha256, sizeof(d)) != 0) {
+      my_printf("manifest: damaged\r\n");
+      return -1;
+   }
+   return 1;
+}
+
+const manifest_entry_t *manifest_find(const manifest_t *m, const char *name)
+{
+   for (uint32_t i = 0; i < m->num_images; i++)
+      if (strncmp(m->images[i].name, name, sizeof(m->images[i].name)) == 0)
+         return &m->images[i];
+   return NULL;
+}
+
+static void print_digest(const uint8_t *d)
+{
+   for (uint32_t i = 0; i < HASH_SHA256_LEN; i++)
+      my_printf("%02x", d[i]);
+}
+
+int hash_verify(const char *label, const uint8_t digest[HASH_SHA256_LEN],
+                const manifest_entry_t *e)
+{
+   if (memcmp(digest, e->sha256, HASH_SHA256_LEN) == 0) {
+      my_printf("%s: %lu bytes, sha256 ok\r\n", label,
+                (unsigned long)e->size);
+      return 0;
+   }
+   my_printf("%s: sha256 mismatch\r\n  want ", label);
+   print_digest(e->sha256);
+   my_printf("\r\n  got  ");
+   print_digest(digest);
+   my_printf("\r\n");
+   return -1;
+}
+
+void sha256_cmd(int argc, uint32_t addr, uint32_t len, uint32_t arg3)
+{
+   (void)arg3;
+   if (argc < 2) {
+      my_printf("usage: sha256 addr len\r\n");
+      return;
+   }
+
+   uint8_t d[HASH_SHA256_LEN];
+   const uint32_t t0 = HAL_GetTick();
+   if (hash_sha256((const void *)addr, len, d) != 0) {
+      my_printf("sha256: HASH peripheral timeout\r\n");
+      return;
+   }
+   const uint32_t ms = HAL_GetTick() - t0;
+   print_digest(d);
+   /* bytes per ms is kB/s */
+   my_printf("  (%lu ms, %lu kB/s)\r\n", (unsigned long)ms,
+             (unsigned long)((ms != 0U) ? len / ms : 0U));
+}
+
+// end file hash.c
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file hash.h
+ * @brief SHA-256 on the HASH peripheral and boot image verification
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * hash_feed() hands a chunk to MDMA, which writes it into the HASH input
+ * FIFO while the caller goes on to read the next chunk from storage, so a
+ * loader that feeds each chunk as soon as it lands in DDR gets the digest
+ * almost for free.  A chunk must stay untouched until the next hash call.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include "manifest.h"
+#include <stdint.h>
+
+#define HASH_SHA256_LEN 32U
+
+/* Start a new SHA-256. */
+void hash_start(void);
+
+/* Add len bytes at buf, returning while the transfer runs.  Every chunk
+ * but the last must be a multiple of four bytes long.  Returns 0, or -1 on
+ * a DMA error. */
+int hash_feed(const void *buf, uint32_t len);
+
+/* Wait for the data fed so far and store the digest.  Returns 0, or -1 if
+ * the peripheral did not finish. */
+int hash_finish(uint8_t digest[HASH_SHA256_LEN]);
+
+/* Digest of one buffer. */
+int hash_sha256(const void *buf, uint32_t len,
+                uint8_t digest[HASH_SHA256_LEN]);
+
+/* 1 if m is a manifest whose own digest matches, 0 if there is none, -1
+ * (after saying so) if it is damaged. */
+int manifest_valid(const manifest_t *m);
+
+/* The entry named name, or NULL. */
+const manifest_entry_t *manifest_find(const manifest_t *m, const char *name);
+
+/* Compare a loaded image's digest with its manifest entry and report the
+ * result.  Returns 0 if they match. */
+int hash_verify(const char *label, const uint8_t digest[HASH_SHA256_LEN],
+                const manifest_entry_t *e);
+
+/* sha256 addr len: print the digest of a memory range. */
+void sha256_cmd(int argc, uint32_t addr, uint32_t len, uint32_t arg3);
+
+#endif // HASH_H
+
+// end file hash.h
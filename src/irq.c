@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file irq.c
+ * @brief Masking IRQs around short critical sections
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "irq.h"
+#include "stm32mp135fxx_ca7.h"
+#include <stdint.h>
+
+#define CPSR_I 0x80U
+
+uint32_t irq_save(void)
+{
+   const uint32_t cpsr = __get_CPSR();
+   __disable_irq();
+   return cpsr;
+}
+
+void irq_restore(uint32_t cpsr)
+{
+   if ((cpsr & CPSR_I) == 0U)
+      __enable_irq();
+}
+
+// end file irq.c
@@ -10,6 +10,8 @@
 #ifndef IRQ_H
 #define IRQ_H
 
+#include <stdint.h>
+
 #define ENTER_CRITICAL_SECTION(periph) ((void)0)
 #define EXIT_CRITICAL_SECTION(periph)  ((void)0)
 
@@ -18,12 +20,27 @@ enum {
    PRIO_SD     = 1,
    PRIO_ETH    = 4,
    PRIO_USB    = 5,
+   PRIO_DMA    = 6,
    PRIO_UART   = 7,
    PRIO_TICK   = 10,
    PRIO_GPIO   = 15,
    PRIO_LTDC   = 16,
 };
 
+/* MDMA channels, one per user.  The NAND sequencer needs three. */
+#define MDMA_CH_NAND_RD  MDMA_Channel0
+#define MDMA_CH_NAND_WR  MDMA_Channel1
+#define MDMA_CH_NAND_ECC MDMA_Channel2
+#define MDMA_CH_HASH     MDMA_Channel3
+#define MDMA_CH_CRC      MDMA_Channel4
+#define MDMA_CH_BENCH    MDMA_Channel5 /* ddr_bench */
+#define MDMA_CH_COPY     MDMA_Channel6 /* dma_memcpy */
+
+/* Mask IRQs and return the CPSR from before, for irq_restore(), which
+ * unmasks them again only if they were unmasked then.  Pairs nest. */
+uint32_t irq_save(void);
+void irq_restore(uint32_t cpsr);
+
 void reset_handler(void) __attribute__((naked, target("arm")));
 void vectors(void) __attribute__((naked, section("RESET")));
 
@@ -42,5 +59,6 @@ void EXTI8_IRQHandler(void);
 void UART4_IRQHandler(void);
 void EXTI12_IRQHandler(void);
 void EXTI5_IRQHandler(void);
+void MDMA_IRQHandler(void);
 
 #endif // IRQ_H
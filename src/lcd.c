@@ -13,6 +13,8 @@
 #ifdef LCD_DISPLAY
 
 #include "ctp.h"
+#include "ddr_map.h"
+#include "dma.h"
 #include "irq.h"
 #include "irq_ctrl.h"
 #include "printf.h"
@@ -33,9 +35,13 @@ struct lcd_pin_cfg {
    uint32_t af;
 };
 
+#define ROW_BYTES (LCD_WIDTH * 3U) /* RGB888 */
+#define FB_BYTES  (ROW_BYTES * LCD_HEIGHT)
+
 /* global variables */
 static TIM_HandleTypeDef htim1;
 static LTDC_HandleTypeDef hltdchandler;
+static volatile uint8_t *lcd_fb;
 
 static void lcd_backlight_init(void)
 {
@@ -111,6 +117,11 @@ static void lcd_panel_pin_setup(void)
 
 static void lcd_panel_init(void)
 {
+   const uint32_t fb = ddr_map_alloc("lcd_fb", FB_BYTES, 0U);
+   if (fb == 0U)
+      return;
+   lcd_fb = (volatile uint8_t *)fb;
+
    /* Timing Configuration */
    hltdchandler.Init.HorizontalSync = (LCD_HSYNC - (uint16_t)1);
    hltdchandler.Init.VerticalSync   = (LCD_VSYNC - (uint16_t)1);
@@ -160,7 +171,7 @@ static void lcd_panel_init(void)
    layer_cfg.WindowY0        = 0;
    layer_cfg.WindowY1        = LCD_HEIGHT;
    layer_cfg.PixelFormat     = LTDC_PIXEL_FORMAT_RGB888;
-   layer_cfg.FBStartAdress   = DRAM_MEM_BASE;
+   layer_cfg.FBStartAdress   = fb;
    layer_cfg.Alpha           = 255;
    layer_cfg.Alpha0          = 0;
    layer_cfg.Backcolor.Blue  = 0;
@@ -207,15 +218,21 @@ void lcd_backlight(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
 void lcd_color(int argc, uint32_t r, uint32_t g, uint32_t b)
 {
    (void)argc;
-   volatile uint8_t *lcd_fb = (volatile uint8_t *)DRAM_MEM_BASE;
-
-   for (uint32_t y = 0; y < LCD_HEIGHT; y++) {
-      for (uint32_t x = 0; x < LCD_WIDTH; x++) {
-         uint32_t p    = (y * LCD_WIDTH + x) * 3U;
-         lcd_fb[p + 0] = b; // blue
-         lcd_fb[p + 1] = g; // green
-         lcd_fb[p + 2] = r; // red
-      }
+   if (lcd_fb == NULL)
+      return;
+
+   for (uint32_t x = 0; x < LCD_WIDTH; x++) {
+      const uint32_t p = x * 3U;
+      lcd_fb[p + 0]    = b; // blue
+      lcd_fb[p + 1]    = g; // green
+      lcd_fb[p + 2]    = r; // red
+   }
+
+   /* the other rows by MDMA, doubling the filled part each time */
+   for (uint32_t done = ROW_BYTES; done < FB_BYTES;) {
+      const uint32_t n = (done < FB_BYTES - done) ? done : FB_BYTES - done;
+      dma_copy((void *)(lcd_fb + done), (const void *)lcd_fb, n);
+      done += n;
    }
 
    /* make sure CPU writes reach DDR before LTDC reads */
@@ -10,12 +10,17 @@
 #include "board.h"
 #include "cmd.h"
 #include "ddr.h"
+#include "ddr_map.h"
 #include "eth.h"
 #include "fmc.h"
+#include "net.h"
+#include "netcon.h"
 #include "setup.h"
 #include "stm32mp135fxx_ca7.h"
 #include "stm32mp13xx_hal.h"
 #include "stm32mp13xx_hal_gpio.h"
+#include "trace.h"
+#include "usb_msc.h"
 #include <stdint.h>
 
 #ifndef NAND_FLASH
@@ -26,10 +31,6 @@
 #include "lcd.h"
 #endif
 
-#ifndef BOOT_TIMEOUT
-#define BOOT_TIMEOUT 3
-#endif
-
 static void blink(void)
 {
    static uint32_t last_blink = 0;
@@ -52,6 +53,12 @@ int main(void)
    gpio_init();
    ddr_init();
    mmu_init();
+   ddr_map_init();
+   trace_init();
+   TRACE("boot: DDR and MMU up at %lu ms", HAL_GetTick());
+   /* The PHY resets and negotiates while storage comes up. */
+   eth_init();
+   net_init();
 #ifndef NAND_FLASH
    sd_init();
 #endif
@@ -62,15 +69,22 @@ int main(void)
    lcd_init();
 #endif
    blink();
+   TRACE("boot: storage up at %lu ms", HAL_GetTick());
 
    cmd_init();
    cmd_autoboot();
 
-   eth_init();
    usb_init();
+   TRACE("boot: main loop at %lu ms", HAL_GetTick());
 
    while (1) {
       cmd_poll();
+      usb_msc_poll();
+      net_poll();
+      netcon_poll();
+#ifdef NAND_FLASH
+      fmc_cache_poll();
+#endif
       blink();
    }
 
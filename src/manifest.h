@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+/**
+ * @file manifest.h
+ * @brief Boot image manifest layout (shared between firmware, sdimage.py
+ * and nandimage.py).
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * The manifest lists the length and SHA-256 of each boot image, named as
+ * flash_lookup() names partitions ("kernel", "dtb").  It sits in SD sector
+ * MANIFEST_SD_LBA, or at MANIFEST_NAND_OFFSET in the NAND partition table
+ * block.  Images without an entry load unverified.
+ */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <stdint.h>
+
+#define MANIFEST_MAGIC       0x4D414E49U /* "MANI" */
+#define MANIFEST_VERSION     1U
+#define MANIFEST_MAX_IMAGES  4U
+#define MANIFEST_SD_LBA      1U     /* between the MBR and the bootloader */
+#define MANIFEST_NAND_OFFSET 4096U /* second page of the PT block */
+
+typedef struct {
+   char name[16];
+   uint32_t size; /* bytes covered by sha256 */
+   uint8_t sha256[32];
+} manifest_entry_t;
+
+/* Total size: 4+4+4 + 4*52 + 32 = 252 bytes; fits in one SD sector. */
+typedef struct {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t num_images;
+   manifest_entry_t images[MANIFEST_MAX_IMAGES];
+   uint8_t sha256[32]; /* of all preceding bytes */
+} manifest_t;
+
+#endif /* MANIFEST_H */
@@ -0,0 +1,496 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file memtest.c
+ * @brief DDR memory test
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "memtest.h"
+#include "board.h"
+#include "console.h"
+#include "ddr_map.h"
+#include "defaults.h"
+#include "prng.h"
+#include "printf.h"
+#include "setup.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include <stdint.h>
+
+#ifdef NAND_FLASH
+#include "fmc.h"
+#endif
+
+#define MIB        0x100000U
+#define LINE_WORDS 16U   /* 64 bytes, one cache line */
+#define PRBS_WORDS 1024U /* generated per step */
+#define MT_SHOW    20U   /* failing words printed */
+#define MT_RANGES  24U
+#define MT_SEED    UINT64_C(0x2545F4914F6CDD1D)
+
+struct range {
+   uint32_t lo, hi;
+};
+
+static struct {
+   uint32_t errors;
+   uint32_t bits; /* OR of all differences */
+   uint32_t shown;
+} st;
+
+static uint32_t prbs_buf[PRBS_WORDS] __attribute__((aligned(16)));
+
+/* Write v over [p, end), a line at a time. */
+static void fill(uint32_t *p, const uint32_t *end, uint32_t v)
+{
+   __asm volatile("   vdup.32 q8, %[v]\n"
+                  "   vmov    q9, q8\n"
+                  "1: vst1.64 {d16-d19}, [%[p]:128]!\n"
+                  "   vst1.64 {d16-d19}, [%[p]:128]!\n"
+                  "   cmp     %[p], %[e]\n"
+                  "   blo     1b\n"
+                  : [p] "+r"(p)
+                  : [e] "r"(end), [v] "r"(v)
+                  : "d16", "d17", "d18", "d19", "cc", "memory");
+}
+
+/* Copy the n words at src (n a multiple of LINE_WORDS) to p. */
+static void copy(uint32_t *p, const uint32_t *src, uint32_t n)
+{
+   const uint32_t *const end = src + n;
+   __asm volatile("1: vld1.64 {d0-d3}, [%[s]:128]!\n"
+                  "   vld1.64 {d4-d7}, [%[s]:128]!\n"
+                  "   vst1.64 {d0-d3}, [%[p]:128]!\n"
+                  "   vst1.64 {d4-d7}, [%[p]:128]!\n"
+                  "   cmp     %[s], %[e]\n"
+                  "   blo     1b\n"
+                  : [p] "+r"(p), [s] "+r"(src)
+                  : [e] "r"(end)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc",
+                    "memory");
+}
+
+/* One ascending March element over [p, end): check that each line holds
+ * x, then write w to it.  Returns the first line that does not hold x,
+ * left as it was, or end. */
+static uint32_t *march_up(uint32_t *p, const uint32_t *end, uint32_t x,
+                          uint32_t w)
+{
+   uint32_t a, b;
+   __asm volatile("   vdup.32 q8, %[x]\n"
+                  "   vdup.32 q9, %[w]\n"
+                  "   vmov    q10, q9\n"
+                  "1: cmp     %[p], %[e]\n"
+                  "   bhs     2f\n"
+                  "   vld1.64 {d0-d3}, [%[p]:128]!\n"
+                  "   vld1.64 {d4-d7}, [%[p]:128]\n"
+                  "   sub     %[p], %[p], #32\n"
+                  "   veor    q0, q0, q8\n"
+                  "   veor    q1, q1, q8\n"
+                  "   veor    q2, q2, q8\n"
+                  "   veor    q3, q3, q8\n"
+                  "   vorr    q0, q0, q1\n"
+                  "   vorr    q2, q2, q3\n"
+                  "   vorr    q0, q0, q2\n"
+                  "   vorr    d0, d0, d1\n"
+                  "   vmov    %[a], %[b], d0\n"
+                  "   orrs    %[a], %[a], %[b]\n"
+                  "   bne     2f\n"
+                  "   vst1.64 {d18-d21}, [%[p]:128]!\n"
+                  "   vst1.64 {d18-d21}, [%[p]:128]!\n"
+                  "   b       1b\n"
+                  "2:\n"
+                  : [p] "+r"(p), [a] "=&r"(a), [b] "=&r"(b)
+                  : [e] "r"(end), [x] "r"(x), [w] "r"(w)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d16",
+                    "d17", "d18", "d19", "d20", "d21", "cc", "memory");
+   return p;
+}
+
+/* The same, descending from hi to lo.  Returns the first bad line, or hi. */
+static uint32_t *march_down(const uint32_t *lo, uint32_t *hi, uint32_t x,
+                            uint32_t w)
+{
+   uint32_t *p = hi;
+   uint32_t a, b;
+   __asm volatile("   vdup.32 q8, %[x]\n"
+                  "   vdup.32 q9, %[w]\n"
+                  "   vmov    q10, q9\n"
+                  "1: cmp     %[p], %[l]\n"
+                  "   bls     3f\n"
+                  "   sub     %[p], %[p], #64\n"
+                  "   vld1.64 {d0-d3}, [%[p]:128]!\n"
+                  "   vld1.64 {d4-d7}, [%[p]:128]\n"
+                  "   sub     %[p], %[p], #32\n"
+                  "   veor    q0, q0, q8\n"
+                  "   veor    q1, q1, q8\n"
+                  "   veor    q2, q2, q8\n"
+                  "   veor    q3, q3, q8\n"
+                  "   vorr    q0, q0, q1\n"
+                  "   vorr    q2, q2, q3\n"
+                  "   vorr    q0, q0, q2\n"
+                  "   vorr    d0, d0, d1\n"
+                  "   vmov    %[a], %[b], d0\n"
+                  "   orrs    %[a], %[a], %[b]\n"
+                  "   bne     2f\n"
+                  "   vst1.64 {d18-d21}, [%[p]:128]!\n"
+                  "   vst1.64 {d18-d21}, [%[p]:128]\n"
+                  "   sub     %[p], %[p], #32\n"
+                  "   b       1b\n"
+                  "3: mov     %[p], %[h]\n"
+                  "2:\n"
+                  : [p] "+r"(p), [a] "=&r"(a), [b] "=&r"(b)
+                  : [l] "r"(lo), [h] "r"(hi), [x] "r"(x), [w] "r"(w)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d16",
+                    "d17", "d18", "d19", "d20", "d21", "cc", "memory");
+   return p;
+}
+
+/* Compare [p, end) with ref.  Returns the first line that differs, or end. */
+static uint32_t *compare(uint32_t *p, const uint32_t *end, const uint32_t *ref)
+{
+   uint32_t a, b;
+   __asm volatile("1: cmp     %[p], %[e]\n"
+                  "   bhs     2f\n"
+                  "   vld1.64 {d0-d3}, [%[p]:128]!\n"
+                  "   vld1.64 {d4-d7}, [%[p]:128]!\n"
+                  "   vld1.64 {d16-d19}, [%[r]:128]!\n"
+                  "   vld1.64 {d20-d23}, [%[r]:128]!\n"
+                  "   veor    q0, q0, q8\n"
+                  "   veor    q1, q1, q9\n"
+                  "   veor    q2, q2, q10\n"
+                  "   veor    q3, q3, q11\n"
+                  "   vorr    q0, q0, q1\n"
+                  "   vorr    q2, q2, q3\n"
+                  "   vorr    q0, q0, q2\n"
+                  "   vorr    d0, d0, d1\n"
+                  "   vmov    %[a], %[b], d0\n"
+                  "   orrs    %[a], %[a], %[b]\n"
+                  "   beq     1b\n"
+                  "   sub     %[p], %[p], #64\n"
+                  "2:\n"
+                  : [p] "+r"(p), [r] "+r"(ref), [a] "=&r"(a), [b] "=&r"(b)
+                  : [e] "r"(end)
+                  : "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d16",
+                    "d17", "d18", "d19", "d20", "d21", "d22", "d23", "cc",
+                    "memory");
+   return p;
+}
+
+static void bad_word(uint32_t addr, uint32_t got, uint32_t want)
+{
+   st.errors++;
+   st.bits |= got ^ want;
+   if (st.shown++ < MT_SHOW)
+      my_printf("  0x%08lx: read %08lx, expected %08lx, bits %08lx\r\n",
+                (unsigned long)addr, (unsigned long)got,
+                (unsigned long)want, (unsigned long)(got ^ want));
+}
+
+/* Name the words of a line the NEON loop found bad, comparing with ref if
+ * given, else with x. */
+static void bad_line(const uint32_t *line, uint32_t x, const uint32_t *ref)
+{
+   const volatile uint32_t *const v = line;
+   int found                        = 0;
+   for (uint32_t i = 0U; i < LINE_WORDS; i++) {
+      const uint32_t want = (ref != NULL) ? ref[i] : x;
+      const uint32_t got  = v[i];
+      if (got != want) {
+         bad_word((uint32_t)&line[i], got, want);
+         found = 1;
+      }
+   }
+   if (!found) {
+      st.errors++;
+      if (st.shown++ < MT_SHOW)
+         my_printf("  0x%08lx: line read back differently\r\n",
+                   (unsigned long)line);
+   }
+}
+
+static void set_line(uint32_t *line, uint32_t w)
+{
+   for (uint32_t i = 0U; i < LINE_WORDS; i++)
+      line[i] = w;
+}
+
+static void data_bus(volatile uint32_t *p)
+{
+   const uint32_t orig = *p;
+   for (uint32_t b = 1U; b != 0U; b <<= 1) {
+      *p = b;
+      L1C_CleanInvalidateDCacheMVA((void *)p);
+      __DSB();
+      const uint32_t v = *p;
+      if (v != b)
+         bad_word((uint32_t)p, v, b);
+   }
+   *p = orig;
+}
+
+/* Each address line on its own: a word at every power-of-two offset, all
+ * put back afterwards. */
+static void addr_bus(void)
+{
+   volatile uint32_t *const base = (volatile uint32_t *)DEF_DDR_BASE;
+   const uint32_t nwords         = DDR_MEM_SIZE / 4U;
+   const uint32_t pat            = 0xAAAAAAAAU;
+   const uint32_t anti           = 0x55555555U;
+   uint32_t saved[32];
+   uint32_t n = 0U;
+
+   saved[n++] = base[0];
+   for (uint32_t off = 1U; off < nwords; off <<= 1)
+      saved[n++] = base[off];
+
+   for (uint32_t off = 1U; off < nwords; off <<= 1)
+      base[off] = pat;
+   base[0] = anti;
+   L1C_CleanInvalidateDCacheAll();
+   for (uint32_t off = 1U; off < nwords; off <<= 1)
+      if (base[off] != pat) /* stuck high, or shorted to another line */
+         bad_word((uint32_t)&base[off], base[off], pat);
+   base[0] = pat;
+
+   for (uint32_t t = 1U; t < nwords; t <<= 1) {
+      base[t] = anti;
+      L1C_CleanInvalidateDCacheAll();
+      if (base[0] != pat) /* stuck low */
+         bad_word((uint32_t)&base[0], base[0], pat);
+      for (uint32_t off = 1U; off < nwords; off <<= 1)
+         if (off != t && base[off] != pat) /* shorted */
+            bad_word((uint32_t)&base[off], base[off], pat);
+      base[t] = pat;
+   }
+
+   n        = 0U;
+   base[0] = saved[n++];
+   for (uint32_t off = 1U; off < nwords; off <<= 1)
+      base[off] = saved[n++];
+}
+
+static void el_up(const struct range *r, uint32_t x, uint32_t w)
+{
+   uint32_t *p         = (uint32_t *)r->lo;
+   uint32_t *const end = (uint32_t *)r->hi;
+   while ((p = march_up(p, end, x, w)) < end) {
+      bad_line(p, x, NULL);
+      set_line(p, w);
+      p += LINE_WORDS;
+   }
+}
+
+static void el_down(const struct range *r, uint32_t x, uint32_t w)
+{
+   uint32_t *top = (uint32_t *)r->hi;
+   for (;;) {
+      uint32_t *const p = march_down((const uint32_t *)r->lo, top, x, w);
+      if (p == top)
+         break;
+      bad_line(p, x, NULL);
+      set_line(p, w);
+      top = p;
+   }
+}
+
+/* March C-: up(w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0);
+ * up(r0).  The last element writes back what it read.  Returns -1 if
+ * interrupted. */
+static int march(const struct range *r, uint32_t n)
+{
+   static const struct {
+      int down;
+      uint32_t x, w;
+   } el[] = {
+       {0, 0U, ~0U},
+       {0, ~0U, 0U},
+       {1, 0U, ~0U},
+       {1, ~0U, 0U},
+       {0, 0U, 0U},
+   };
+
+   for (uint32_t i = 0U; i < n; i++)
+      fill((uint32_t *)r[i].lo, (const uint32_t *)r[i].hi, 0U);
+
+   for (uint32_t e = 0U; e < sizeof(el) / sizeof(el[0]); e++) {
+      L1C_CleanInvalidateDCacheAll();
+      for (uint32_t i = 0U; i < n; i++) {
+         if (el[e].down)
+            el_down(&r[n - 1U - i], el[e].x, el[e].w);
+         else
+            el_up(&r[i], el[e].x, el[e].w);
+      }
+      if (console_interrupted())
+         return -1;
+   }
+   return 0;
+}
+
+static int prbs(const struct range *r, uint32_t n)
+{
+   uint64_t seed = MT_SEED;
+   for (uint32_t i = 0U; i < n; i++) {
+      for (uint32_t a = r[i].lo; a < r[i].hi; a += sizeof(prbs_buf)) {
+         prng_fill((uint8_t *)prbs_buf, sizeof(prbs_buf), &seed);
+         copy((uint32_t *)a, prbs_buf, PRBS_WORDS);
+      }
+      if (console_interrupted())
+         return -1;
+   }
+
+   L1C_CleanInvalidateDCacheAll();
+   seed = MT_SEED;
+   for (uint32_t i = 0U; i < n; i++) {
+      for (uint32_t a = r[i].lo; a < r[i].hi; a += sizeof(prbs_buf)) {
+         prng_fill((uint8_t *)prbs_buf, sizeof(prbs_buf), &seed);
+         uint32_t *const p   = (uint32_t *)a;
+         uint32_t *const end = p + PRBS_WORDS;
+         uint32_t *q         = p;
+         while ((q = compare(q, end, &prbs_buf[q - p])) < end) {
+            bad_line(q, 0U, &prbs_buf[q - p]);
+            q += LINE_WORDS;
+         }
+      }
+      if (console_interrupted())
+         return -1;
+   }
+   return 0;
+}
+
+static void add_ex(struct range *ex, uint32_t *n, uint32_t lo, uint32_t hi)
+{
+   /* whole PRBS steps, kept sorted by lo */
+   lo &= ~(sizeof(prbs_buf) - 1U);
+   hi = (hi + sizeof(prbs_buf) - 1U) & ~(sizeof(prbs_buf) - 1U);
+   uint32_t i = (*n)++;
+   for (; i > 0U && ex[i - 1U].lo > lo; i--)
+      ex[i] = ex[i - 1U];
+   ex[i].lo = lo;
+   ex[i].hi = hi;
+}
+
+/* DDR less the live regions of the DDR map and, with skip, less every
+ * region and the download areas as well. */
+static uint32_t build_ranges(struct range *r, int skip)
+{
+   struct range ex[MT_RANGES];
+   uint32_t nex = 0U;
+
+   const struct ddr_region *g;
+   for (uint32_t i = 0U; (g = ddr_map_get(i)) != NULL; i++)
+      if (skip || (g->flags & DDR_MAP_LIVE))
+         add_ex(ex, &nex, g->addr, g->addr + g->size);
+   if (skip) {
+      add_ex(ex, &nex, DEF_RAMDISK_ADDR, DEF_RAMDISK_ADDR + DEF_RAMDISK_SIZE);
+      add_ex(ex, &nex, FMC_DDR_BUF_ADDR, FMC_DDR_BUF_ADDR + FMC_DDR_BUF_SIZE);
+      add_ex(ex, &nex, DEF_INITRD_ADDR, DEF_INITRD_END);
+      add_ex(ex, &nex, DEF_FASTBOOT_ADDR,
+             DEF_FASTBOOT_ADDR + DEF_FASTBOOT_SIZE);
+   }
+
+   uint32_t n         = 0U;
+   uint32_t cur       = DEF_DDR_BASE;
+   const uint32_t end = DEF_DDR_BASE + DDR_MEM_SIZE;
+   for (uint32_t i = 0U; i < nex && n < MT_RANGES; i++) {
+      if (ex[i].lo > cur) {
+         r[n].lo = cur;
+         r[n].hi = ex[i].lo;
+         n++;
+      }
+      if (ex[i].hi > cur)
+         cur = ex[i].hi;
+   }
+   if (cur < end && n < MT_RANGES) {
+      r[n].lo = cur;
+      r[n].hi = end;
+      n++;
+   }
+   return n;
+}
+
+static void result(const char *name, uint32_t errors, uint32_t t0)
+{
+   my_printf("%-9s %s", name, (st.errors == errors) ? "ok" : "FAILED");
+   if (st.errors != errors)
+      my_printf(" (%lu)", (unsigned long)(st.errors - errors));
+   my_printf(", %lu ms\r\n", (unsigned long)(HAL_GetTick() - t0));
+}
+
+void memtest_cmd(int argc, uint32_t tests, uint32_t skip, uint32_t arg3)
+{
+   (void)arg3;
+   if (argc < 1 || tests == 0U)
+      tests = MEMTEST_ALL;
+   if (argc < 2)
+      skip = 0U;
+
+   struct range r[MT_RANGES];
+   const uint32_t n = build_ranges(r, skip != 0U);
+   uint32_t total   = 0U;
+   for (uint32_t i = 0U; i < n; i++)
+      total += r[i].hi - r[i].lo;
+
+   st.errors = 0U;
+   st.bits   = 0U;
+   st.shown  = 0U;
+   /* The passes stream whole lines through the cache, which would
+    * otherwise leave every access to strongly-ordered DDR. */
+   const uint32_t sctlr = dcache_on();
+   my_printf("memtest: %lu MiB in %lu ranges, D-cache %s\r\n",
+             (unsigned long)(total / MIB), (unsigned long)n,
+             ((__get_SCTLR() & SCTLR_C_Msk) != 0U) ? "on" : "off");
+   if (n == 0U) {
+      dcache_restore(sctlr);
+      return;
+   }
+
+   int stop = 0;
+   uint32_t t0, e0;
+   if (tests & MEMTEST_DATA) {
+      t0 = HAL_GetTick();
+      e0 = st.errors;
+      data_bus((volatile uint32_t *)r[0].lo);
+      result("data bus", e0, t0);
+   }
+   if (tests & MEMTEST_ADDR) {
+      t0 = HAL_GetTick();
+      e0 = st.errors;
+      addr_bus();
+      result("addr bus", e0, t0);
+   }
+   if (!stop && (tests & MEMTEST_MARCH)) {
+      t0   = HAL_GetTick();
+      e0   = st.errors;
+      stop = march(r, n);
+      result("march C-", e0, t0);
+   }
+   if (!stop && (tests & MEMTEST_PRBS)) {
+      t0   = HAL_GetTick();
+      e0   = st.errors;
+      stop = prbs(r, n);
+      result("prbs", e0, t0);
+   }
+   dcache_restore(sctlr);
+
+#ifdef NAND_FLASH
+   /* The page cache no longer matches NAND. */
+   if (!skip && (tests & (MEMTEST_MARCH | MEMTEST_PRBS)))
+      fmc_cache_reset();
+#endif
+
+   if (stop)
+      my_printf("interrupted\r\n");
+   if (st.errors == 0U) {
+      my_printf("memtest: no errors\r\n");
+   } else {
+      /* 16-bit bus: bits n and n + 16 of a word are both DQn */
+      my_printf("memtest: %lu errors, bits %08lx (DQ %04lx)\r\n",
+                (unsigned long)st.errors, (unsigned long)st.bits,
+                (unsigned long)((st.bits | (st.bits >> 16)) & 0xFFFFU));
+   }
+}
+
+// end file memtest.c
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file memtest.h
+ * @brief DDR memory test
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * The data and address bus tests touch a few words and put them back.
+ * March C- and the PRBS pass write everything they test, in 64-byte lines
+ * through NEON with the data cache turned on for the run, so each line
+ * goes to DDR in one burst; the caches are cleaned between passes so every
+ * read comes from DDR.  Regions the DDR map flags live (MMU tables, trace
+ * ring, Ethernet buffers) are never tested.
+ */
+
+#ifndef MEMTEST_H
+#define MEMTEST_H
+
+#include <stdint.h>
+
+#define MEMTEST_DATA  0x1U /* walking ones on the data bus */
+#define MEMTEST_ADDR  0x2U /* each address line, stuck or shorted */
+#define MEMTEST_MARCH 0x4U /* March C- with all-0/all-1 backgrounds */
+#define MEMTEST_PRBS  0x8U /* xorshift64 fill, then verify */
+#define MEMTEST_ALL   0xFU
+
+/* memtest [tests [skip]]: run the tests in the tests mask (default all)
+ * over all of DDR or, if skip is nonzero, only where the DDR map holds no
+ * buffer or loaded image and defaults.h places no download area.  Prints
+ * each failing address with the bits that differ, and a summary of the
+ * failing bits. */
+void memtest_cmd(int argc, uint32_t tests, uint32_t skip, uint32_t arg3);
+
+#endif // MEMTEST_H
+
+// end file memtest.h
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file nand_pt.c
+ * @brief NAND partition table checks, for both table versions
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "nand_pt.h"
+#include "crc.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+static const char *read_v1(const nand_pt_v1_t *v1, nand_pt_t *pt)
+{
+   const uint8_t *b = (const uint8_t *)v1;
+   uint32_t sum     = 0;
+   for (uint32_t i = 0; i < offsetof(nand_pt_v1_t, checksum); i++)
+      sum += b[i];
+   if (sum != v1->checksum)
+      return "v1 checksum mismatch";
+
+   memset(pt, 0, sizeof(*pt));
+   pt->magic        = v1->magic;
+   pt->version      = NAND_PT_VERSION;
+   pt->total_blocks = v1->total_blocks;
+   pt->num_parts    = v1->num_parts;
+   for (uint32_t i = 0; i < NAND_PT_MAX_PARTS; i++) {
+      memcpy(pt->parts[i].name, v1->parts[i].name, sizeof(pt->parts[i].name));
+      pt->parts[i].start_block = v1->parts[i].start_block;
+      pt->parts[i].num_blocks  = v1->parts[i].num_blocks;
+   }
+   pt->crc32 = crc32(pt, offsetof(nand_pt_t, crc32));
+   return NULL;
+}
+
+const char *nand_pt_read(const void *raw, nand_pt_t *pt)
+{
+   const nand_pt_t *v2 = (const nand_pt_t *)raw;
+   if (v2->magic != NAND_PT_MAGIC)
+      return "bad magic";
+   if (v2->version == NAND_PT_V1)
+      return read_v1((const nand_pt_v1_t *)raw, pt);
+   if (v2->version != NAND_PT_VERSION)
+      return "unknown version";
+   if (crc32(v2, offsetof(nand_pt_t, crc32)) != v2->crc32)
+      return "crc32 mismatch";
+   memcpy(pt, v2, sizeof(*pt));
+   return NULL;
+}
+
+// end file nand_pt.c
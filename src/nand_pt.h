@@ -21,7 +21,8 @@
 #include <stdint.h>
 
 #define NAND_PT_MAGIC     0x4E414E44U /* "NAND" */
-#define NAND_PT_VERSION   1U
+#define NAND_PT_VERSION   2U
+#define NAND_PT_V1        1U /* read, and upgraded when next written */
 #define NAND_PT_MAX_PARTS 8U
 
 #define NAND_BLOCK_BOOT   0U /* bootloader (primary + redundant, 2 blocks) */
@@ -38,16 +39,40 @@ typedef struct {
    char name[16];
    uint32_t start_block;
    uint32_t num_blocks;
+   uint32_t size;  /* bytes of image in it, 0 if unknown */
+   uint32_t crc32; /* CRC-32 of those bytes */
 } nand_part_t;
 
-/* Total size: 4+4+4+4 + 8*24 + 4 = 212 bytes; fits in one NAND page. */
+/* Total size: 4+4+4+4 + 8*32 + 4 = 276 bytes; fits in one NAND page. */
 typedef struct {
    uint32_t magic;
    uint32_t version;
    uint32_t total_blocks; /* total used blocks; default n for fmc_flush */
    uint32_t num_parts;
    nand_part_t parts[NAND_PT_MAX_PARTS];
-   uint32_t checksum; /* sum of all preceding bytes, mod 2^32 */
+   uint32_t crc32; /* CRC-32 of all preceding bytes */
 } nand_pt_t;
 
+/* Version 1 entries had no image size or CRC, and the table ended in the
+ * byte sum of the preceding bytes instead of a CRC-32. */
+typedef struct {
+   char name[16];
+   uint32_t start_block;
+   uint32_t num_blocks;
+} nand_part_v1_t;
+
+typedef struct {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t total_blocks;
+   uint32_t num_parts;
+   nand_part_v1_t parts[NAND_PT_MAX_PARTS];
+   uint32_t checksum;
+} nand_pt_v1_t;
+
+/* Check the table at raw, of either version, and copy it to pt as version
+ * 2; a version 1 table comes out with every image size 0 (unknown).
+ * Returns NULL, or why raw is not a valid table. */
+const char *nand_pt_read(const void *raw, nand_pt_t *pt);
+
 #endif /* NAND_PT_H */
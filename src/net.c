@@ -0,0 +1,662 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file net.c
+ * @brief Polled ARP, IPv4, ICMP echo, UDP and DHCP client
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "net.h"
+#include <stdint.h>
+
+#ifdef ETHERNET
+#include "console.h"
+#include "eth.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+#include <string.h>
+
+#define ETHERTYPE_IP  0x0800U
+#define ETHERTYPE_ARP 0x0806U
+
+#define IP_PROTO_ICMP 1U
+#define IP_PROTO_UDP  17U
+#define IP_BROADCAST  0xFFFFFFFFU
+#define IP_DF         0x4000U
+#define IP_FRAG_MASK  0x3FFFU /* MF flag and fragment offset */
+#define IP_TTL        64U
+
+#define ARP_HDR      28U
+#define ARP_REQUEST  1U
+#define ARP_REPLY    2U
+#define ARP_ENTRIES  8U
+#define ARP_RETRY_MS 500U
+
+#define ICMP_ECHO_REPLY   0U
+#define ICMP_ECHO_REQUEST 8U
+#define ICMP_HDR          8U
+
+#define UDP_PORTS  4U
+#define POLL_BURST 32U /* frames per net_poll(), so a flood can't starve us */
+
+#define DHCP_SERVER_PORT 67U
+#define DHCP_CLIENT_PORT 68U
+#define DHCP_MAGIC       0x63825363U
+#define DHCP_FILE        108U /* offsets into the BOOTP message */
+#define DHCP_COOKIE      236U
+#define DHCP_OPTS        240U
+#define DHCP_MIN_LEN     300U
+#define DHCP_TRIES       4U
+#define DHCP_TIMEOUT_MS  2000U
+#define LINK_WAIT_MS     5000U /* auto-negotiation takes about 2 s */
+
+#define DHCP_DISCOVER 1U
+#define DHCP_OFFER    2U
+#define DHCP_REQUEST  3U
+#define DHCP_ACK      5U
+#define DHCP_NAK      6U
+
+#define OPT_PAD       0U
+#define OPT_MASK      1U
+#define OPT_ROUTER    3U
+#define OPT_REQ_IP    50U
+#define OPT_MSG_TYPE  53U
+#define OPT_SERVER_ID 54U
+#define OPT_PARAMS    55U
+#define OPT_BOOTFILE  67U
+#define OPT_END       255U
+
+struct arp_entry {
+   uint32_t ip;
+   uint8_t mac[6];
+};
+
+struct udp_port {
+   uint16_t port;
+   net_udp_fn fn;
+};
+
+static const uint8_t bcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static struct net_cfg cfg;
+static uint16_t ip_id;
+static struct arp_entry arp_cache[ARP_ENTRIES];
+static uint32_t arp_next;
+static struct udp_port udp_ports[UDP_PORTS];
+static uint16_t raw_type;
+static net_eth_fn raw_fn;
+static volatile int link_up; /* set from eth_poll() */
+
+/* DHCP exchange in progress. */
+static struct {
+   uint32_t xid;
+   uint8_t want; /* message type being waited for */
+   uint8_t got;  /* type received (want or NAK), 0 while waiting */
+   uint32_t yiaddr;
+   uint32_t siaddr;
+   uint32_t server_id;
+   uint32_t mask;
+   uint32_t router;
+   char file[NET_BOOTFILE_LEN];
+} dhcp;
+
+static uint16_t get16(const uint8_t *p)
+{
+   return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+   return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+          ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+   p[0] = (uint8_t)(v >> 8);
+   p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+   p[0] = (uint8_t)(v >> 24);
+   p[1] = (uint8_t)(v >> 16);
+   p[2] = (uint8_t)(v >> 8);
+   p[3] = (uint8_t)v;
+}
+
+static void print_ip(const char *label, uint32_t ip)
+{
+   my_printf("%s%lu.%lu.%lu.%lu\r\n", label, (unsigned long)(ip >> 24),
+             (unsigned long)((ip >> 16) & 0xFFU),
+             (unsigned long)((ip >> 8) & 0xFFU), (unsigned long)(ip & 0xFFU));
+}
+
+static int on_link(uint32_t ip)
+{
+   return ((ip ^ cfg.ip) & cfg.mask) == 0U;
+}
+
+static int is_broadcast(uint32_t ip)
+{
+   return ip == IP_BROADCAST ||
+          (cfg.mask != 0U && on_link(ip) && (ip | cfg.mask) == IP_BROADCAST);
+}
+
+/* ------------------------------------------------------------------------
+ * Ethernet and ARP
+ * ------------------------------------------------------------------------ */
+
+static void eth_header(uint8_t *f, const uint8_t *dst, uint16_t type)
+{
+   memcpy(&f[0], dst, 6U);
+   memcpy(&f[6], eth_mac_addr(), 6U);
+   put16(&f[12], type);
+}
+
+static const uint8_t *arp_lookup(uint32_t ip)
+{
+   for (uint32_t i = 0; i < ARP_ENTRIES; i++)
+      if (ip != 0U && arp_cache[i].ip == ip)
+         return arp_cache[i].mac;
+   return NULL;
+}
+
+static void arp_learn(uint32_t ip, const uint8_t *mac)
+{
+   if (ip == 0U)
+      return;
+   struct arp_entry *e = NULL;
+   for (uint32_t i = 0; i < ARP_ENTRIES && e == NULL; i++)
+      if (arp_cache[i].ip == ip)
+         e = &arp_cache[i];
+   if (e == NULL) {
+      e        = &arp_cache[arp_next];
+      arp_next = (arp_next + 1U) % ARP_ENTRIES;
+   }
+   e->ip = ip;
+   memcpy(e->mac, mac, 6U);
+}
+
+/* tha is only used for replies; requests are broadcast. */
+static void arp_send(uint16_t op, const uint8_t *tha, uint32_t tpa)
+{
+   uint8_t *f = eth_tx_alloc();
+   if (f == NULL)
+      return;
+
+   eth_header(f, (op == ARP_REQUEST) ? bcast_mac : tha, ETHERTYPE_ARP);
+   uint8_t *a = &f[NET_ETH_HDR];
+   put16(&a[0], 1U); /* Ethernet */
+   put16(&a[2], ETHERTYPE_IP);
+   a[4] = 6U;
+   a[5] = 4U;
+   put16(&a[6], op);
+   memcpy(&a[8], eth_mac_addr(), 6U);
+   put32(&a[14], cfg.ip);
+   if (op == ARP_REQUEST)
+      memset(&a[18], 0, 6U);
+   else
+      memcpy(&a[18], tha, 6U);
+   put32(&a[24], tpa);
+   (void)eth_tx(f, (uint16_t)(NET_ETH_HDR + ARP_HDR));
+}
+
+static void arp_input(const uint8_t *a, uint32_t len)
+{
+   if (len < ARP_HDR || get16(&a[0]) != 1U || get16(&a[2]) != ETHERTYPE_IP ||
+       a[4] != 6U || a[5] != 4U)
+      return;
+
+   const uint32_t spa = get32(&a[14]);
+   const uint32_t tpa = get32(&a[24]);
+   const int for_us   = (cfg.ip != 0U) && (tpa == cfg.ip);
+
+   /* Only hosts we talk to go into the cache, so broadcast chatter on a busy
+    * LAN does not push them out. */
+   if (for_us || arp_lookup(spa) != NULL)
+      arp_learn(spa, &a[8]);
+   if (for_us && get16(&a[6]) == ARP_REQUEST)
+      arp_send(ARP_REPLY, &a[8], spa);
+}
+
+static uint32_t next_hop(uint32_t ip)
+{
+   return (on_link(ip) || cfg.gw == 0U) ? ip : cfg.gw;
+}
+
+/* Destination MAC for ip, or NULL (after asking for it). */
+static const uint8_t *dst_mac(uint32_t ip)
+{
+   if (is_broadcast(ip))
+      return bcast_mac;
+   const uint32_t hop = next_hop(ip);
+   const uint8_t *mac = arp_lookup(hop);
+   if (mac == NULL)
+      arp_send(ARP_REQUEST, NULL, hop);
+   return mac;
+}
+
+/* ------------------------------------------------------------------------
+ * IPv4, ICMP, UDP
+ * ------------------------------------------------------------------------ */
+
+/* Complete frame f, whose IP payload of len bytes is in place, and queue it.
+ * The checksums are left zero for the MAC to insert. */
+static int ip_send(uint8_t *f, uint32_t len, uint8_t proto, uint32_t dst)
+{
+   const uint8_t *mac = dst_mac(dst);
+   if (mac == NULL) {
+      eth_tx_drop(f);
+      return -1;
+   }
+
+   eth_header(f, mac, ETHERTYPE_IP);
+   uint8_t *ip = &f[NET_ETH_HDR];
+   ip[0]       = 0x45U; /* IPv4, 20-byte header */
+   ip[1]       = 0U;
+   put16(&ip[2], (uint16_t)(NET_IP_HDR + len));
+   put16(&ip[4], ip_id++);
+   put16(&ip[6], IP_DF);
+   ip[8] = IP_TTL;
+   ip[9] = proto;
+   put16(&ip[10], 0U);
+   put32(&ip[12], cfg.ip);
+   put32(&ip[16], dst);
+   return eth_tx(f, (uint16_t)(NET_ETH_HDR + NET_IP_HDR + len));
+}
+
+static void icmp_input(const uint8_t *icmp, uint32_t len, uint32_t src)
+{
+   if (len < ICMP_HDR || len > NET_MTU - NET_IP_HDR ||
+       icmp[0] != ICMP_ECHO_REQUEST)
+      return;
+
+   uint8_t *f = eth_tx_alloc();
+   if (f == NULL)
+      return;
+   uint8_t *r = &f[NET_ETH_HDR + NET_IP_HDR];
+   memcpy(r, icmp, len);
+   r[0] = ICMP_ECHO_REPLY;
+   put16(&r[2], 0U);
+   (void)ip_send(f, len, IP_PROTO_ICMP, src);
+}
+
+static void udp_input(const uint8_t *u, uint32_t len, uint32_t src)
+{
+   if (len < NET_UDP_HDR)
+      return;
+   const uint32_t ulen = get16(&u[4]);
+   if (ulen < NET_UDP_HDR || ulen > len)
+      return;
+
+   const uint16_t dport = get16(&u[2]);
+   for (uint32_t i = 0; i < UDP_PORTS; i++) {
+      if (udp_ports[i].fn != NULL && udp_ports[i].port == dport) {
+         udp_ports[i].fn(&u[NET_UDP_HDR], ulen - NET_UDP_HDR, src,
+                         get16(&u[0]));
+         return;
+      }
+   }
+}
+
+static void ip_input(const uint8_t *f, uint32_t len)
+{
+   const uint8_t *ip = &f[NET_ETH_HDR];
+   len -= NET_ETH_HDR;
+   if (len < NET_IP_HDR || (ip[0] >> 4) != 4U)
+      return;
+
+   const uint32_t hlen = (ip[0] & 0x0FU) * 4U;
+   const uint32_t tot  = get16(&ip[2]);
+   if (hlen < NET_IP_HDR || tot < hlen || tot > len)
+      return;
+   if ((get16(&ip[6]) & IP_FRAG_MASK) != 0U)
+      return; /* no reassembly */
+
+   const uint32_t src = get32(&ip[12]);
+   const uint32_t dst = get32(&ip[16]);
+   /* Until configured, take everything: DHCP may answer by unicast. */
+   const int to_us = (cfg.ip != 0U) && (dst == cfg.ip);
+   if (cfg.ip != 0U && !to_us && !is_broadcast(dst))
+      return;
+   if (to_us && on_link(src))
+      arp_learn(src, &f[6]);
+
+   if (ip[9] == IP_PROTO_ICMP && to_us)
+      icmp_input(&ip[hlen], tot - hlen, src);
+   else if (ip[9] == IP_PROTO_UDP)
+      udp_input(&ip[hlen], tot - hlen, src);
+}
+
+void net_poll(void)
+{
+   eth_poll();
+   for (uint32_t n = 0; n < POLL_BURST; n++) {
+      uint16_t len     = 0U;
+      const uint8_t *f = eth_rx(&len);
+      if (f == NULL)
+         return;
+      if (len >= NET_ETH_HDR) {
+         const uint16_t type = get16(&f[12]);
+         if (type == ETHERTYPE_ARP)
+            arp_input(&f[NET_ETH_HDR], len - NET_ETH_HDR);
+         else if (type == ETHERTYPE_IP)
+            ip_input(f, len);
+         else if (type == raw_type && raw_fn != NULL)
+            raw_fn(f, len);
+      }
+      eth_rx_done(f);
+   }
+}
+
+/* Link events from eth_poll().  The ARP cache goes with a link that went
+ * down, since the cable may come back on another network. */
+static void link_changed(int up)
+{
+   link_up = up;
+   if (!up)
+      memset(arp_cache, 0, sizeof(arp_cache));
+}
+
+void net_init(void)
+{
+   eth_on_link(link_changed);
+}
+
+const struct net_cfg *net_config(void)
+{
+   return &cfg;
+}
+
+int net_udp_listen(uint16_t port, net_udp_fn fn)
+{
+   struct udp_port *free_slot = NULL;
+   for (uint32_t i = 0; i < UDP_PORTS; i++) {
+      if (udp_ports[i].fn == NULL)
+         free_slot = &udp_ports[i];
+      else if (udp_ports[i].port == port)
+         return -1;
+   }
+   if (free_slot == NULL)
+      return -1;
+   free_slot->port = port;
+   free_slot->fn   = fn;
+   return 0;
+}
+
+void net_udp_close(uint16_t port)
+{
+   for (uint32_t i = 0; i < UDP_PORTS; i++)
+      if (udp_ports[i].port == port)
+         udp_ports[i].fn = NULL;
+}
+
+void net_eth_listen(uint16_t type, net_eth_fn fn)
+{
+   raw_type = type;
+   raw_fn   = fn;
+}
+
+uint8_t *net_udp_alloc(void)
+{
+   uint8_t *f = eth_tx_alloc();
+   return (f != NULL) ? &f[NET_UDP_DATA] : NULL;
+}
+
+void net_udp_drop(uint8_t *data)
+{
+   eth_tx_drop(data - NET_UDP_DATA);
+}
+
+int net_udp_send(uint8_t *data, uint32_t len, uint32_t dst_ip,
+                 uint16_t src_port, uint16_t dst_port)
+{
+   uint8_t *f = data - NET_UDP_DATA;
+   if (len > NET_UDP_MAX) {
+      eth_tx_drop(f);
+      return -1;
+   }
+
+   uint8_t *u = &f[NET_ETH_HDR + NET_IP_HDR];
+   put16(&u[0], src_port);
+   put16(&u[2], dst_port);
+   put16(&u[4], (uint16_t)(NET_UDP_HDR + len));
+   put16(&u[6], 0U);
+   return ip_send(f, NET_UDP_HDR + len, IP_PROTO_UDP, dst_ip);
+}
+
+int net_arp_resolve(uint32_t ip, uint32_t timeout_ms)
+{
+   if (is_broadcast(ip))
+      return 0;
+
+   const uint32_t hop = next_hop(ip);
+   const uint32_t t0  = HAL_GetTick();
+   uint32_t t_req     = t0 - ARP_RETRY_MS;
+   while (arp_lookup(hop) == NULL) {
+      const uint32_t now = HAL_GetTick();
+      if (now - t0 >= timeout_ms || console_interrupted())
+         return -1;
+      if (now - t_req >= ARP_RETRY_MS) {
+         arp_send(ARP_REQUEST, NULL, hop);
+         t_req = now;
+      }
+      net_poll();
+   }
+   return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * DHCP client
+ * ------------------------------------------------------------------------ */
+
+static void dhcp_input(const uint8_t *d, uint32_t len, uint32_t src_ip,
+                       uint16_t src_port)
+{
+   (void)src_ip;
+   if (src_port != DHCP_SERVER_PORT || len < DHCP_OPTS || d[0] != 2U ||
+       get32(&d[4]) != dhcp.xid || memcmp(&d[28], eth_mac_addr(), 6U) != 0 ||
+       get32(&d[DHCP_COOKIE]) != DHCP_MAGIC)
+      return;
+
+   uint8_t type     = 0U;
+   uint32_t srv     = 0U;
+   uint32_t mask    = 0U;
+   uint32_t router  = 0U;
+   const uint8_t *o = &d[DHCP_OPTS];
+   const char *file = NULL;
+   uint32_t file_n  = 0U;
+   while (o < &d[len] && *o != OPT_END) {
+      if (*o == OPT_PAD) {
+         o++;
+         continue;
+      }
+      if (o + 2 > &d[len] || o + 2 + o[1] > &d[len])
+         return;
+      const uint8_t n  = o[1];
+      const uint8_t *v = &o[2];
+      if (o[0] == OPT_MSG_TYPE && n >= 1U)
+         type = v[0];
+      else if (o[0] == OPT_SERVER_ID && n >= 4U)
+         srv = get32(v);
+      else if (o[0] == OPT_MASK && n >= 4U)
+         mask = get32(v);
+      else if (o[0] == OPT_ROUTER && n >= 4U)
+         router = get32(v);
+      else if (o[0] == OPT_BOOTFILE) {
+         file   = (const char *)v;
+         file_n = n;
+      }
+      o += 2U + n;
+   }
+   if (type != dhcp.want && type != DHCP_NAK)
+      return;
+
+   if (file == NULL) {
+      file = (const char *)&d[DHCP_FILE];
+      while (file_n < 128U && file[file_n] != '\0')
+         file_n++;
+   }
+   if (file_n >= NET_BOOTFILE_LEN)
+      file_n = NET_BOOTFILE_LEN - 1U;
+   memcpy(dhcp.file, file, file_n);
+   dhcp.file[file_n] = '\0';
+
+   dhcp.yiaddr    = get32(&d[16]);
+   dhcp.siaddr    = get32(&d[20]);
+   dhcp.server_id = srv;
+   dhcp.mask      = mask;
+   dhcp.router    = router;
+   dhcp.got       = type;
+}
+
+static int dhcp_send(uint8_t type)
+{
+   uint8_t *d = net_udp_alloc();
+   if (d == NULL)
+      return -1;
+
+   memset(d, 0, DHCP_MIN_LEN);
+   d[0] = 1U; /* BOOTREQUEST */
+   d[1] = 1U; /* Ethernet */
+   d[2] = 6U;
+   put32(&d[4], dhcp.xid);
+   put16(&d[10], 0x8000U); /* broadcast replies: we have no address yet */
+   memcpy(&d[28], eth_mac_addr(), 6U);
+   put32(&d[DHCP_COOKIE], DHCP_MAGIC);
+
+   uint8_t *o = &d[DHCP_OPTS];
+   *o++       = OPT_MSG_TYPE;
+   *o++       = 1U;
+   *o++       = type;
+   if (type == DHCP_REQUEST) {
+      *o++ = OPT_REQ_IP;
+      *o++ = 4U;
+      put32(o, dhcp.yiaddr);
+      o += 4;
+      *o++ = OPT_SERVER_ID;
+      *o++ = 4U;
+      put32(o, dhcp.server_id);
+      o += 4;
+   }
+   *o++ = OPT_PARAMS;
+   *o++ = 3U;
+   *o++ = OPT_MASK;
+   *o++ = OPT_ROUTER;
+   *o++ = OPT_BOOTFILE;
+   *o++ = OPT_END;
+
+   const uint32_t len = (uint32_t)(o - d);
+   return net_udp_send(d, (len < DHCP_MIN_LEN) ? DHCP_MIN_LEN : len,
+                       IP_BROADCAST, DHCP_CLIENT_PORT, DHCP_SERVER_PORT);
+}
+
+/* Send type until the answer want (or a NAK) arrives, backing off. */
+static int dhcp_exchange(uint8_t type, uint8_t want)
+{
+   for (uint32_t t = 0; t < DHCP_TRIES; t++) {
+      dhcp.want = want;
+      dhcp.got  = 0U;
+      (void)dhcp_send(type);
+
+      const uint32_t t0 = HAL_GetTick();
+      while (HAL_GetTick() - t0 < (DHCP_TIMEOUT_MS << t)) {
+         net_poll();
+         if (dhcp.got != 0U)
+            return (dhcp.got == want) ? 0 : -1;
+         if (console_interrupted())
+            return -1;
+      }
+   }
+   return -1;
+}
+
+/* Poll until link_changed() reports the link up. */
+static int wait_link(void)
+{
+   const uint32_t t0 = HAL_GetTick();
+   while (!link_up) {
+      if (HAL_GetTick() - t0 >= LINK_WAIT_MS || console_interrupted())
+         return -1;
+      net_poll();
+   }
+   return 0;
+}
+
+int net_dhcp(void)
+{
+   const uint8_t *mac = eth_mac_addr();
+   if (wait_link() != 0) {
+      my_printf("No Ethernet link\r\n");
+      return -1;
+   }
+   memset(&cfg, 0, sizeof(cfg));
+   dhcp.xid = HAL_GetTick() ^ get32(&mac[2]);
+
+   if (net_udp_listen(DHCP_CLIENT_PORT, dhcp_input) != 0)
+      return -1;
+   int err = dhcp_exchange(DHCP_DISCOVER, DHCP_OFFER);
+   if (err == 0)
+      err = dhcp_exchange(DHCP_REQUEST, DHCP_ACK);
+   net_udp_close(DHCP_CLIENT_PORT);
+   if (err != 0)
+      return -1;
+
+   cfg.ip     = dhcp.yiaddr;
+   cfg.mask   = (dhcp.mask != 0U) ? dhcp.mask : 0xFFFFFF00U;
+   cfg.gw     = dhcp.router;
+   cfg.server = (dhcp.siaddr != 0U) ? dhcp.siaddr : dhcp.server_id;
+   memcpy(cfg.bootfile, dhcp.file, sizeof(cfg.bootfile));
+   return 0;
+}
+
+static void print_cfg(void)
+{
+   print_ip("ip      ", cfg.ip);
+   print_ip("mask    ", cfg.mask);
+   print_ip("gateway ", cfg.gw);
+   print_ip("server  ", cfg.server);
+   if (cfg.bootfile[0] != '\0')
+      my_printf("bootfile %s\r\n", cfg.bootfile);
+}
+
+void net_ip_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   if (argc >= 1) {
+      cfg.ip   = arg1;
+      cfg.mask = (argc >= 2) ? arg2 : 0xFFFFFF00U;
+      cfg.gw   = (argc >= 3) ? arg3 : 0U;
+   }
+   print_cfg();
+}
+
+void net_dhcp_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   (void)argc;
+   (void)arg1;
+   (void)arg2;
+   (void)arg3;
+
+   my_printf("DHCP ...\r\n");
+   if (net_dhcp() != 0) {
+      my_printf("DHCP failed\r\n");
+      return;
+   }
+   print_cfg();
+}
+
+#else // ETHERNET
+
+void net_init(void)
+{
+}
+
+void net_poll(void)
+{
+}
+
+#endif // ETHERNET
+
+// end file net.c
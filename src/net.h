@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file net.h
+ * @brief Polled ARP, IPv4, ICMP echo, UDP and DHCP client
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Runs from the main loop on top of the eth.c frame rings.  Received UDP
+ * payloads are passed to their port handler in place, in the DMA buffer;
+ * outgoing ones are written straight into a TX frame by the caller, and the
+ * headers filled in around them.  IPv4 addresses are host-order integers,
+ * 0xC0A80001 for 192.168.0.1.
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include <stdint.h>
+
+#define NET_ETH_HDR  14U
+#define NET_IP_HDR   20U
+#define NET_UDP_HDR  8U
+#define NET_UDP_DATA (NET_ETH_HDR + NET_IP_HDR + NET_UDP_HDR)
+#define NET_MTU      1500U
+#define NET_UDP_MAX  (NET_MTU - NET_IP_HDR - NET_UDP_HDR)
+
+#define NET_BOOTFILE_LEN 128U
+
+struct net_cfg {
+   uint32_t ip;
+   uint32_t mask;
+   uint32_t gw;
+   uint32_t server; /* boot server (DHCP siaddr or server identifier) */
+   char bootfile[NET_BOOTFILE_LEN];
+};
+
+/* Payload handler; data is only valid during the call. */
+typedef void (*net_udp_fn)(const uint8_t *data, uint32_t len, uint32_t src_ip,
+                           uint16_t src_port);
+
+/* Raw frame handler for a protocol below IP; frame is only valid during the
+ * call. */
+typedef void (*net_eth_fn)(const uint8_t *frame, uint32_t len);
+
+/* Follow the Ethernet link; call once, after eth_init(). */
+void net_init(void);
+
+/* Process received frames. */
+void net_poll(void);
+
+const struct net_cfg *net_config(void);
+
+/* Configure the interface with DHCP.  Returns 0 on success. */
+int net_dhcp(void);
+
+/* Deliver datagrams for a local port to fn.  Returns 0 on success, -1 if the
+ * port is taken or the table is full. */
+int net_udp_listen(uint16_t port, net_udp_fn fn);
+void net_udp_close(uint16_t port);
+
+/* Deliver whole frames of one EtherType to fn; fn NULL stops.  One such
+ * protocol at a time. */
+void net_eth_listen(uint16_t type, net_eth_fn fn);
+
+/* Payload area (NET_UDP_MAX bytes) of a free TX frame, or NULL.  It is
+ * consumed by net_udp_send(), or given back unsent with net_udp_drop(). */
+uint8_t *net_udp_alloc(void);
+void net_udp_drop(uint8_t *data);
+
+/* Send len bytes written at data (from net_udp_alloc()).  Fails if dst_ip
+ * is not in the ARP cache yet, after asking for it. */
+int net_udp_send(uint8_t *data, uint32_t len, uint32_t dst_ip,
+                 uint16_t src_port, uint16_t dst_port);
+
+/* Wait until the next hop to ip is in the ARP cache.  Returns 0 on success,
+ * -1 on timeout or Ctrl-C. */
+int net_arp_resolve(uint32_t ip, uint32_t timeout_ms);
+
+void net_ip_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+void net_dhcp_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#endif // NET_H
+
+// end file net.h
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file netcon.c
+ * @brief Console over UDP
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "netcon.h"
+#include <stdint.h>
+
+#ifdef ETHERNET
+
+#include "console.h"
+#include "net.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+
+#define NC_PORT    6666U
+#define NC_RING    8192U /* power of two */
+#define NC_HOLD_MS 2U    /* let output gather this long between datagrams */
+#define NC_ARP_MS  2000U
+
+static printf_output_fn_t prev_output;
+static int on;
+static uint32_t host;
+static uint16_t host_port;
+
+/* Output not yet sent: my_printf appends at head, datagrams take it from
+ * tail.  Both only ever grow; the ring index is the low bits. */
+static uint8_t ring[NC_RING];
+static uint32_t head;
+static uint32_t tail;
+static uint32_t dropped;
+static uint32_t t_sent;
+static int sending;
+
+/* Send what is waiting, in datagrams as large as will fit, for as long as
+ * there are TX buffers.  Whatever does not go out now (no TX buffer, host
+ * MAC not known yet) stays in the ring for the next try. */
+static void nc_send(void)
+{
+   if (sending)
+      return;
+   sending = 1;
+   while (head != tail) {
+      uint8_t *d = net_udp_alloc();
+      if (d == NULL)
+         break;
+      uint32_t n = head - tail;
+      if (n > NET_UDP_MAX)
+         n = NET_UDP_MAX;
+      for (uint32_t i = 0; i < n; i++)
+         d[i] = ring[(tail + i) & (NC_RING - 1U)];
+      if (net_udp_send(d, n, host, NC_PORT, host_port) != 0)
+         break;
+      tail += n;
+   }
+   t_sent  = HAL_GetTick();
+   sending = 0;
+}
+
+static void nc_putc(char c)
+{
+   uart_mirror_char(c);
+
+   if (head - tail >= NC_RING) {
+      dropped++;
+      return;
+   }
+   ring[head & (NC_RING - 1U)] = (uint8_t)c;
+   head++;
+
+   /* Full datagram, or a line end with the link idle for a while; anything
+    * else waits for more output or for netcon_poll(). */
+   if (head - tail >= NET_UDP_MAX ||
+       (c == '\n' && HAL_GetTick() - t_sent >= NC_HOLD_MS))
+      nc_send();
+}
+
+static void nc_input(const uint8_t *data, uint32_t len, uint32_t src_ip,
+                     uint16_t src_port)
+{
+   (void)src_port;
+   if (src_ip != host)
+      return;
+   for (uint32_t i = 0; i < len; i++)
+      console_push((char)data[i]);
+}
+
+static void nc_stop(void)
+{
+   if (!on)
+      return;
+   nc_send();
+   net_udp_close(NC_PORT);
+   if (printf_get_output() == nc_putc)
+      printf_set_output(prev_output);
+   on = 0;
+   if (dropped != 0U)
+      my_printf("netcon: %lu bytes dropped on a full ring\r\n",
+                (unsigned long)dropped);
+}
+
+void netcon_poll(void)
+{
+   if (on && head != tail && HAL_GetTick() - t_sent >= NC_HOLD_MS)
+      nc_send();
+}
+
+void netcon_cmd(int argc, uint32_t ip, uint32_t port, uint32_t arg3)
+{
+   (void)arg3;
+   if (argc >= 1 && ip == 0U) {
+      nc_stop();
+      my_printf("Console on the UART\r\n");
+      return;
+   }
+
+   const struct net_cfg *cfg = net_config();
+   if (cfg->ip == 0U) {
+      my_printf("Running DHCP ...\r\n");
+      if (net_dhcp() != 0) {
+         my_printf("DHCP failed\r\n");
+         return;
+      }
+   }
+   if (argc < 1)
+      ip = cfg->server;
+   if (argc < 2)
+      port = NC_PORT;
+   if (ip == 0U || port == 0U || port > 0xFFFFU) {
+      my_printf("Bad host or port\r\n");
+      return;
+   }
+   if (net_arp_resolve(ip, NC_ARP_MS) != 0) {
+      my_printf("Host not reachable\r\n");
+      return;
+   }
+
+   nc_stop();
+   if (net_udp_listen(NC_PORT, nc_input) != 0) {
+      my_printf("UDP port %u busy\r\n", NC_PORT);
+      return;
+   }
+   host      = ip;
+   host_port = (uint16_t)port;
+   head      = 0U;
+   tail      = 0U;
+   dropped   = 0U;
+   my_printf("Console to %lu.%lu.%lu.%lu:%lu\r\n", (unsigned long)(ip >> 24),
+             (unsigned long)((ip >> 16) & 0xFFU),
+             (unsigned long)((ip >> 8) & 0xFFU), (unsigned long)(ip & 0xFFU),
+             (unsigned long)port);
+
+   prev_output = printf_get_output();
+   printf_set_output(nc_putc);
+   on = 1;
+}
+
+#else // ETHERNET
+
+void netcon_poll(void)
+{
+}
+
+#endif // ETHERNET
+
+// end file netcon.c
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file netcon.h
+ * @brief Console over UDP
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * While on, my_printf output is gathered in a ring and sent to one host as
+ * UDP datagrams from and to port 6666, the way Linux netconsole does, and
+ * UART4 becomes a best-effort mirror; printing never waits for either.
+ * Datagrams from that host to port 6666 are fed to console_push() like UART
+ * input, so a rack of boards can be driven and logged from one machine
+ * (scripts/netcon.py).
+ */
+
+#ifndef NETCON_H
+#define NETCON_H
+
+#include <stdint.h>
+
+/* netcon [ip [port]]: send the console to ip (default the DHCP boot
+ * server), port default 6666; ip 0 gives it back to the UART. */
+void netcon_cmd(int argc, uint32_t ip, uint32_t port, uint32_t arg3);
+
+/* Send output still waiting for a line end or for more to join it. */
+void netcon_poll(void);
+
+#endif // NETCON_H
+
+// end file netcon.h
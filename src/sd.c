@@ -23,9 +23,13 @@ SD_HandleTypeDef sd_handle;
 
 #include "cmsis_gcc.h"
 #include "core_ca.h"
+#include "ddr_map.h"
 #include "debug.h"
 #include "defaults.h"
+#include "dtb.h"
+#include "hash.h"
 #include "irq_ctrl.h"
+#include "manifest.h"
 #include "printf.h"
 #include "stm32mp135fxx_ca7.h"
 #include "stm32mp13xx_hal_def.h"
@@ -34,13 +38,19 @@ SD_HandleTypeDef sd_handle;
 #include "stm32mp13xx_hal_rcc.h"
 #include "stm32mp13xx_hal_sd.h"
 #include "stm32mp13xx_ll_sdmmc.h"
+#include "warm.h"
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define BLOCK_SIZE 512U
 #define DDR_SIZE   0x20000000U // 512 MB
 
+/* Verified loads read this many sectors at a time, hashing each chunk by
+ * DMA while the next one is read. */
+#define SD_CHUNK_BLOCKS 256U // 128 KiB
+
 struct mbr_partition {
    uint8_t boot_flag;
    uint8_t type;
@@ -177,6 +187,18 @@ int sd_write_blocks(uint32_t lba, const uint8_t *buf, uint32_t num_blocks)
    return 0;
 }
 
+int sd_erase_blocks(uint32_t lba, uint32_t num_blocks)
+{
+   if (num_blocks == 0U)
+      return 0;
+
+   if (HAL_SD_Erase(&sd_handle, lba, lba + num_blocks - 1U) != HAL_OK)
+      return -1;
+   while (HAL_SD_GetCardState(&sd_handle) != HAL_SD_CARD_TRANSFER)
+      ;
+   return 0;
+}
+
 uint32_t sd_block_count(void)
 {
    HAL_SD_CardInfoTypeDef info;
@@ -197,8 +219,11 @@ static void parse_mbr_entry(uint8_t *buffer, struct mbr_partition *p)
 
 static int get_mbr_table(struct mbr_partition *table)
 {
-   uint8_t *sector = (uint8_t *)DRAM_MEM_BASE;
-   sd_read(0, 1, DRAM_MEM_BASE);
+   static uint8_t sector[BLOCK_SIZE];
+   if (sd_read_blocks(0U, sector, 1U) != 0) {
+      my_printf("MBR read error\r\n");
+      return 0;
+   }
 
    if (sector[510] != 0x55 || sector[511] != 0xAA) {
       my_printf("No valid MBR signature!\r\n");
@@ -211,6 +236,16 @@ static int get_mbr_table(struct mbr_partition *table)
    return 1;
 }
 
+int sd_mbr_partition(int idx, uint32_t *lba, uint32_t *num_blocks)
+{
+   struct mbr_partition table[4];
+   if (idx < 0 || idx >= 4 || !get_mbr_table(table) || table[idx].type == 0)
+      return -1;
+   *lba        = table[idx].lba_start;
+   *num_blocks = table[idx].num_sectors;
+   return 0;
+}
+
 void sd_print_mbr(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
 {
    (void)argc;
@@ -230,25 +265,128 @@ void sd_print_mbr(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
    }
 }
 
-void sd_load_mbr(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+/* Read into DDR by IDMA, calling poll (if set) while the card streams.
+ * The handler is run here as well, so this works with IRQs masked. */
+static int read_dma(uint32_t lba, uint8_t *buf, uint32_t num_blocks,
+                    int (*poll)(void))
 {
-   (void)argc;
-   (void)arg1;
-   (void)arg2;
-   (void)arg3;
+   L1C_CleanInvalidateDCacheAll();
+   if (HAL_SD_ReadBlocks_DMA(&sd_handle, buf, lba, num_blocks) != HAL_OK)
+      return -1;
+   while (sd_handle.State != HAL_SD_STATE_READY) {
+      const uint32_t cpsr = irq_save();
+      HAL_SD_IRQHandler(&sd_handle);
+      irq_restore(cpsr);
+      if (poll != NULL)
+         (void)poll(); /* a stop is acted on between chunks */
+   }
+   while (HAL_SD_GetCardState(&sd_handle) != HAL_SD_CARD_TRANSFER)
+      ;
+   L1C_CleanInvalidateDCacheAll();
+   return (sd_handle.ErrorCode == HAL_SD_ERROR_NONE) ? 0 : -1;
+}
+
+/* Load a partition to dest: the bytes the manifest entry e covers, hashing
+ * each chunk as soon as it is in DDR, or the whole partition if e is NULL.
+ * Between chunks, stops if poll (if set) returns nonzero. */
+static int load_part(const char *label, const struct mbr_partition *p,
+                     uint32_t dest, const manifest_entry_t *e,
+                     int (*poll)(void))
+{
+   const uint32_t size = e ? e->size : p->num_sectors * BLOCK_SIZE;
+   const uint32_t n    = (size + BLOCK_SIZE - 1U) / BLOCK_SIZE;
+   if (n > p->num_sectors || size > DRAM_MEM_BASE + DDR_SIZE - dest) {
+      my_printf("%s: image size %lu does not fit\r\n", label,
+                (unsigned long)size);
+      return -1;
+   }
+
+   uint8_t *dst  = (uint8_t *)dest;
+   uint32_t left = size;
+   if (e)
+      hash_start();
+   for (uint32_t done = 0; done < n;) {
+      if (poll != NULL && poll() != 0) {
+         my_printf("%s: load stopped\r\n", label);
+         return -1;
+      }
+      const uint32_t k   = (n - done < SD_CHUNK_BLOCKS) ? n - done
+                                                        : SD_CHUNK_BLOCKS;
+      uint8_t *chunk     = dst + (done * BLOCK_SIZE);
+      const uint32_t len = (left < k * BLOCK_SIZE) ? left : k * BLOCK_SIZE;
+      if (read_dma(p->lba_start + done, chunk, k, poll) != 0) {
+         my_printf("%s: SD read error at LBA %lu\r\n", label,
+                   (unsigned long)(p->lba_start + done));
+         return -1;
+      }
+      if (e && hash_feed(chunk, len) != 0) {
+         my_printf("%s: HASH DMA error\r\n", label);
+         return -1;
+      }
+      left -= len;
+      done += k;
+   }
+   if (!e)
+      return 0;
+
+   uint8_t digest[HASH_SHA256_LEN];
+   if (hash_finish(digest) != 0) {
+      my_printf("%s: HASH peripheral timeout\r\n", label);
+      return -1;
+   }
+   return hash_verify(label, digest, e);
+}
 
+int sd_load_images(int (*poll)(void))
+{
    struct mbr_partition table[4];
 
    if (!get_mbr_table(table)) {
       my_printf("No MBR found: nothing to copy.");
-      return;
+      return -1;
    }
 
-   if (table[0].type != 0)
-      sd_read(table[0].lba_start, table[0].num_sectors, DEF_LINUX_ADDR);
+   /* The manifest sector sits between the MBR and the first image. */
+   static uint32_t sector[BLOCK_SIZE / 4U];
+   const manifest_t *m = (const manifest_t *)sector;
+   if (sd_read_blocks(MANIFEST_SD_LBA, (uint8_t *)sector, 1U) != 0)
+      sector[0] = 0U;
+   const int have = manifest_valid(m);
+   if (have < 0)
+      return -1;
+   if (have == 0)
+      my_printf("sd: no image manifest, loading unverified\r\n");
+
+   static const char *const label[2] = {"kernel", "dtb"};
+   static const uint32_t dest[2]     = {DEF_LINUX_ADDR, DEF_DTB_ADDR};
+   for (uint32_t i = 0; i < 2U; i++) {
+      if (table[i].type == 0)
+         continue;
+      const manifest_entry_t *e = have ? manifest_find(m, label[i]) : NULL;
+      const uint32_t len = e ? e->size : table[i].num_sectors * BLOCK_SIZE;
+      if (ddr_map_reserve(label[i], dest[i], len, 0U) != 0)
+         return -1;
+      /* The DTB is patched before each boot, so only the kernel can be
+       * reused after a warm reset. */
+      if (e && i == 0U && warm_check(dest[i], e))
+         continue;
+      if (load_part(label[i], &table[i], dest[i], e, poll) != 0)
+         return -1;
+      if (e && i == 0U)
+         warm_note(dest[i], e);
+      if (i == 1U)
+         (void)dtb_claim(); /* down to the DTB's own size */
+   }
+   return 0;
+}
 
-   if (table[1].type != 0)
-      sd_read(table[1].lba_start, table[1].num_sectors, DEF_DTB_ADDR);
+void sd_load_mbr(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   (void)argc;
+   (void)arg1;
+   (void)arg2;
+   (void)arg3;
+   (void)sd_load_images(NULL);
 }
 
 void load_sd_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
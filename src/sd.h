@@ -20,8 +20,16 @@ void load_sd_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 void sd_read(uint32_t lba, uint32_t num_blocks, uint32_t dest_addr);
 int sd_read_blocks(uint32_t lba, uint8_t *buf, uint32_t num_blocks);
 int sd_write_blocks(uint32_t lba, const uint8_t *buf, uint32_t num_blocks);
+int sd_erase_blocks(uint32_t lba, uint32_t num_blocks);
 uint32_t sd_block_count(void);
+/* Start and length of MBR entry idx (0..3); returns -1 if unused. */
+int sd_mbr_partition(int idx, uint32_t *lba, uint32_t *num_blocks);
 void sd_print_mbr(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+/* Load MBR partition 1 to the kernel and 2 to the DTB address, checking
+ * each against the image manifest if the card has one.  The card is read
+ * by IDMA; poll, if not NULL, is called while it runs, and the load stops
+ * once it returns nonzero.  Returns 0 if the images are fit to boot. */
+int sd_load_images(int (*poll)(void));
 void sd_load_mbr(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 #endif
 
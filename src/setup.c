@@ -29,6 +29,10 @@
 #include "usb_msc.h"
 #include <stdint.h>
 
+/* UART4 runs from the 64 MHz HSI with 8x oversampling. */
+#define UART_MIN_BAUD 1200U
+#define UART_MAX_BAUD 8000000U
+
 // global variables
 UART_HandleTypeDef huart4;
 
@@ -37,12 +41,18 @@ void UART4_IRQHandler(void)
    uint32_t isr = huart4.Instance->ISR;
    uint32_t cr1 = huart4.Instance->CR1;
 
-   // take character out, if any
-   if ((isr & (USART_ISR_RXNE_RXFNE)) && (cr1 & USART_CR1_RXNEIE)) {
-      char byte = (char)(huart4.Instance->RDR & 0xFFU);
-      console_push(byte);
+   // take characters out of the RX FIFO, if any
+   if (cr1 & USART_CR1_RXNEIE) {
+      while (huart4.Instance->ISR & USART_ISR_RXNE_RXFNE) {
+         char byte = (char)(huart4.Instance->RDR & 0xFFU);
+         console_push(byte);
+      }
    }
 
+   // send the next queued character, if any
+   if ((isr & USART_ISR_TXE) && (cr1 & USART_CR1_TXEIE))
+      uart_tx_irq();
+
    // clear other interrupt flags
    uint32_t error_mask =
        (USART_ISR_ORE | USART_ISR_NE | USART_ISR_FE | USART_ISR_PE);
@@ -57,20 +67,43 @@ void UART4_IRQHandler(void)
    }
 }
 
-static void uart_write_char(char ch)
+void uart_baud_cmd(int argc, uint32_t rate, uint32_t policy, uint32_t arg3)
 {
-   /* Wait until TXE (Transmit Data Register Empty) flag is set */
-   while (!(UART4->ISR & USART_ISR_TXE)) {
-      /* busy wait */
-   }
+   (void)arg3;
+   static const char *const policy_name[] = {"block", "drop", "overwrite"};
 
-   /* Write character to Transmit Data Register */
-   UART4->TDR = (uint8_t)ch;
+   if (argc >= 2) {
+      if (policy > (uint32_t)UART_TX_OVERWRITE) {
+         my_printf("Policy must be 0 (block), 1 (drop) or 2 (overwrite)\r\n");
+         return;
+      }
+      uart_set_tx_policy((enum uart_tx_policy)policy);
+   }
 
-   /* Wait until transmission complete */
-   while (!(UART4->ISR & USART_ISR_TC)) {
-      /* busy wait */
+   if (argc >= 1 && rate != huart4.Init.BaudRate) {
+      if (rate < UART_MIN_BAUD || rate > UART_MAX_BAUD) {
+         my_printf("Baud rate must be %u to %u\r\n", UART_MIN_BAUD,
+                   UART_MAX_BAUD);
+         return;
+      }
+      my_printf("Switching to %lu baud\r\n", (unsigned long)rate);
+      uart_flush();
+
+      const uint32_t old_rate = huart4.Init.BaudRate;
+      CLEAR_BIT(UART4->CR1, USART_CR1_UE);
+      huart4.Init.BaudRate = rate;
+      if (UART_SetConfig(&huart4) != HAL_OK) {
+         huart4.Init.BaudRate = old_rate;
+         (void)UART_SetConfig(&huart4);
+      }
+      /* UART_SetConfig() clears FIFOEN along with the frame format. */
+      SET_BIT(UART4->CR1, USART_CR1_FIFOEN | USART_CR1_UE);
    }
+
+   my_printf("%lu baud, %s on a full TX ring, %lu characters dropped\r\n",
+             (unsigned long)huart4.Init.BaudRate,
+             policy_name[uart_get_tx_policy()],
+             (unsigned long)uart_tx_dropped());
 }
 
 void sysclk_init(void)
@@ -379,8 +412,9 @@ void uart4_init(void)
    if (HAL_UARTEx_SetRxFifoThreshold(&huart4, UART_RXFIFO_THRESHOLD_1_8) !=
        HAL_OK)
       ERROR("FIFO RX Threshold");
-   if (HAL_UARTEx_DisableFifoMode(&huart4) != HAL_OK)
-      ERROR("Disable FIFO");
+   /* The 8-byte FIFOs ride out interrupt latency at multi-Mbaud rates. */
+   if (HAL_UARTEx_EnableFifoMode(&huart4) != HAL_OK)
+      ERROR("Enable FIFO");
 
    __HAL_UART_ENABLE_IT(&huart4, UART_IT_RXNE);
 
@@ -417,6 +451,32 @@ void mmu_init(void)
    L1C_EnableBTAC();
 }
 
+uint32_t dcache_on(void)
+{
+   const uint32_t cpsr  = irq_save();
+   const uint32_t sctlr = __get_SCTLR();
+   if ((sctlr & SCTLR_M_Msk) != 0U && (sctlr & SCTLR_C_Msk) == 0U) {
+      L1C_InvalidateDCacheAll();
+      __set_SCTLR(sctlr | SCTLR_C_Msk);
+      __ISB();
+   }
+   irq_restore(cpsr);
+   return sctlr;
+}
+
+/* The same steps as ddr_qos.c apply() when it turns the cache off. */
+void dcache_restore(uint32_t sctlr)
+{
+   const uint32_t cpsr = irq_save();
+   if ((sctlr & SCTLR_C_Msk) == 0U && (__get_SCTLR() & SCTLR_C_Msk) != 0U) {
+      L1C_CleanInvalidateDCacheAll();
+      __set_SCTLR(sctlr);
+      __ISB();
+      L1C_CleanInvalidateDCacheAll(); /* what the last few stores dirtied */
+   }
+   irq_restore(cpsr);
+}
+
 void lse_init(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
 {
    (void)argc;
@@ -24,10 +24,20 @@ void gpio_init(void);
 void uart4_init(void);
 void gic_init(void);
 void mmu_init(void);
+
+/* Turn the data cache on for a measurement, if the MMU is on, and return
+ * the SCTLR to hand back to dcache_restore() afterwards.  The drivers keep
+ * their DMA buffers coherent either way. */
+uint32_t dcache_on(void);
+void dcache_restore(uint32_t sctlr);
 void usb_init(void);
 
 void lse_init(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
 
+/* baud [rate [policy]]: change the console baud rate (up to 8 Mbaud) and
+ * what happens when the TX ring is full (0 block, 1 drop, 2 overwrite). */
+void uart_baud_cmd(int argc, uint32_t rate, uint32_t policy, uint32_t arg3);
+
 #endif // SETUP_H
 
 // end file setup.h
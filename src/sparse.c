@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file sparse.c
+ * @brief Android sparse image expansion
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "sparse.h"
+#include "printf.h"
+#include <stdint.h>
+
+#define SPARSE_FILE_HDR_SZ  28U
+#define SPARSE_CHUNK_HDR_SZ 12U
+
+#define CHUNK_RAW       0xCAC1U
+#define CHUNK_FILL      0xCAC2U
+#define CHUNK_DONT_CARE 0xCAC3U
+#define CHUNK_CRC32     0xCAC4U
+
+static uint16_t rd16(const uint8_t *p)
+{
+   return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+   return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+          ((uint32_t)p[3] << 24);
+}
+
+int sparse_is_image(const uint8_t *buf, uint32_t len)
+{
+   if (len < SPARSE_FILE_HDR_SZ)
+      return 0;
+   if (rd32(&buf[0]) != SPARSE_MAGIC || rd16(&buf[4]) != 1U)
+      return 0;
+   const uint32_t blk_sz = rd32(&buf[12]);
+   return rd16(&buf[8]) >= SPARSE_FILE_HDR_SZ &&
+          rd16(&buf[10]) >= SPARSE_CHUNK_HDR_SZ && blk_sz != 0U &&
+          (blk_sz % 4U) == 0U;
+}
+
+uint64_t sparse_out_size(const uint8_t *buf, uint32_t len)
+{
+   if (!sparse_is_image(buf, len))
+      return 0U;
+   return (uint64_t)rd32(&buf[12]) * rd32(&buf[16]);
+}
+
+int sparse_expand(const uint8_t *buf, uint32_t len, uint64_t max_out,
+                  const struct sparse_ops *ops, void *ctx)
+{
+   if (!sparse_is_image(buf, len)) {
+      my_printf("sparse: bad header\r\n");
+      return -1;
+   }
+
+   const uint32_t file_hdr  = rd16(&buf[8]);
+   const uint32_t chunk_hdr = rd16(&buf[10]);
+   const uint32_t blk_sz    = rd32(&buf[12]);
+   const uint32_t chunks    = rd32(&buf[20]);
+   if (sparse_out_size(buf, len) > max_out) {
+      my_printf("sparse: image does not fit\r\n");
+      return -1;
+   }
+
+   uint32_t pos = file_hdr;
+   uint64_t out = 0U;
+   for (uint32_t i = 0; i < chunks; i++) {
+      if (pos > len || len - pos < chunk_hdr) {
+         my_printf("sparse: truncated at chunk %lu\r\n", (unsigned long)i);
+         return -1;
+      }
+      const uint8_t *c       = &buf[pos];
+      const uint16_t type    = rd16(&c[0]);
+      const uint64_t out_len = (uint64_t)rd32(&c[4]) * blk_sz;
+      const uint32_t total   = rd32(&c[8]);
+      const uint32_t body    = total - chunk_hdr;
+      if (total < chunk_hdr || total > len - pos || out + out_len > max_out) {
+         my_printf("sparse: bad chunk %lu\r\n", (unsigned long)i);
+         return -1;
+      }
+
+      int err = 0;
+      switch (type) {
+         case CHUNK_RAW:
+            if ((uint64_t)body != out_len) {
+               err = -1;
+               break;
+            }
+            if (body != 0U)
+               err = ops->write(ctx, out, &c[chunk_hdr], body);
+            break;
+         case CHUNK_FILL:
+            if (body != 4U) {
+               err = -1;
+               break;
+            }
+            if (out_len != 0U)
+               err = ops->fill(ctx, out, rd32(&c[chunk_hdr]), out_len);
+            break;
+         case CHUNK_DONT_CARE: break;
+         case CHUNK_CRC32:
+            /* Checksums are not verified; the chunk produces no output. */
+            break;
+         default: err = -1; break;
+      }
+      if (err != 0) {
+         my_printf("sparse: chunk %lu (type 0x%04x) failed\r\n",
+                   (unsigned long)i, (unsigned)type);
+         return -1;
+      }
+
+      pos += total;
+      out += out_len;
+   }
+   return 0;
+}
+
+// end file sparse.c
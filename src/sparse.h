@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file sparse.h
+ * @brief Android sparse image expansion
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * A sparse image is a 28-byte file header followed by chunks that each
+ * describe chunk_sz output blocks of blk_sz bytes: RAW (data follows), FILL
+ * (one 32-bit pattern follows), DONT_CARE (nothing follows, output is left
+ * as it is) and CRC32 (checksum of the output so far).  sparse_expand()
+ * walks the chunks and hands the RAW and FILL ranges to the caller; it never
+ * touches the DONT_CARE ranges.
+ */
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdint.h>
+
+#define SPARSE_MAGIC 0xED26FF3AU
+
+/* Output sink.  Offsets are in bytes from the start of the expanded image,
+ * strictly increasing from call to call, and multiples of the image blk_sz.
+ * Both return 0 on success; anything else aborts the expansion. */
+struct sparse_ops {
+   int (*write)(void *ctx, uint64_t off, const uint8_t *buf, uint32_t len);
+   int (*fill)(void *ctx, uint64_t off, uint32_t pattern, uint64_t len);
+};
+
+/* Nonzero if buf (len bytes) starts with a sparse file header. */
+int sparse_is_image(const uint8_t *buf, uint32_t len);
+
+/* Expanded size in bytes of the image in buf (0 if not a sparse image). */
+uint64_t sparse_out_size(const uint8_t *buf, uint32_t len);
+
+/* Expand the sparse image in buf (len bytes) into ops, refusing images that
+ * would expand past max_out bytes.  Returns 0 on success or -1 on a
+ * malformed image or sink error. */
+int sparse_expand(const uint8_t *buf, uint32_t len, uint64_t max_out,
+                  const struct sparse_ops *ops, void *ctx);
+
+#endif // SPARSE_H
+
+// end file sparse.h
@@ -50,4 +50,8 @@
 #define USE_HAL_LTDC_REGISTER_CALLBACKS 0
 #define USE_HAL_ETH_REGISTER_CALLBACKS  0
 
+/* ETH DMA ring sizes; the frame buffers are in DDR (see eth.c). */
+#define ETH_RX_DESC_CNT 32U
+#define ETH_TX_DESC_CNT 8U
+
 #endif /* __STM32MP13xx_HAL_CONF_H */
@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file tftp.c
+ * @brief TFTP client for network boot
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "tftp.h"
+#include <stdint.h>
+
+#if defined(NETBOOT) && !defined(ETHERNET)
+#error "NETBOOT requires ETHERNET"
+#endif
+
+#ifdef ETHERNET
+#include "console.h"
+#include "crc.h"
+#include "ddr_map.h"
+#include "defaults.h"
+#include "dtb.h"
+#include "net.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TFTP_PORT       69U
+#define TFTP_BLKSIZE    1468U /* 1500 - IP - UDP - TFTP headers */
+#define TFTP_WINDOW     16U   /* blocks per ACK, well inside the RX ring */
+#define TFTP_DEF_BLK    512U
+#define TFTP_TIMEOUT_MS 1000U
+#define TFTP_RETRIES    5U
+#define TFTP_ARP_MS     3000U
+#define TFTP_DTB_MAX    0x00100000U
+
+#define OP_RRQ   1U
+#define OP_DATA  3U
+#define OP_ACK   4U
+#define OP_ERROR 5U
+#define OP_OACK  6U
+
+#define ERR_DISK_FULL 3U
+
+/* Transfer in progress. */
+static struct {
+   uint32_t server;
+   uint16_t server_port; /* server's transfer ID, 0 until it answers */
+   uint16_t local_port;
+   uint8_t *dst;
+   uint32_t max;
+   uint32_t len;       /* bytes received in order */
+   uint32_t blocks;    /* blocks received in order */
+   uint32_t blksize;   /* negotiated, or the RFC 1350 default */
+   uint32_t window;    /* blocks per ACK */
+   uint32_t in_window; /* in-order blocks since the last ACK */
+   int gap_acked;      /* lost block already reported */
+   int state;          /* 0 running, 1 done, -1 failed */
+   uint32_t retries;
+   uint32_t t_last; /* last progress, for the retransmit timer */
+} tf;
+
+static uint16_t get16(const uint8_t *p)
+{
+   return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+   p[0] = (uint8_t)(v >> 8);
+   p[1] = (uint8_t)v;
+}
+
+static void send_ack(void)
+{
+   uint8_t *d = net_udp_alloc();
+   if (d == NULL)
+      return;
+   put16(&d[0], OP_ACK);
+   put16(&d[2], (uint16_t)tf.blocks);
+   (void)net_udp_send(d, 4U, tf.server, tf.local_port, tf.server_port);
+   tf.in_window = 0U;
+}
+
+static void send_error(uint16_t code, const char *msg)
+{
+   uint8_t *d = net_udp_alloc();
+   if (d == NULL)
+      return;
+   const uint32_t n = (uint32_t)strlen(msg) + 1U;
+   put16(&d[0], OP_ERROR);
+   put16(&d[2], code);
+   memcpy(&d[4], msg, n);
+   (void)net_udp_send(d, 4U + n, tf.server, tf.local_port, tf.server_port);
+}
+
+static int send_rrq(const char *file)
+{
+   uint8_t *d = net_udp_alloc();
+   if (d == NULL)
+      return -1;
+
+   /* Each option is a NUL-terminated name and value. */
+   static const char opts[] = "octet\0blksize\0"
+                              "1468\0windowsize\0"
+                              "16\0tsize\0"
+                              "0";
+   const uint32_t flen = (uint32_t)strlen(file) + 1U;
+   if (2U + flen + sizeof(opts) > NET_UDP_MAX) {
+      net_udp_drop(d);
+      return -1;
+   }
+
+   put16(&d[0], OP_RRQ);
+   memcpy(&d[2], file, flen);
+   memcpy(&d[2U + flen], opts, sizeof(opts));
+   return net_udp_send(d, 2U + flen + (uint32_t)sizeof(opts), tf.server,
+                       tf.local_port, TFTP_PORT);
+}
+
+/* Length of the string at p, which may lack its NUL before end. */
+static size_t field_len(const char *p, const char *end)
+{
+   size_t n = 0U;
+   while (p + n < end && p[n] != '\0')
+      n++;
+   return n;
+}
+
+static void fail(const char *msg)
+{
+   my_printf("\r\ntftp: %s\r\n", msg);
+   tf.state = -1;
+}
+
+/* Option acknowledgement: the server may lower what we asked for. */
+static void oack_input(const uint8_t *d, uint32_t len)
+{
+   const char *p   = (const char *)&d[2];
+   const char *end = (const char *)&d[len];
+   while (p < end) {
+      const char *name = p;
+      p += field_len(p, end) + 1U;
+      if (p >= end)
+         break;
+      const char *val = p;
+      p += field_len(p, end) + 1U;
+      if (p > end)
+         break;
+
+      const uint32_t v = (uint32_t)strtoul(val, NULL, 10);
+      if (strcmp(name, "blksize") == 0 && v >= 8U && v <= TFTP_BLKSIZE)
+         tf.blksize = v;
+      else if (strcmp(name, "windowsize") == 0 && v >= 1U &&
+               v <= TFTP_WINDOW)
+         tf.window = v;
+      else if (strcmp(name, "tsize") == 0 && v > tf.max) {
+         send_error(ERR_DISK_FULL, "file too large");
+         fail("file too large");
+         return;
+      }
+   }
+   send_ack();
+}
+
+static void data_input(const uint8_t *d, uint32_t len)
+{
+   const uint16_t blk = get16(&d[2]);
+   const uint32_t n   = len - 4U;
+   if (n > tf.blksize)
+      return;
+
+   if (blk != (uint16_t)(tf.blocks + 1U)) {
+      /* A gap: report the last block we have, once, and the server goes
+       * back to it (RFC 7440).  Older duplicates are simply ignored. */
+      if ((uint16_t)(blk - (uint16_t)tf.blocks) < 0x8000U && !tf.gap_acked) {
+         send_ack();
+         tf.gap_acked = 1;
+      }
+      return;
+   }
+
+   if (tf.len + n > tf.max) {
+      send_error(ERR_DISK_FULL, "file too large");
+      fail("file too large");
+      return;
+   }
+   memcpy(&tf.dst[tf.len], &d[4], n);
+   tf.len += n;
+   tf.blocks++;
+   tf.in_window++;
+   tf.gap_acked = 0;
+   tf.retries   = 0U;
+   tf.t_last    = HAL_GetTick();
+
+   if (n < tf.blksize) {
+      send_ack();
+      tf.state = 1;
+   } else if (tf.in_window >= tf.window) {
+      send_ack();
+   }
+}
+
+static void tftp_input(const uint8_t *d, uint32_t len, uint32_t src_ip,
+                       uint16_t src_port)
+{
+   if (tf.state != 0 || src_ip != tf.server || len < 4U)
+      return;
+   if (tf.server_port == 0U)
+      tf.server_port = src_port;
+   else if (src_port != tf.server_port)
+      return;
+
+   switch (get16(&d[0])) {
+      case OP_OACK:
+         if (tf.blocks == 0U)
+            oack_input(d, len);
+         break;
+      case OP_DATA: data_input(d, len); break;
+      case OP_ERROR:
+         my_printf("\r\ntftp: server error %u: %.*s\r\n",
+                   (unsigned)get16(&d[2]), (int)(len - 4U),
+                   (const char *)&d[4]);
+         tf.state = -1;
+         break;
+      default: break;
+   }
+}
+
+int32_t tftp_get(uint32_t server, const char *file, uint8_t *dst,
+                 uint32_t max)
+{
+   memset(&tf, 0, sizeof(tf));
+   tf.server     = server;
+   tf.local_port = (uint16_t)(49152U + (HAL_GetTick() & 0x3FFFU));
+   tf.dst        = dst;
+   tf.max        = max;
+   tf.blksize    = TFTP_DEF_BLK;
+   tf.window     = 1U;
+
+   if (net_arp_resolve(server, TFTP_ARP_MS) != 0) {
+      my_printf("tftp: server not reachable\r\n");
+      return -1;
+   }
+   if (net_udp_listen(tf.local_port, tftp_input) != 0)
+      return -1;
+
+   my_printf("tftp: %s -> 0x%08lx\r\n", file, (unsigned long)dst);
+   const uint32_t t0 = HAL_GetTick();
+   uint32_t t_print  = t0;
+   tf.t_last         = t0;
+   (void)send_rrq(file);
+
+   while (tf.state == 0) {
+      net_poll();
+      const uint32_t now = HAL_GetTick();
+      if (console_interrupted()) {
+         send_error(0U, "cancelled");
+         fail("cancelled");
+      } else if (now - tf.t_last >= TFTP_TIMEOUT_MS) {
+         if (++tf.retries > TFTP_RETRIES) {
+            fail("timeout");
+            break;
+         }
+         /* Until the server answers, ask again; after, re-ACK what we
+          * have and let it resend the window. */
+         if (tf.server_port == 0U)
+            (void)send_rrq(file);
+         else
+            send_ack();
+         tf.t_last = now;
+      }
+      if (now - t_print >= 2000U) {
+         my_printf("\r%lu KiB  ", (unsigned long)(tf.len >> 10));
+         t_print = now;
+      }
+   }
+   net_udp_close(tf.local_port);
+   if (tf.state < 0)
+      return -1;
+
+   const uint32_t ms = HAL_GetTick() - t0;
+   /* bytes per ms is kB/s; in hundredths of MB/s */
+   const uint32_t rate = (ms != 0U) ? (uint32_t)((uint64_t)tf.len / ms / 10U)
+                                    : 0U;
+   my_printf("\rtftp: %lu bytes in %lu ms, %lu.%02lu MB/s (block %lu, "
+             "window %lu)\r\n",
+             (unsigned long)tf.len, (unsigned long)ms,
+             (unsigned long)(rate / 100U), (unsigned long)(rate % 100U),
+             (unsigned long)tf.blksize, (unsigned long)tf.window);
+   my_printf("tftp: crc32 %08lx\r\n", (unsigned long)crc32(tf.dst, tf.len));
+   return (int32_t)tf.len;
+}
+
+int tftp_load_two(uint32_t server)
+{
+   const struct net_cfg *cfg = net_config();
+   if (cfg->ip == 0U) {
+      my_printf("DHCP ...\r\n");
+      if (net_dhcp() != 0) {
+         my_printf("DHCP failed\r\n");
+         return -1;
+      }
+   }
+   if (server == 0U)
+      server = cfg->server;
+   if (server == 0U) {
+      my_printf("tftp: no server\r\n");
+      return -1;
+   }
+
+   const char *kernel =
+       (cfg->bootfile[0] != '\0') ? cfg->bootfile : DEF_TFTP_KERNEL;
+   /* Reserve room for the largest image, then shrink to what came. */
+   const uint32_t kmax = DEF_DTB_ADDR - DEF_LINUX_ADDR;
+   if (ddr_map_reserve("kernel", DEF_LINUX_ADDR, kmax, 0U) != 0)
+      return -1;
+   const int32_t klen =
+       tftp_get(server, kernel, (uint8_t *)DEF_LINUX_ADDR, kmax);
+   if (klen < 0)
+      return -1;
+   if (klen > 0)
+      (void)ddr_map_reserve("kernel", DEF_LINUX_ADDR, (uint32_t)klen, 0U);
+
+   if (ddr_map_reserve("dtb", DEF_DTB_ADDR, TFTP_DTB_MAX, 0U) != 0)
+      return -1;
+   if (tftp_get(server, DEF_TFTP_DTB, (uint8_t *)DEF_DTB_ADDR,
+                TFTP_DTB_MAX) < 0)
+      return -1;
+   (void)dtb_claim();
+   return 0;
+}
+
+void tftp_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+   (void)arg2;
+   (void)arg3;
+   (void)tftp_load_two((argc >= 1) ? arg1 : 0U);
+}
+
+#endif // ETHERNET
+
+// end file tftp.c
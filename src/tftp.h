@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file tftp.h
+ * @brief TFTP client for network boot
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * Asks for a 1468-byte block size (RFC 2348), which fills a full Ethernet
+ * frame, and a window of several blocks per ACK (RFC 7440).  Servers that
+ * ignore the options get plain 512-byte stop-and-wait.  Each block is copied
+ * once, from the DMA buffer to its place in DDR.
+ */
+
+#ifndef TFTP_H
+#define TFTP_H
+
+#include <stdint.h>
+
+/* Download file from server into dst, at most max bytes.  Returns the file
+ * length, or -1 on error, timeout or Ctrl-C. */
+int32_t tftp_get(uint32_t server, const char *file, uint8_t *dst,
+                 uint32_t max);
+
+/* Configure the network by DHCP unless already done, then load the kernel
+ * (DHCP boot file, or DEF_TFTP_KERNEL) to DEF_LINUX_ADDR and DEF_TFTP_DTB
+ * to DEF_DTB_ADDR.  server 0 means the DHCP boot server.  Returns 0 on
+ * success. */
+int tftp_load_two(uint32_t server);
+
+void tftp_cmd(int argc, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#endif // TFTP_H
+
+// end file tftp.h
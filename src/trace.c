@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file trace.c
+ * @brief Binary event log in DDR, formatted later
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "trace.h"
+#include "defaults.h"
+#include "irq.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include <stdint.h>
+
+#define TRACE_NREC ((DEF_TRACE_SIZE - sizeof(struct trace_hdr)) /            \
+                    sizeof(struct trace_rec))
+#define TRACE_SHOW 100U
+
+static volatile struct trace_hdr *const hdr =
+    (volatile struct trace_hdr *)DEF_TRACE_ADDR;
+static struct trace_rec *const recs =
+    (struct trace_rec *)(DEF_TRACE_ADDR + sizeof(struct trace_hdr));
+static int ready;
+
+void trace_init(void)
+{
+   hdr->magic    = TRACE_MAGIC;
+   hdr->rec_size = sizeof(struct trace_rec);
+   hdr->nrec     = TRACE_NREC;
+   hdr->head     = 0U;
+   hdr->freq     = DEF_STGEN_HZ;
+   ready         = 1;
+}
+
+void trace_log(uint32_t nargs, const char *fmt, uint32_t a0, uint32_t a1,
+               uint32_t a2, uint32_t a3)
+{
+   if (!ready)
+      return;
+   const uint64_t t = __get_CNTPCT();
+
+   /* Only claiming the slot needs IRQs masked; an event logged from an
+    * interrupt meanwhile gets the next one. */
+   const uint32_t cpsr = irq_save();
+   const uint32_t seq = hdr->head++;
+   irq_restore(cpsr);
+
+   struct trace_rec *r = &recs[seq % TRACE_NREC];
+   r->ts_lo            = (uint32_t)t;
+   r->ts_hi            = (uint32_t)(t >> 32U);
+   r->fmt              = fmt;
+   r->nargs            = nargs;
+   r->arg[0]           = a0;
+   r->arg[1]           = a1;
+   r->arg[2]           = a2;
+   r->arg[3]           = a3;
+}
+
+void trace_cmd(int argc, uint32_t n, uint32_t arg2, uint32_t arg3)
+{
+   (void)arg2;
+   (void)arg3;
+   if (!ready) {
+      my_printf("trace: not initialized\r\n");
+      return;
+   }
+   if (argc >= 1 && n == 0U) {
+      hdr->head = 0U;
+      return;
+   }
+
+   const uint32_t head  = hdr->head;
+   const uint32_t avail = (head < TRACE_NREC) ? head : TRACE_NREC;
+   if (argc < 1)
+      n = TRACE_SHOW;
+   if (n > avail)
+      n = avail;
+
+   for (uint32_t seq = head - n; seq != head; seq++) {
+      const struct trace_rec *r = &recs[seq % TRACE_NREC];
+      const uint64_t t = ((uint64_t)r->ts_hi << 32U) | r->ts_lo;
+      const uint32_t s = (uint32_t)(t / DEF_STGEN_HZ);
+      const uint32_t us =
+          (uint32_t)((t % DEF_STGEN_HZ) / (DEF_STGEN_HZ / 1000000U));
+      my_printf("[%5lu.%06lu] ", (unsigned long)s, (unsigned long)us);
+      my_printf(r->fmt, r->arg[0], r->arg[1], r->arg[2], r->arg[3]);
+      my_printf("\r\n");
+   }
+   my_printf("trace: %lu of %lu events\r\n", (unsigned long)n,
+             (unsigned long)head);
+}
+
+// end file trace.c
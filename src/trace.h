@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file trace.h
+ * @brief Binary event log in DDR, formatted later
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * TRACE(fmt, ...) stores a system counter timestamp, the address of the
+ * format string and up to four 32-bit arguments in a ring at DEF_TRACE_ADDR,
+ * and formats nothing.  The `trace` command prints the ring on the console;
+ * scripts/tracedump.py decodes a copy of it against the bootloader ELF.
+ * boot_jump() adds the ring to the kernel DTB as reserved memory, so under
+ * Linux it can still be read from /dev/mem.
+ *
+ * The format and any %s arguments must be string literals, since only their
+ * addresses are kept; the line end is added when printing.  Events before
+ * trace_init() (i.e. before DDR is up) are dropped.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_MAGIC    0x54524331U /* "TRC1" */
+#define TRACE_MAX_ARGS 4U
+
+/* The region starts with this header, followed by nrec records; record
+ * (head - 1) % nrec is the newest. */
+struct trace_hdr {
+   uint32_t magic;
+   uint32_t rec_size;
+   uint32_t nrec;
+   uint32_t head; /* records ever written */
+   uint32_t freq; /* timestamp counts per second */
+   uint32_t reserved[3];
+};
+
+struct trace_rec {
+   uint32_t ts_lo;
+   uint32_t ts_hi;
+   const char *fmt;
+   uint32_t nargs;
+   uint32_t arg[TRACE_MAX_ARGS];
+};
+
+/* TRACE("fmt", a, b) calls trace_log(2, "fmt", a, b, 0, 0). */
+#define TRACE(...)                                                             \
+   trace_log(TRACE_NARGS_(__VA_ARGS__, 4, 3, 2, 1, 0, 0),                      \
+             TRACE_ARGS_(__VA_ARGS__, 0, 0, 0, 0, 0))
+#define TRACE_NARGS_(fmt, a, b, c, d, n, ...) (n)
+#define TRACE_ARGS_(fmt, a, b, c, d, ...)                                      \
+   (fmt), (uint32_t)(uintptr_t)(a), (uint32_t)(uintptr_t)(b),                  \
+       (uint32_t)(uintptr_t)(c), (uint32_t)(uintptr_t)(d)
+
+/* Clear the ring and start logging; DDR and the MMU must be up. */
+void trace_init(void);
+
+void trace_log(uint32_t nargs, const char *fmt, uint32_t a0, uint32_t a1,
+               uint32_t a2, uint32_t a3);
+
+/* trace [n]: print the newest n events (default 100); n 0 clears. */
+void trace_cmd(int argc, uint32_t n, uint32_t arg2, uint32_t arg3);
+
+#endif // TRACE_H
+
+// end file trace.h
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file usb_acm.c
+ * @brief USB CDC-ACM console function of the composite USB device
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "usb_acm.h"
+#include <stdint.h>
+
+#ifdef USB_ACM
+
+#include "console.h"
+#include "irq_ctrl.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+
+#define ACM_TXBUF_SIZE 2048U
+#define ACM_RXBUF_SIZE 512U
+#define ACM_MAX_XFER   512U
+#define ACM_SPIN_LIMIT 1000000U
+
+static PCD_HandleTypeDef *acm_pcd;
+static printf_output_fn_t prev_output;
+static volatile uint8_t port_open;
+
+/* 115200 8N1; only reported back to the host. */
+static uint8_t line_coding[7] = {0x00, 0xC2, 0x01, 0x00, 0U, 0U, 8U};
+
+/* Output ring: my_printf appends at tx_head, the IN endpoint drains from
+ * tx_tail; tx_len is the size of the transfer in flight (0 = idle).  The
+ * PCD runs without DMA, so the CPU copies into the FIFO and no cache
+ * maintenance is needed. */
+static uint8_t tx_buf[ACM_TXBUF_SIZE];
+static volatile uint32_t tx_head;
+static volatile uint32_t tx_tail;
+static volatile uint32_t tx_len;
+static uint8_t rx_buf[ACM_RXBUF_SIZE];
+
+static uint32_t tx_pending(void)
+{
+   return (tx_head - tx_tail) % ACM_TXBUF_SIZE;
+}
+
+/* Start the next IN transfer.  Runs in the OTG interrupt, or with it
+ * masked. */
+static void tx_start(void)
+{
+   if (tx_len != 0U || !port_open || tx_head == tx_tail)
+      return;
+   uint32_t n = (tx_head > tx_tail) ? tx_head - tx_tail
+                                    : ACM_TXBUF_SIZE - tx_tail;
+   if (n > ACM_MAX_XFER)
+      n = ACM_MAX_XFER;
+   tx_len = n;
+   (void)HAL_PCD_EP_Transmit(acm_pcd, ACM_DATA_IN_EP, &tx_buf[tx_tail], n);
+}
+
+static void tx_kick(void)
+{
+   IRQ_Disable(OTG_IRQn);
+   tx_start();
+   IRQ_Enable(OTG_IRQn);
+}
+
+static void acm_putc(char c)
+{
+   uart_mirror_char(c);
+
+   /* When the ring is full, wait for the host to drain it -- unless we are
+    * running at or above the USB interrupt priority, in which case it never
+    * will and the character is dropped. */
+   const uint32_t next = (tx_head + 1U) % ACM_TXBUF_SIZE;
+   for (uint32_t n = 0; next == tx_tail; n++)
+      if (!port_open || n >= ACM_SPIN_LIMIT)
+         return;
+   tx_buf[tx_head] = (uint8_t)c;
+   tx_head         = next;
+
+   /* Batch characters into packets: flush at line ends (progress reports
+    * use a bare '\r') or once a full packet has accumulated. */
+   if (c == '\n' || c == '\r' || tx_pending() >= ACM_MAX_XFER)
+      tx_kick();
+}
+
+static void acm_close(void)
+{
+   port_open = 0U;
+   if (printf_get_output() == acm_putc)
+      printf_set_output(prev_output);
+}
+
+void usb_acm_start(PCD_HandleTypeDef *pcd)
+{
+   acm_pcd = pcd;
+   (void)HAL_PCD_EP_Open(acm_pcd, ACM_NOTIFY_EP, 8U, EP_TYPE_INTR);
+   (void)HAL_PCD_EP_Open(acm_pcd, ACM_DATA_IN_EP, ACM_MAX_XFER, EP_TYPE_BULK);
+   (void)HAL_PCD_EP_Open(acm_pcd, ACM_DATA_OUT_EP, ACM_MAX_XFER,
+                         EP_TYPE_BULK);
+   (void)HAL_PCD_EP_Receive(acm_pcd, ACM_DATA_OUT_EP, rx_buf,
+                            ACM_RXBUF_SIZE);
+}
+
+void usb_acm_stop(void)
+{
+   acm_close();
+   tx_len  = 0U;
+   tx_tail = tx_head;
+}
+
+uint8_t *usb_acm_line_coding(void)
+{
+   return line_coding;
+}
+
+void usb_acm_line_state(uint16_t state)
+{
+   if ((state & 1U) != 0U && !port_open) {
+      port_open   = 1U;
+      prev_output = printf_get_output();
+      printf_set_output(acm_putc);
+   } else if ((state & 1U) == 0U && port_open) {
+      acm_close();
+   }
+}
+
+void usb_acm_data_in(void)
+{
+   tx_tail = (tx_tail + tx_len) % ACM_TXBUF_SIZE;
+   tx_len  = 0U;
+   tx_start();
+}
+
+void usb_acm_data_out(uint32_t len)
+{
+   for (uint32_t i = 0; i < len && i < ACM_RXBUF_SIZE; i++)
+      console_push((char)rx_buf[i]);
+   (void)HAL_PCD_EP_Receive(acm_pcd, ACM_DATA_OUT_EP, rx_buf,
+                            ACM_RXBUF_SIZE);
+}
+
+void usb_acm_poll(void)
+{
+   if (port_open && tx_len == 0U && tx_head != tx_tail)
+      tx_kick();
+}
+
+#endif // USB_ACM
+
+// end file usb_acm.c
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file usb_acm.h
+ * @brief USB CDC-ACM console function of the composite USB device
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * usb_msc.c owns the PCD, the descriptors and EP0; it forwards the ACM class
+ * requests and endpoint completions here.  While the host holds DTR (i.e.
+ * has the port open), my_printf output goes to USB and UART4 becomes a
+ * best-effort mirror; received characters are fed to console_push() just
+ * like UART input.
+ */
+
+#ifndef USB_ACM_H
+#define USB_ACM_H
+
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_pcd.h"
+#include <stdint.h>
+
+#define ACM_COMM_IF     1U
+#define ACM_DATA_IF     2U
+#define ACM_NOTIFY_EP   0x83U
+#define ACM_DATA_IN_EP  0x82U
+#define ACM_DATA_OUT_EP 0x02U
+
+#define ACM_REQ_SET_LINE_CODING        0x20U
+#define ACM_REQ_GET_LINE_CODING        0x21U
+#define ACM_REQ_SET_CONTROL_LINE_STATE 0x22U
+#define ACM_REQ_SEND_BREAK             0x23U
+
+/* Open the ACM endpoints (SET_CONFIGURATION) / forget all state (bus
+ * reset). */
+void usb_acm_start(PCD_HandleTypeDef *pcd);
+void usb_acm_stop(void);
+
+/* 7-byte line coding, read by GET_LINE_CODING and written by
+ * SET_LINE_CODING.  It has no effect beyond being echoed back. */
+uint8_t *usb_acm_line_coding(void);
+
+/* SET_CONTROL_LINE_STATE: bit 0 (DTR) opens or closes the console. */
+void usb_acm_line_state(uint16_t state);
+
+/* Endpoint completion callbacks. */
+void usb_acm_data_in(void);
+void usb_acm_data_out(uint32_t len);
+
+/* Send whatever output is still waiting for a line end (e.g. the prompt). */
+void usb_acm_poll(void);
+
+#endif // USB_ACM_H
+
+// end file usb_acm.h
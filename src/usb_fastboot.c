@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file usb_fastboot.c
+ * @brief Android fastboot function of the composite USB device
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "usb_fastboot.h"
+#include <stdint.h>
+
+#ifdef FASTBOOT
+
+#include "boot.h"
+#include "console.h"
+#include "crc.h"
+#include "ddr_map.h"
+#include "defaults.h"
+#include "dma.h"
+#include "dtb.h"
+#include "flash.h"
+#include "irq_ctrl.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "warm.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef NAND_FLASH
+#include "sd.h"
+#else
+#include "fmc.h"
+#endif
+
+#define FB_PACKET_SIZE 512U
+#define FB_CMD_LEN     64U
+#define FB_CHUNK       0x40000U /* bytes per OUT transfer (< 1023 packets) */
+#define FB_TX_TIMEOUT  1000U    /* ms to wait for the previous response */
+
+/* OUT transfers are whole packets, so the last one of a download may run
+ * up to a packet past its end. */
+#define FB_MAX_DOWNLOAD (DEF_FASTBOOT_SIZE - FB_PACKET_SIZE)
+
+/* boot: kernel and second-stage (DTB) images each get the 32 MiB between
+ * their load address and the next one. */
+#define FB_SLOT_SIZE (DEF_DTB_ADDR - DEF_LINUX_ADDR)
+
+static PCD_HandleTypeDef *fb_pcd;
+static uint8_t rx_buf[FB_PACKET_SIZE];
+static char tx_buf[FB_CMD_LEN];
+static char cmd_buf[FB_CMD_LEN + 1U];
+static volatile uint8_t cmd_pending;
+static volatile uint8_t tx_busy;
+static volatile uint8_t dl_active;
+static volatile uint8_t dl_done;
+static volatile uint32_t dl_received;
+static uint32_t dl_size;
+static uint32_t dl_len; /* size of the last complete download */
+
+static uint8_t *const dl_buf = (uint8_t *)DEF_FASTBOOT_ADDR;
+
+static uint32_t rd32(const uint8_t *p)
+{
+   return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+          ((uint32_t)p[3] << 24);
+}
+
+/* ------------------------------------------------------------------------
+ * Interrupt side
+ * ------------------------------------------------------------------------ */
+
+static void recv_cmd(void)
+{
+   (void)HAL_PCD_EP_Receive(fb_pcd, FB_OUT_EP, rx_buf, FB_PACKET_SIZE);
+}
+
+/* Receive the next piece of a download straight into DDR. */
+static void recv_data(void)
+{
+   uint32_t n = dl_size - dl_received;
+   if (n > FB_CHUNK)
+      n = FB_CHUNK;
+   n = (n + FB_PACKET_SIZE - 1U) & ~(FB_PACKET_SIZE - 1U);
+   (void)HAL_PCD_EP_Receive(fb_pcd, FB_OUT_EP, dl_buf + dl_received, n);
+}
+
+void usb_fastboot_start(PCD_HandleTypeDef *pcd)
+{
+   fb_pcd = pcd;
+   usb_fastboot_stop();
+   (void)HAL_PCD_EP_Open(fb_pcd, FB_IN_EP, FB_PACKET_SIZE, EP_TYPE_BULK);
+   (void)HAL_PCD_EP_Open(fb_pcd, FB_OUT_EP, FB_PACKET_SIZE, EP_TYPE_BULK);
+   recv_cmd();
+}
+
+void usb_fastboot_stop(void)
+{
+   cmd_pending = 0U;
+   tx_busy     = 0U;
+   dl_active   = 0U;
+   dl_done     = 0U;
+}
+
+void usb_fastboot_data_in(void)
+{
+   tx_busy = 0U;
+}
+
+void usb_fastboot_data_out(uint32_t len)
+{
+   if (dl_active) {
+      dl_received += len;
+      /* A short packet ends the download early. */
+      if (dl_received >= dl_size || (len % FB_PACKET_SIZE) != 0U) {
+         dl_active = 0U;
+         dl_done   = 1U;
+      } else {
+         recv_data();
+      }
+      return;
+   }
+
+   if (len > FB_CMD_LEN)
+      len = FB_CMD_LEN;
+   memcpy(cmd_buf, rx_buf, len);
+   cmd_buf[len] = '\0';
+   cmd_pending  = 1U;
+}
+
+/* ------------------------------------------------------------------------
+ * Responses
+ * ------------------------------------------------------------------------ */
+
+static void wait_tx(void)
+{
+   const uint32_t t0 = HAL_GetTick();
+   while (tx_busy && (HAL_GetTick() - t0) < FB_TX_TIMEOUT)
+      ;
+}
+
+static void send(const char *tag, const char *msg)
+{
+   wait_tx();
+   int n = snprintf(tx_buf, sizeof(tx_buf), "%s%s", tag, msg);
+   if (n > (int)sizeof(tx_buf) - 1)
+      n = (int)sizeof(tx_buf) - 1;
+   IRQ_Disable(OTG_IRQn);
+   tx_busy = 1U;
+   (void)HAL_PCD_EP_Transmit(fb_pcd, FB_IN_EP, (uint8_t *)tx_buf, (uint32_t)n);
+   IRQ_Enable(OTG_IRQn);
+}
+
+static void okay(const char *msg)
+{
+   send("OKAY", msg);
+}
+
+static void fail(const char *msg)
+{
+   my_printf("fastboot: %s\r\n", msg);
+   send("FAIL", msg);
+}
+
+/* Send the final OKAY and get off the bus before leaving the bootloader. */
+static void okay_and_detach(void)
+{
+   okay("");
+   wait_tx();
+   (void)HAL_PCD_DevDisconnect(fb_pcd);
+}
+
+/* ------------------------------------------------------------------------
+ * Commands
+ * ------------------------------------------------------------------------ */
+
+static void getvar(const char *name)
+{
+   char val[FB_CMD_LEN];
+   struct flash_part p;
+
+   if (strcmp(name, "version") == 0) {
+      okay("0.4");
+   } else if (strcmp(name, "product") == 0) {
+      okay("STM32MP135");
+   } else if (strcmp(name, "is-userspace") == 0) {
+      okay("no");
+   } else if (strcmp(name, "max-download-size") == 0) {
+      (void)snprintf(val, sizeof(val), "0x%08lx",
+                     (unsigned long)FB_MAX_DOWNLOAD);
+      okay(val);
+   } else if (strncmp(name, "partition-size:", 15) == 0 &&
+              flash_lookup(name + 15, &p) == 0) {
+      const uint64_t size = (uint64_t)p.count * p.unit;
+      (void)snprintf(val, sizeof(val), "0x%08lx%08lx",
+                     (unsigned long)(size >> 32),
+                     (unsigned long)(size & 0xFFFFFFFFU));
+      okay(val);
+   } else if (strncmp(name, "partition-type:", 15) == 0 &&
+              flash_lookup(name + 15, &p) == 0) {
+      okay("raw");
+   } else {
+      fail("unknown variable");
+   }
+}
+
+/* Returns 1 if the data phase was started. */
+static int download(const char *arg)
+{
+   char val[FB_CMD_LEN];
+   char *end;
+   const uint32_t size = (uint32_t)strtoul(arg, &end, 16);
+
+   if (*end != '\0' || size == 0U || size > FB_MAX_DOWNLOAD) {
+      fail("bad download size");
+      return 0;
+   }
+
+   dl_len      = 0U;
+   dl_size     = size;
+   dl_received = 0U;
+   IRQ_Disable(OTG_IRQn);
+   dl_active = 1U;
+   recv_data();
+   IRQ_Enable(OTG_IRQn);
+
+   (void)snprintf(val, sizeof(val), "%08lx", (unsigned long)size);
+   send("DATA", val);
+   return 1;
+}
+
+static void flash(const char *name)
+{
+   struct flash_part p;
+   if (dl_len == 0U) {
+      fail("no image downloaded");
+      return;
+   }
+   if (flash_lookup(name, &p) != 0) {
+      fail("unknown partition");
+      return;
+   }
+   if (flash_write(&p, dl_buf, dl_len) != 0)
+      fail("write error");
+   else
+      okay("");
+}
+
+static void erase(const char *name)
+{
+   struct flash_part p;
+   if (flash_lookup(name, &p) != 0) {
+      fail("unknown partition");
+      return;
+   }
+   if (flash_erase(&p) != 0)
+      fail("erase error");
+   else
+      okay("");
+}
+
+/* Load the stored DTB for a boot image that does not carry its own. */
+static int load_dtb(void)
+{
+   struct flash_part p;
+   if (flash_lookup("dtb", &p) != 0 ||
+       (uint64_t)p.count * p.unit > FB_SLOT_SIZE ||
+       ddr_map_reserve("dtb", DEF_DTB_ADDR, p.count * p.unit, 0U) != 0)
+      return -1;
+   return flash_read(&p, (uint8_t *)DEF_DTB_ADDR, p.count);
+}
+
+/* Queue a copy out of the download buffer, or make it now if the MDMA
+ * cannot take it. */
+static void copy_start(struct dma_req *r, uint32_t dst, uint64_t off,
+                       uint32_t len)
+{
+   *r = (struct dma_req){.dst = (void *)dst, .src = dl_buf + off, .len = len};
+   if (len != 0U && dma_memcpy(r) != 0)
+      memcpy(r->dst, r->src, len);
+}
+
+static void copy_wait(struct dma_req *r)
+{
+   if (r->len != 0U && dma_wait(r) != 0)
+      memcpy(r->dst, r->src, r->len);
+}
+
+/* Boot an Android boot image (v0 header: kernel, ramdisk and a second-stage
+ * image taken to be the DTB) or a bare kernel. */
+static void boot(void)
+{
+   uint32_t k_off = 0U;
+   uint32_t k_len = dl_len;
+   uint32_t r_len = 0U;
+   uint64_t r_off = 0U;
+   uint32_t s_len = 0U;
+   uint64_t s_off = 0U;
+
+   if (dl_len == 0U) {
+      fail("no image downloaded");
+      return;
+   }
+   if (dl_len >= 40U && memcmp(dl_buf, "ANDROID!", 8) == 0) {
+      const uint32_t page = rd32(&dl_buf[36]);
+      if (page == 0U || (page & (page - 1U)) != 0U) {
+         fail("bad boot image header");
+         return;
+      }
+      k_len = rd32(&dl_buf[8]);
+      r_len = rd32(&dl_buf[16]);
+      s_len = rd32(&dl_buf[24]);
+      k_off = page;
+      r_off = k_off + (((uint64_t)k_len + page - 1U) & ~(uint64_t)(page - 1U));
+      s_off = r_off + (((uint64_t)r_len + page - 1U) & ~(uint64_t)(page - 1U));
+      if (s_off + s_len > dl_len) {
+         fail("truncated boot image");
+         return;
+      }
+   }
+   if (k_len == 0U || k_len > FB_SLOT_SIZE || s_len > FB_SLOT_SIZE ||
+       r_len > DEF_INITRD_SIZE) {
+      fail("boot image too large");
+      return;
+   }
+
+   if (ddr_map_reserve("kernel", DEF_LINUX_ADDR, k_len, 0U) != 0 ||
+       (s_len != 0U &&
+        ddr_map_reserve("dtb", DEF_DTB_ADDR, s_len, 0U) != 0) ||
+       (r_len != 0U &&
+        ddr_map_reserve("initrd", DEF_INITRD_ADDR, r_len, 0U) != 0)) {
+      fail("boot image overlaps a DDR region");
+      return;
+   }
+
+   /* The kernel and initrd are copied while the DTB is put in place. */
+   static struct dma_req cp_kernel, cp_initrd;
+   copy_start(&cp_kernel, DEF_LINUX_ADDR, k_off, k_len);
+   copy_start(&cp_initrd, DEF_INITRD_ADDR, r_off, r_len);
+   const char *err = NULL;
+   if (s_len != 0U)
+      memcpy((void *)DEF_DTB_ADDR, dl_buf + s_off, s_len);
+   else if (load_dtb() != 0)
+      err = "no dtb";
+   if (err == NULL) {
+      (void)dtb_claim();
+      if (r_len != 0U &&
+          dtb_patch_initrd(DEF_INITRD_ADDR, DEF_INITRD_ADDR + r_len) != 0)
+         err = "cannot patch dtb";
+   }
+   copy_wait(&cp_kernel);
+   copy_wait(&cp_initrd);
+   if (err != NULL) {
+      fail(err);
+      return;
+   }
+
+   okay_and_detach();
+   boot_jump(1, DEF_LINUX_ADDR, 0, 0);
+}
+
+/* Returns 1 if a download data phase was started instead of a response. */
+static int handle(const char *c)
+{
+   my_printf("fastboot: %s\r\n", c);
+
+   if (strncmp(c, "getvar:", 7) == 0) {
+      getvar(c + 7);
+   } else if (strncmp(c, "download:", 9) == 0) {
+      return download(c + 9);
+   } else if (strncmp(c, "flash:", 6) == 0) {
+      flash(c + 6);
+   } else if (strncmp(c, "erase:", 6) == 0) {
+      erase(c + 6);
+   } else if (strcmp(c, "boot") == 0) {
+      boot();
+   } else if (strcmp(c, "continue") == 0) {
+      /* Stay on the bus until the images check out, so that a bad one can
+       * be flashed again right away. */
+#ifdef NAND_FLASH
+      const int loaded = fmc_load_images(NULL);
+#else
+      const int loaded = sd_load_images(NULL);
+#endif
+      if (loaded != 0) {
+         fail("boot images bad or missing");
+         return 0;
+      }
+      okay_and_detach();
+      boot_jump(1, DEF_LINUX_ADDR, 0, 0);
+   } else if (strcmp(c, "reboot") == 0 ||
+              strcmp(c, "reboot-bootloader") == 0) {
+      okay_and_detach();
+      warm_reset();
+   } else {
+      fail("unknown command");
+   }
+   return 0;
+}
+
+void usb_fastboot_poll(void)
+{
+   if (dl_done) {
+      dl_done = 0U;
+      if (dl_received < dl_size) {
+         fail("short download");
+      } else {
+         dl_len = dl_size;
+         my_printf("fastboot: received %lu bytes, crc32 %08lx\r\n",
+                   (unsigned long)dl_len, (unsigned long)crc32(dl_buf, dl_len));
+         okay("");
+      }
+      IRQ_Disable(OTG_IRQn);
+      recv_cmd();
+      IRQ_Enable(OTG_IRQn);
+      return;
+   }
+
+   if (!cmd_pending)
+      return;
+
+   char c[FB_CMD_LEN + 1U];
+   memcpy(c, cmd_buf, sizeof(c));
+   cmd_pending = 0U;
+   if (handle(c) == 0) {
+      IRQ_Disable(OTG_IRQn);
+      recv_cmd();
+      IRQ_Enable(OTG_IRQn);
+   }
+}
+
+#endif // FASTBOOT
+
+// end file usb_fastboot.c
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file usb_fastboot.h
+ * @brief Android fastboot function of the composite USB device
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * usb_msc.c owns the PCD and the descriptors and forwards the fastboot
+ * endpoint completions here.  The interrupt side only collects command
+ * packets and streams `download` payloads into DDR; commands are executed,
+ * and responses sent, from usb_fastboot_poll() in the main loop.
+ */
+
+#ifndef USB_FASTBOOT_H
+#define USB_FASTBOOT_H
+
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_pcd.h"
+#include <stdint.h>
+
+/* Interface and endpoints follow whatever else the composite device has. */
+#ifdef USB_ACM
+#define FB_IF     3U
+#define FB_IN_EP  0x84U
+#define FB_OUT_EP 0x04U
+#else
+#define FB_IF     1U
+#define FB_IN_EP  0x82U
+#define FB_OUT_EP 0x02U
+#endif
+
+/* Open the endpoints (SET_CONFIGURATION) / abandon any transfer (bus
+ * reset). */
+void usb_fastboot_start(PCD_HandleTypeDef *pcd);
+void usb_fastboot_stop(void);
+
+/* Endpoint completion callbacks. */
+void usb_fastboot_data_in(void);
+void usb_fastboot_data_out(uint32_t len);
+
+/* Execute a pending command. */
+void usb_fastboot_poll(void);
+
+#endif // USB_FASTBOOT_H
+
+// end file usb_fastboot.h
@@ -21,6 +21,8 @@
 #include "stm32mp13xx_hal_pcd_ex.h"
 #include "stm32mp13xx_hal_rcc.h"
 #include "stm32mp13xx_hal_rcc_ex.h"
+#include "usb_acm.h"
+#include "usb_fastboot.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
@@ -40,6 +42,19 @@
 #define MSC_BLOCK_SIZE  512U
 #define MSC_BURST_BLOCKS 128U
 
+/* Fastboot on top of ACM needs endpoint 4.  Its IN endpoint only ever
+ * sends responses of at most 64 bytes, so it gets a small TX FIFO. */
+#if defined(FASTBOOT) && defined(USB_ACM)
+#define USB_NUM_EPS 5U
+#else
+#define USB_NUM_EPS 4U
+#endif
+#ifdef FASTBOOT
+#define FB_FIFO_WORDS 0x20U
+#else
+#define FB_FIFO_WORDS 0U
+#endif
+
 #define USB_REQ_GET_STATUS        0x00U
 #define USB_REQ_CLEAR_FEATURE     0x01U
 #define USB_REQ_SET_FEATURE       0x03U
@@ -109,36 +124,78 @@ enum bot_state {
 static PCD_HandleTypeDef hpcd;
 static uint8_t configured;
 static uint8_t ep0_wait_status_out;
+#ifdef USB_ACM
+static uint8_t ep0_wait_data_out;
+#endif
 static enum bot_state bot_state;
 static struct cbw cbw;
 static struct csw csw;
+static uint32_t data_lun;
 static uint32_t data_lba;
 static uint32_t data_blocks;
 static uint32_t data_sent;
 static uint8_t *data_ptr;
 static uint32_t data_len;
-static uint8_t sense_key;
-static uint8_t sense_asc;
-static uint8_t sense_ascq;
+/* Set when a data phase waits for its LUN to page data in; resumed by
+ * usb_msc_poll() in thread context. */
+static volatile uint8_t fault_pending;
 
 static uint8_t ep0_status[2] __attribute__((aligned(32)));
 static uint8_t cbw_buf[31] __attribute__((aligned(32)));
 static uint8_t csw_buf[13] __attribute__((aligned(32)));
-#ifndef NAND_FLASH
 static uint8_t block_buf[MSC_BLOCK_SIZE] __attribute__((aligned(32)));
-#endif
 static uint8_t ctrl_buf[64] __attribute__((aligned(32)));
 
+/* Optional functions of the composite device, after MSC on interface 0:
+ * CDC-ACM on interfaces 1-2, grouped by an interface association
+ * descriptor (hence device class EF/02/01), and fastboot on the next
+ * interface. */
+#ifdef USB_ACM
+#define DEV_CLASS    0xEFU, 0x02U, 0x01U
+#define CFG_ACM_LEN  66U
+#define CFG_ACM_IFS  2U
+#else
+#define DEV_CLASS    0U, 0U, 0U
+#define CFG_ACM_LEN  0U
+#define CFG_ACM_IFS  0U
+#endif
+#ifdef FASTBOOT
+#define CFG_FB_LEN   23U
+#define CFG_FB_IFS   1U
+#else
+#define CFG_FB_LEN   0U
+#define CFG_FB_IFS   0U
+#endif
+#define CFG_TOTAL_LEN (32U + CFG_ACM_LEN + CFG_FB_LEN)
+#define CFG_NUM_IFS   (1U + CFG_ACM_IFS + CFG_FB_IFS)
+
 static const uint8_t dev_desc[] = {
-    18, 1, 0x00, 0x02, 0, 0, 0, EP0_SIZE, 0x83, 0x04, 0x1d, 0x57, 0x00, 0x01,
-    1,  2, 3,    1,
+    18, 1, 0x00, 0x02, DEV_CLASS, EP0_SIZE, 0x83, 0x04, 0x1d, 0x57, 0x00,
+    0x01, 1, 2, 3, 1,
 };
 
 static const uint8_t cfg_desc[] = {
-    9,  2, 32, 0, 1, 1, 0, 0x80, 50,
+    9,  2, CFG_TOTAL_LEN, 0, CFG_NUM_IFS, 1, 0, 0x80, 50,
     9,  4, 0,  0, 2, 8, 6, 0x50, 0,
     7,  5, MSC_IN_EP,  2, MSC_PACKET_SIZE_LO, MSC_PACKET_SIZE_HI, 0,
     7,  5, MSC_OUT_EP, 2, MSC_PACKET_SIZE_LO, MSC_PACKET_SIZE_HI, 0,
+#ifdef USB_ACM
+    8,  0x0B, ACM_COMM_IF, 2, 2, 2, 1, 0,
+    9,  4, ACM_COMM_IF, 0, 1, 2, 2, 1, 0,
+    5,  0x24, 0x00, 0x10, 0x01,
+    5,  0x24, 0x01, 0x00, ACM_DATA_IF,
+    4,  0x24, 0x02, 0x02,
+    5,  0x24, 0x06, ACM_COMM_IF, ACM_DATA_IF,
+    7,  5, ACM_NOTIFY_EP, 3, 8, 0, 8,
+    9,  4, ACM_DATA_IF, 0, 2, 0x0A, 0, 0, 0,
+    7,  5, ACM_DATA_OUT_EP, 2, MSC_PACKET_SIZE_LO, MSC_PACKET_SIZE_HI, 0,
+    7,  5, ACM_DATA_IN_EP,  2, MSC_PACKET_SIZE_LO, MSC_PACKET_SIZE_HI, 0,
+#endif
+#ifdef FASTBOOT
+    9,  4, FB_IF, 0, 2, 0xFF, 0x42, 0x03, 0,
+    7,  5, FB_OUT_EP, 2, MSC_PACKET_SIZE_LO, MSC_PACKET_SIZE_HI, 0,
+    7,  5, FB_IN_EP,  2, MSC_PACKET_SIZE_LO, MSC_PACKET_SIZE_HI, 0,
+#endif
 };
 
 static const uint8_t qual_desc[] = {
@@ -179,34 +236,91 @@ static void wr32be(uint8_t *p, uint32_t v)
    p[3] = (uint8_t)v;
 }
 
-static void set_sense(uint8_t key, uint8_t asc, uint8_t ascq)
+/* Block device behind one LUN.  Memory-backed devices set `base` to the DDR
+ * address of LBA 0 and are transferred in bursts straight from/to DDR; the
+ * others go through block_buf one sector at a time with read()/write().
+ * claim() (optional) vetoes a burst that is not in DDR yet, and fault()
+ * brings it in from thread context; written() (optional) is told about every
+ * completed host write. */
+struct msc_lun {
+   const char *product; /* INQUIRY product id, exactly 16 characters */
+   uint32_t (*blocks)(void);
+   int (*read)(uint32_t lba, uint8_t *buf);
+   int (*write)(uint32_t lba, const uint8_t *buf);
+   uint32_t base;
+   int (*claim)(uint32_t lba, uint32_t n, int write);
+   int (*fault)(uint32_t lba, uint32_t n);
+   void (*written)(uint32_t lba, uint32_t n);
+};
+
+#ifndef NAND_FLASH
+static int sd_lun_read(uint32_t lba, uint8_t *buf)
 {
-   sense_key  = key;
-   sense_asc  = asc;
-   sense_ascq = ascq;
+   return sd_read_blocks(lba, buf, 1U);
 }
 
-static uint32_t storage_blocks(void)
+static int sd_lun_write(uint32_t lba, const uint8_t *buf)
 {
-#ifndef NAND_FLASH
-   return sd_block_count();
+   return sd_write_blocks(lba, buf, 1U);
+}
 #else
+static uint32_t nand_lun_blocks(void)
+{
    return FMC_DDR_BUF_SIZE / MSC_BLOCK_SIZE;
-#endif
 }
 
-#ifndef NAND_FLASH
-static int storage_read(uint32_t lba, uint8_t *buf)
+static void nand_lun_written(uint32_t lba, uint32_t n)
 {
-   return sd_read_blocks(lba, buf, 1U);
+   fmc_note_usb_write(lba, (uint16_t)n);
 }
+#endif
 
-static int storage_write(uint32_t lba, const uint8_t *buf)
+#ifdef RAM_DISK
+static uint32_t ram_lun_blocks(void)
 {
-   return sd_write_blocks(lba, buf, 1U);
+   return DEF_RAMDISK_SIZE / MSC_BLOCK_SIZE;
 }
 #endif
 
+static const struct msc_lun luns[] = {
+#ifndef NAND_FLASH
+    {
+     .product = "STM32MP135 SD   ",
+     .blocks  = sd_block_count,
+     .read    = sd_lun_read,
+     .write   = sd_lun_write,
+     },
+#else
+    {
+     .product = "STM32MP135 NAND ",
+     .blocks  = nand_lun_blocks,
+     .base    = FMC_DDR_BUF_ADDR,
+     .claim   = fmc_cache_claim,
+     .fault   = fmc_cache_fault,
+     .written = nand_lun_written,
+     },
+#endif
+#ifdef RAM_DISK
+    {
+     .product = "STM32MP135 RAM  ",
+     .blocks  = ram_lun_blocks,
+     .base    = DEF_RAMDISK_ADDR,
+     },
+#endif
+};
+
+#define MSC_NUM_LUNS (sizeof(luns) / sizeof(luns[0]))
+
+/* Fixed-format sense data (key, ASC, ASCQ) of the last command, per LUN. */
+static uint8_t sense[MSC_NUM_LUNS][3];
+
+static void set_sense(uint8_t key, uint8_t asc, uint8_t ascq)
+{
+   sense[data_lun][0] = key;
+   sense[data_lun][1] = asc;
+   sense[data_lun][2] = ascq;
+}
+
 static void ep0_send(const uint8_t *buf, uint16_t len, uint16_t req_len)
 {
    if (len > req_len)
@@ -318,50 +432,64 @@ static void data_in_start(uint8_t *buf, uint32_t len)
 
 static void data_in_next_block(void)
 {
+   const struct msc_lun *l = &luns[data_lun];
    if (data_blocks == 0U) {
       send_csw(0U);
       return;
    }
-#ifndef NAND_FLASH
-   if (storage_read(data_lba, block_buf) != 0) {
-      set_sense(0x03U, 0x11U, 0x00U);
-      send_csw(1U);
+   if (l->base == 0U) {
+      if (l->read(data_lba, block_buf) != 0) {
+         set_sense(0x03U, 0x11U, 0x00U);
+         send_csw(1U);
+         return;
+      }
+      data_lba++;
+      data_blocks--;
+      csw.residue = (csw.residue >= MSC_BLOCK_SIZE)
+                        ? csw.residue - MSC_BLOCK_SIZE
+                        : 0U;
+      L1C_CleanDCacheAll();
+      (void)HAL_PCD_EP_Transmit(&hpcd, MSC_IN_EP, block_buf, MSC_BLOCK_SIZE);
       return;
    }
-   data_lba++;
-   data_blocks--;
-   csw.residue = (csw.residue >= MSC_BLOCK_SIZE) ? csw.residue - MSC_BLOCK_SIZE
-                                                 : 0U;
-   L1C_CleanDCacheAll();
-   (void)HAL_PCD_EP_Transmit(&hpcd, MSC_IN_EP, block_buf, MSC_BLOCK_SIZE);
-#else
+
    uint32_t blocks = data_blocks;
    if (blocks > MSC_BURST_BLOCKS)
       blocks = MSC_BURST_BLOCKS;
+   if (l->claim != NULL && !l->claim(data_lba, blocks, 0)) {
+      fault_pending = 1U;
+      return;
+   }
    uint32_t len = blocks * MSC_BLOCK_SIZE;
-   uint8_t *buf = (uint8_t *)(FMC_DDR_BUF_ADDR + data_lba * MSC_BLOCK_SIZE);
+   uint8_t *buf = (uint8_t *)(l->base + data_lba * MSC_BLOCK_SIZE);
    data_lba += blocks;
    data_blocks -= blocks;
    csw.residue = (csw.residue >= len) ? csw.residue - len : 0U;
    L1C_CleanDCacheAll();
    (void)HAL_PCD_EP_Transmit(&hpcd, MSC_IN_EP, buf, len);
-#endif
 }
 
 static void data_out_next_block(void)
 {
-#ifndef NAND_FLASH
-   L1C_CleanInvalidateDCacheAll();
-   (void)HAL_PCD_EP_Receive(&hpcd, MSC_OUT_EP, block_buf, MSC_BLOCK_SIZE);
-#else
+   const struct msc_lun *l = &luns[data_lun];
+   if (l->base == 0U) {
+      data_len = MSC_BLOCK_SIZE;
+      L1C_CleanInvalidateDCacheAll();
+      (void)HAL_PCD_EP_Receive(&hpcd, MSC_OUT_EP, block_buf, MSC_BLOCK_SIZE);
+      return;
+   }
+
    uint32_t blocks = data_blocks;
    if (blocks > MSC_BURST_BLOCKS)
       blocks = MSC_BURST_BLOCKS;
+   if (l->claim != NULL && !l->claim(data_lba, blocks, 1)) {
+      fault_pending = 1U;
+      return;
+   }
    data_len = blocks * MSC_BLOCK_SIZE;
-   data_ptr = (uint8_t *)(FMC_DDR_BUF_ADDR + data_lba * MSC_BLOCK_SIZE);
+   data_ptr = (uint8_t *)(l->base + data_lba * MSC_BLOCK_SIZE);
    L1C_CleanInvalidateDCacheAll();
    (void)HAL_PCD_EP_Receive(&hpcd, MSC_OUT_EP, data_ptr, data_len);
-#endif
 }
 
 static void scsi_good_no_data(void)
@@ -389,11 +517,19 @@ static void handle_cbw(void)
       return;
    }
 
-   uint8_t op       = cbw.cb[0];
-   uint32_t blocks  = 0U;
-   uint32_t lba     = 0U;
-   uint32_t capacity = storage_blocks();
-   set_sense(0U, 0U, 0U);
+   if (cbw.lun >= MSC_NUM_LUNS) {
+      scsi_fail();
+      return;
+   }
+
+   uint8_t op        = cbw.cb[0];
+   uint32_t blocks   = 0U;
+   uint32_t lba      = 0U;
+   data_lun          = cbw.lun;
+   uint32_t capacity = luns[data_lun].blocks();
+   /* Sense data describes the previous command until it is requested. */
+   if (op != SCSI_REQUEST_SENSE)
+      set_sense(0U, 0U, 0U);
    memset(ctrl_buf, 0, sizeof(ctrl_buf));
 
    switch (op) {
@@ -410,7 +546,7 @@ static void handle_cbw(void)
          ctrl_buf[3] = 0x02U;
          ctrl_buf[4] = 31U;
          memcpy(&ctrl_buf[8], "SRS     ", 8);
-         memcpy(&ctrl_buf[16], "STM32MP135 MSC   ", 16);
+         memcpy(&ctrl_buf[16], luns[data_lun].product, 16);
          memcpy(&ctrl_buf[32], "0001", 4);
          csw.residue = (cbw.data_len > 36U) ? cbw.data_len - 36U : 0U;
          data_in_start(ctrl_buf, 36U);
@@ -418,10 +554,11 @@ static void handle_cbw(void)
 
       case SCSI_REQUEST_SENSE:
          ctrl_buf[0]  = 0x70U;
-         ctrl_buf[2]  = sense_key;
+         ctrl_buf[2]  = sense[data_lun][0];
          ctrl_buf[7]  = 10U;
-         ctrl_buf[12] = sense_asc;
-         ctrl_buf[13] = sense_ascq;
+         ctrl_buf[12] = sense[data_lun][1];
+         ctrl_buf[13] = sense[data_lun][2];
+         set_sense(0U, 0U, 0U);
          csw.residue  = (cbw.data_len > 18U) ? cbw.data_len - 18U : 0U;
          data_in_start(ctrl_buf, 18U);
          break;
@@ -504,10 +641,30 @@ static void handle_setup(void)
    const uint8_t *buf = NULL;
    uint16_t len       = 0U;
 
+#ifdef USB_ACM
+   if ((setup.bm_request_type & 0x7FU) == 0x21U &&
+       setup.w_index == ACM_COMM_IF) {
+      if (setup.b_request == ACM_REQ_SET_LINE_CODING) {
+         ep0_wait_data_out = 1U;
+         (void)HAL_PCD_EP_Receive(&hpcd, 0x00U, usb_acm_line_coding(), 7U);
+      } else if (setup.b_request == ACM_REQ_GET_LINE_CODING) {
+         ep0_send(usb_acm_line_coding(), 7U, setup.w_length);
+      } else if (setup.b_request == ACM_REQ_SET_CONTROL_LINE_STATE) {
+         usb_acm_line_state(setup.w_value);
+         ep0_zlp();
+      } else if (setup.b_request == ACM_REQ_SEND_BREAK) {
+         ep0_zlp();
+      } else {
+         ep0_stall();
+      }
+      return;
+   }
+#endif
+
    if ((setup.bm_request_type & 0x60U) == 0x20U) {
       if (setup.b_request == MSC_REQ_GET_MAX_LUN &&
           (setup.bm_request_type & 0x80U) != 0U) {
-         ctrl_buf[0] = 0U;
+         ctrl_buf[0] = (uint8_t)(MSC_NUM_LUNS - 1U);
          ep0_send(ctrl_buf, 1U, setup.w_length);
       } else if (setup.b_request == MSC_REQ_RESET &&
                  (setup.bm_request_type & 0x80U) == 0U) {
@@ -552,8 +709,15 @@ static void handle_setup(void)
 
       case USB_REQ_SET_CONFIGURATION:
          configured = (uint8_t)setup.w_value;
-         if (configured != 0U)
+         if (configured != 0U) {
             open_msc_eps();
+#ifdef USB_ACM
+            usb_acm_start(&hpcd);
+#endif
+#ifdef FASTBOOT
+            usb_fastboot_start(&hpcd);
+#endif
+         }
          ep0_zlp();
          break;
 
@@ -639,6 +803,14 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *ph)
    (void)ph;
    configured      = 0U;
    bot_state       = BOT_WAIT_CBW;
+   fault_pending   = 0U;
+#ifdef USB_ACM
+   ep0_wait_data_out = 0U;
+   usb_acm_stop();
+#endif
+#ifdef FASTBOOT
+   usb_fastboot_stop();
+#endif
    (void)HAL_PCD_EP_Open(&hpcd, 0x00U, EP0_SIZE, EP_TYPE_CTRL);
    (void)HAL_PCD_EP_Open(&hpcd, 0x80U, EP0_SIZE, EP_TYPE_CTRL);
 }
@@ -663,6 +835,18 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *ph, uint8_t epnum)
       }
       return;
    }
+#ifdef USB_ACM
+   if (epnum == (ACM_DATA_IN_EP & 0x7FU)) {
+      usb_acm_data_in();
+      return;
+   }
+#endif
+#ifdef FASTBOOT
+   if (epnum == (FB_IN_EP & 0x7FU)) {
+      usb_fastboot_data_in();
+      return;
+   }
+#endif
    if (epnum != (MSC_IN_EP & 0x7FU))
       return;
 
@@ -678,6 +862,23 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *ph, uint8_t epnum)
 void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *ph, uint8_t epnum)
 {
    (void)ph;
+#ifdef USB_ACM
+   if (epnum == 0U && ep0_wait_data_out != 0U) {
+      ep0_wait_data_out = 0U;
+      ep0_zlp();
+      return;
+   }
+   if (epnum == ACM_DATA_OUT_EP) {
+      usb_acm_data_out(HAL_PCD_EP_GetRxCount(&hpcd, ACM_DATA_OUT_EP));
+      return;
+   }
+#endif
+#ifdef FASTBOOT
+   if (epnum == FB_OUT_EP) {
+      usb_fastboot_data_out(HAL_PCD_EP_GetRxCount(&hpcd, FB_OUT_EP));
+      return;
+   }
+#endif
    if (epnum != (MSC_OUT_EP & 0x7FU))
       return;
 
@@ -686,32 +887,23 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *ph, uint8_t epnum)
       L1C_CleanInvalidateDCacheAll();
       handle_cbw();
    } else if (bot_state == BOT_DATA_OUT && rx != 0U) {
+      const struct msc_lun *l = &luns[data_lun];
       L1C_CleanInvalidateDCacheAll();
-#ifndef NAND_FLASH
-      if (rx != MSC_BLOCK_SIZE) {
+      if (rx != data_len || data_len == 0U) {
          bot_recv_cbw();
          return;
       }
-      if (storage_write(data_lba, block_buf) != 0) {
+      uint32_t blocks = data_len / MSC_BLOCK_SIZE;
+      if (l->base == 0U && l->write(data_lba, block_buf) != 0) {
          set_sense(0x03U, 0x0CU, 0x00U);
          send_csw(1U);
          return;
       }
-      data_lba++;
-      data_blocks--;
-      csw.residue = (csw.residue >= MSC_BLOCK_SIZE) ? csw.residue - MSC_BLOCK_SIZE
-                                                    : 0U;
-#else
-      if (rx != data_len || data_len == 0U) {
-         bot_recv_cbw();
-         return;
-      }
-      uint32_t blocks = data_len / MSC_BLOCK_SIZE;
-      fmc_note_usb_write(data_lba, (uint16_t)blocks);
+      if (l->written != NULL)
+         l->written(data_lba, blocks);
       data_lba += blocks;
       data_blocks -= blocks;
       csw.residue = (csw.residue >= data_len) ? csw.residue - data_len : 0U;
-#endif
       if (data_blocks == 0U) {
          send_csw(0U);
       } else {
@@ -725,7 +917,7 @@ void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *ph, uint8_t epnum)
 void usb_msc_init(void)
 {
    hpcd.Instance = USB_OTG_HS;
-   hpcd.Init.dev_endpoints = 4U;
+   hpcd.Init.dev_endpoints = USB_NUM_EPS;
    hpcd.Init.speed = PCD_SPEED_HIGH;
    hpcd.Init.dma_enable = 0U;
    hpcd.Init.phy_itface = PCD_PHY_UTMI;
@@ -745,8 +937,49 @@ void usb_msc_init(void)
       ERROR("USB PCD init");
    (void)HAL_PCDEx_SetRxFiFo(&hpcd, 0x200U);
    (void)HAL_PCDEx_SetTxFiFo(&hpcd, 0U, 0x40U);
-   (void)HAL_PCDEx_SetTxFiFo(&hpcd, 1U, 0x200U);
+   /* The total FIFO RAM is the same in every configuration; MSC IN gives
+    * up whatever the other functions need. */
+#ifndef USB_ACM
+   (void)HAL_PCDEx_SetTxFiFo(&hpcd, 1U, 0x200U - FB_FIFO_WORDS);
+#else
+   (void)HAL_PCDEx_SetTxFiFo(&hpcd, 1U, 0x170U - FB_FIFO_WORDS);
+   (void)HAL_PCDEx_SetTxFiFo(&hpcd, 2U, 0x80U);
+   (void)HAL_PCDEx_SetTxFiFo(&hpcd, 3U, 0x10U);
+#endif
+#ifdef FASTBOOT
+   (void)HAL_PCDEx_SetTxFiFo(&hpcd, FB_IN_EP & 0x7FU, FB_FIFO_WORDS);
+#endif
    HAL_Delay(250U);
    if (HAL_PCD_Start(&hpcd) != HAL_OK)
       ERROR("USB PCD start");
 }
+
+void usb_msc_poll(void)
+{
+#ifdef USB_ACM
+   usb_acm_poll();
+#endif
+#ifdef FASTBOOT
+   usb_fastboot_poll();
+#endif
+   if (!fault_pending)
+      return;
+
+   uint32_t blocks = data_blocks;
+   if (blocks > MSC_BURST_BLOCKS)
+      blocks = MSC_BURST_BLOCKS;
+   const int err = luns[data_lun].fault(data_lba, blocks);
+
+   /* Resume the data phase as if from the endpoint callback. */
+   IRQ_Disable(OTG_IRQn);
+   fault_pending = 0U;
+   if (err != 0 && (bot_state == BOT_DATA_IN || bot_state == BOT_DATA_OUT)) {
+      set_sense(0x03U, (bot_state == BOT_DATA_IN) ? 0x11U : 0x0CU, 0x00U);
+      send_csw(1U);
+   } else if (bot_state == BOT_DATA_IN) {
+      data_in_next_block();
+   } else if (bot_state == BOT_DATA_OUT) {
+      data_out_next_block();
+   }
+   IRQ_Enable(OTG_IRQn);
+}
@@ -11,4 +11,8 @@
 
 void usb_msc_init(void);
 
+/* Finish work the USB interrupt deferred to thread context (NAND page-in,
+ * ACM output still waiting for a line end). */
+void usb_msc_poll(void);
+
 #endif // USB_MSC_H
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file warm.c
+ * @brief Warm reboot: keep the verified kernel in DDR across a reset
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "warm.h"
+#include "console.h"
+#include "crc.h"
+#include "defaults.h"
+#include "hash.h"
+#include "manifest.h"
+#include "printf.h"
+#include "stm32mp135fxx_ca7.h"
+#include "stm32mp13xx_hal.h"
+#include "stm32mp13xx_hal_ddr.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define WARM_MAGIC         0x5741524DU /* "WARM" */
+#define WARM_TRAINING_SIZE 64U /* DDR_TRAINING_AREA_SIZE in the DDR HAL */
+
+/* Kept in backup SRAM at DEF_BKP_WARM_ADDR. */
+struct warm_rec {
+   uint32_t magic;
+   uint32_t sleeping; /* warm_reset() left DDR in self-refresh */
+   uint32_t zdata;    /* DDR PHY I/O calibration at that point */
+   uint32_t addr;     /* where image was verified */
+   manifest_entry_t image;
+   uint32_t crc; /* CRC-32 of all preceding bytes */
+};
+
+#ifdef WARM_BOOT
+
+static struct warm_rec *const rec = (struct warm_rec *)DEF_BKP_WARM_ADDR;
+static bool retained;
+
+static bool rec_valid(void)
+{
+   return rec->magic == WARM_MAGIC &&
+          crc32(rec, offsetof(struct warm_rec, crc)) == rec->crc;
+}
+
+static void rec_seal(void)
+{
+   rec->magic = WARM_MAGIC;
+   rec->crc   = crc32(rec, offsetof(struct warm_rec, crc));
+}
+
+bool warm_ddr_sleeping(uint32_t *zdata)
+{
+   if (!rec_valid() || rec->sleeping == 0U)
+      return false;
+   *zdata = rec->zdata;
+   return true;
+}
+
+void warm_ddr_up(bool kept)
+{
+   retained = kept;
+   if (rec_valid()) {
+      rec->sleeping = 0U;
+      rec_seal();
+   }
+}
+
+int warm_check(uint32_t addr, const manifest_entry_t *e)
+{
+   if (!retained || !rec_valid() || rec->addr != addr ||
+       memcmp(&rec->image, e, sizeof(*e)) != 0)
+      return 0;
+
+   uint8_t d[HASH_SHA256_LEN];
+   if (hash_sha256((const void *)addr, e->size, d) != 0 ||
+       memcmp(d, e->sha256, sizeof(d)) != 0) {
+      my_printf("warm: %.16s changed in DDR, reloading\r\n", e->name);
+      return 0;
+   }
+   my_printf("warm: %.16s still in DDR, sha256 ok\r\n", e->name);
+   return 1;
+}
+
+void warm_note(uint32_t addr, const manifest_entry_t *e)
+{
+   rec->sleeping = 0U;
+   rec->zdata    = 0U;
+   rec->addr     = addr;
+   rec->image    = *e;
+   rec_seal();
+}
+
+#else
+
+bool warm_ddr_sleeping(uint32_t *zdata)
+{
+   (void)zdata;
+   return false;
+}
+
+void warm_ddr_up(bool kept)
+{
+   (void)kept;
+}
+
+int warm_check(uint32_t addr, const manifest_entry_t *e)
+{
+   (void)addr;
+   (void)e;
+   return 0;
+}
+
+void warm_note(uint32_t addr, const manifest_entry_t *e)
+{
+   (void)addr;
+   (void)e;
+}
+
+#endif // WARM_BOOT
+
+void warm_reset(void)
+{
+   uart_flush();
+   __asm volatile("cpsid if\n" ::: "memory");
+
+#ifdef WARM_BOOT
+   if (rec_valid()) {
+      /* What is to survive must be in DDR, and nothing may reach DDR
+       * (not even a table walk or a speculative line fill) once it
+       * sleeps. */
+      MMU_InvalidateTLB();
+      MMU_Disable();
+      L1C_CleanDCacheAll();
+      L1C_InvalidateICacheAll();
+      L1C_DisableCaches();
+
+      /* HAL_DDR_Init() puts this back after its post-wakeup test. */
+      memcpy((void *)DEF_BKP_ADDR, (const void *)DEF_DDR_BASE,
+             WARM_TRAINING_SIZE);
+      if (HAL_DDR_SR_Entry(&rec->zdata) == HAL_OK) {
+         rec->sleeping = 1U;
+         rec_seal();
+      }
+   }
+#endif
+
+   __DSB();
+   RCC->MP_GRSTCSETR = RCC_MP_GRSTCSETR_MPSYSRST;
+   while (1)
+      __WFE();
+}
+
+// end file warm.c
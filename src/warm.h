@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file warm.h
+ * @brief Warm reboot: keep the verified kernel in DDR across a reset
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * With WARM_BOOT defined, warm_reset() puts DDR into self-refresh before
+ * the system reset, and a record in backup SRAM remembers where the last
+ * verified kernel was loaded and its SHA-256.  On the next boot ddr_init()
+ * brings DDR back out of self-refresh, and the loaders skip reading the
+ * kernel from storage if the manifest still names the same image and DDR
+ * still hashes to it.  Anything else (a power cycle, a reset from Linux,
+ * a newly flashed kernel) falls back to the normal load.
+ *
+ * Without WARM_BOOT, warm_reset() is a plain system reset and the rest
+ * does nothing.
+ */
+
+#ifndef WARM_H
+#define WARM_H
+
+#include "manifest.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* For ddr_init(): true (with the saved I/O calibration in *zdata) if DDR
+ * was left in self-refresh by warm_reset(). */
+bool warm_ddr_sleeping(uint32_t *zdata);
+
+/* For ddr_init(): whether DDR came out of self-refresh with its contents. */
+void warm_ddr_up(bool retained);
+
+/* 1 if the image e describes is still at addr from before the reset. */
+int warm_check(uint32_t addr, const manifest_entry_t *e);
+
+/* Remember that the image e describes was verified at addr. */
+void warm_note(uint32_t addr, const manifest_entry_t *e);
+
+/* Reset the system, keeping DDR in self-refresh across it if enabled. */
+void warm_reset(void) __attribute__((noreturn));
+
+#endif // WARM_H
+
+// end file warm.h
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ymodem.c
+ * @brief YMODEM-1K receiver into DDR over the console
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ */
+
+#include "ymodem.h"
+#include <stdint.h>
+
+#include "board.h"
+#include "console.h"
+#include "crc.h"
+#include "defaults.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+
+#define SOH      0x01U
+#define STX      0x02U
+#define EOT      0x04U
+#define ACK      0x06U
+#define NAK      0x15U
+#define CAN      0x18U
+#define CTRL_C   0x03U
+#define CRC_MODE 'C'
+
+#define YM_BLOCK    1024U
+#define YM_START_S  60U   /* ask for the header this many times, 1 s apart */
+#define YM_BYTE_MS  1000U /* longest gap inside a block */
+#define YM_QUIET_MS 50U   /* line idle this long after a bad block: resync */
+#define YM_RETRIES  10U
+#define YM_NAME_LEN 64U
+
+enum blk_result {
+   BLK_OK,
+   BLK_EOT,
+   BLK_BAD,
+   BLK_TIMEOUT,
+   BLK_CANCEL,
+};
+
+enum ym_error {
+   YM_ERR_TIMEOUT   = -1,
+   YM_ERR_CANCELLED = -2,
+   YM_ERR_TOO_BIG   = -3,
+   YM_ERR_SYNC      = -4,
+};
+
+/* Header blocks, and blocks that are not the next one expected. */
+static uint8_t scratch[YM_BLOCK];
+static char name[YM_NAME_LEN];
+static uint32_t t_start; /* header received */
+
+static int get_byte(uint32_t timeout_ms)
+{
+   const uint32_t t0 = HAL_GetTick();
+   while (console_rx_empty())
+      if (HAL_GetTick() - t0 >= timeout_ms)
+         return -1;
+   return (uint8_t)console_rx_get();
+}
+
+/* Protocol bytes go out the same way as console output, so this works over
+ * the UART and the USB ACM console alike. */
+static void put_byte(uint8_t c)
+{
+   printf_get_output()((char)c);
+}
+
+static void cancel(void)
+{
+   for (int i = 0; i < 3; i++)
+      put_byte(CAN);
+}
+
+/* Throw away input until the line has been quiet for a moment. */
+static void purge(void)
+{
+   while (get_byte(YM_QUIET_MS) >= 0) {
+   }
+}
+
+/* CRC-16/XMODEM: polynomial 0x1021, initial value 0. */
+static uint16_t crc16_byte(uint16_t crc, uint8_t b)
+{
+   crc ^= (uint16_t)((uint16_t)b << 8);
+   for (int i = 0; i < 8; i++)
+      crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U)
+                            : (uint16_t)(crc << 1);
+   return crc;
+}
+
+/* Receive one block, waiting up to timeout_ms for it to start.  If its
+ * number is expect, the first room bytes of the payload go to dst and the
+ * rest is only checked; otherwise it lands in the scratch buffer. */
+static enum blk_result get_block(uint8_t expect, uint8_t *dst, uint32_t room,
+                                 uint8_t *blk, uint32_t *len,
+                                 uint32_t timeout_ms)
+{
+   const int c = get_byte(timeout_ms);
+   if (c < 0)
+      return BLK_TIMEOUT;
+   if ((uint32_t)c == EOT)
+      return BLK_EOT;
+   if ((uint32_t)c == CTRL_C)
+      return BLK_CANCEL;
+   if ((uint32_t)c == CAN)
+      return ((uint32_t)get_byte(YM_BYTE_MS) == CAN) ? BLK_CANCEL : BLK_BAD;
+   if ((uint32_t)c != SOH && (uint32_t)c != STX)
+      return BLK_BAD;
+
+   const uint32_t n = ((uint32_t)c == STX) ? YM_BLOCK : 128U;
+   const int b      = get_byte(YM_BYTE_MS);
+   const int nb     = get_byte(YM_BYTE_MS);
+   if (b < 0 || nb < 0)
+      return BLK_TIMEOUT;
+   if ((b ^ nb) != 0xFF)
+      return BLK_BAD;
+   if ((uint8_t)b != expect) {
+      dst  = scratch;
+      room = YM_BLOCK;
+   }
+
+   uint16_t crc = 0U;
+   for (uint32_t i = 0; i < n; i++) {
+      const int d = get_byte(YM_BYTE_MS);
+      if (d < 0)
+         return BLK_TIMEOUT;
+      crc = crc16_byte(crc, (uint8_t)d);
+      if (i < room)
+         dst[i] = (uint8_t)d;
+   }
+   const int hi = get_byte(YM_BYTE_MS);
+   const int lo = get_byte(YM_BYTE_MS);
+   if (hi < 0 || lo < 0)
+      return BLK_TIMEOUT;
+   if ((uint16_t)((hi << 8) | lo) != crc)
+      return BLK_BAD;
+
+   *blk = (uint8_t)b;
+   *len = n;
+   return BLK_OK;
+}
+
+/* Header block: file name, NUL, decimal length, then fields we ignore.
+ * Returns 0 for the empty header that ends a batch. */
+static int parse_header(uint32_t *size)
+{
+   uint32_t i = 0;
+   for (; i < YM_BLOCK && scratch[i] != 0U; i++)
+      if (i < YM_NAME_LEN - 1U)
+         name[i] = (char)scratch[i];
+   name[(i < YM_NAME_LEN - 1U) ? i : YM_NAME_LEN - 1U] = '\0';
+   if (i == 0U)
+      return 0;
+
+   *size = 0U;
+   for (i++; i < YM_BLOCK && scratch[i] >= '0' && scratch[i] <= '9'; i++)
+      *size = *size * 10U + (scratch[i] - '0');
+   return 1;
+}
+
+/* Receive one file to dst.  Returns its length, or a negative ym_error. */
+static int32_t ymodem_receive(uint8_t *dst, uint32_t max)
+{
+   uint8_t blk  = 0U;
+   uint32_t n   = 0U;
+   uint32_t len = 0U;
+
+   /* Ask for the header block with CRCs until the sender starts. */
+   for (uint32_t tries = 0;; tries++) {
+      if (tries >= YM_START_S)
+         return YM_ERR_TIMEOUT;
+      put_byte(CRC_MODE);
+      const enum blk_result r = get_block(0U, scratch, YM_BLOCK, &blk, &n,
+                                          1000U);
+      if (r == BLK_CANCEL)
+         return YM_ERR_CANCELLED;
+      if (r == BLK_OK && blk == 0U) {
+         t_start = HAL_GetTick();
+         break;
+      }
+      if (r != BLK_TIMEOUT)
+         purge();
+   }
+   if (!parse_header(&len)) {
+      put_byte(ACK);
+      return 0;
+   }
+   if (len > max) {
+      cancel();
+      return YM_ERR_TOO_BIG;
+   }
+   put_byte(ACK);
+   put_byte(CRC_MODE);
+
+   uint8_t expect  = 1U;
+   uint32_t off    = 0U;
+   uint32_t errors = 0U;
+   while (1) {
+      const uint32_t room = (off < max) ? max - off : 0U;
+      const enum blk_result r =
+          get_block(expect, &dst[off], room, &blk, &n, YM_BYTE_MS * 10U);
+      if (r == BLK_OK && blk == expect) {
+         if (room == 0U) {
+            cancel();
+            return YM_ERR_TOO_BIG;
+         }
+         off += n;
+         expect++;
+         errors = 0U;
+         put_byte(ACK);
+      } else if (r == BLK_OK && blk == (uint8_t)(expect - 1U)) {
+         put_byte(ACK); /* our ACK was lost */
+      } else if (r == BLK_OK) {
+         cancel();
+         return YM_ERR_SYNC;
+      } else if (r == BLK_EOT) {
+         put_byte(ACK);
+         break;
+      } else if (r == BLK_CANCEL) {
+         return YM_ERR_CANCELLED;
+      } else if (++errors >= YM_RETRIES) {
+         cancel();
+         return YM_ERR_TIMEOUT;
+      } else {
+         purge();
+         put_byte(NAK);
+      }
+   }
+
+   /* Close the batch: the sender answers with an empty header. */
+   put_byte(CRC_MODE);
+   if (get_block(0U, scratch, YM_BLOCK, &blk, &n, YM_BYTE_MS) == BLK_OK)
+      put_byte(ACK);
+
+   if (len == 0U || len > off)
+      len = (off < max) ? off : max;
+   return (int32_t)len;
+}
+
+void ymodem_cmd(int argc, uint32_t addr, uint32_t max, uint32_t arg3)
+{
+   (void)arg3;
+   const uint32_t end = DEF_DDR_BASE + DDR_MEM_SIZE;
+   if (argc < 1)
+      addr = DEF_FASTBOOT_ADDR;
+   if (argc < 2)
+      max = DEF_FASTBOOT_SIZE;
+   if (addr < DEF_DDR_BASE || addr >= end || max > end - addr) {
+      my_printf("ymodem: 0x%08lx + 0x%lx is outside DDR\r\n",
+                (unsigned long)addr, (unsigned long)max);
+      return;
+   }
+
+   my_printf("ymodem: send a file now, up to %lu bytes to 0x%08lx\r\n",
+             (unsigned long)max, (unsigned long)addr);
+   uart_flush();
+   console_set_raw(1);
+   const int32_t len = ymodem_receive((uint8_t *)addr, max);
+   const uint32_t ms = HAL_GetTick() - t_start;
+   purge();
+   console_set_raw(0);
+
+   switch (len) {
+      case YM_ERR_TIMEOUT: my_printf("ymodem: timeout\r\n"); break;
+      case YM_ERR_CANCELLED: my_printf("ymodem: cancelled\r\n"); break;
+      case YM_ERR_TOO_BIG: my_printf("ymodem: file too large\r\n"); break;
+      case YM_ERR_SYNC: my_printf("ymodem: lost block sync\r\n"); break;
+      case 0: my_printf("ymodem: no file\r\n"); break;
+      default:
+         /* bytes per ms is kB/s */
+         my_printf("ymodem: %s, %lu bytes in %lu ms, %lu kB/s, crc32 %08lx\r\n",
+                   name, (unsigned long)len, (unsigned long)ms,
+                   (unsigned long)((ms != 0U) ? (uint32_t)len / ms : 0U),
+                   (unsigned long)crc32((const void *)addr, (uint32_t)len));
+         break;
+   }
+}
+
+// end file ymodem.c
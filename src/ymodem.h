@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ymodem.h
+ * @brief YMODEM-1K receiver into DDR over the console
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * For boards without USB or Ethernet: the console receives a file with
+ * YMODEM (1024-byte blocks, CRC-16), as sent by `sb`, Tera Term, or
+ * scripts/ymodem.py, which also raises the baud rate first.  Each block is
+ * read straight to its place in DDR.
+ */
+
+#ifndef YMODEM_H
+#define YMODEM_H
+
+#include <stdint.h>
+
+/* ymodem [addr [max]]: receive one file to addr, at most max bytes
+ * (default the download buffer, as for ethload). */
+void ymodem_cmd(int argc, uint32_t addr, uint32_t max, uint32_t arg3);
+
+#endif // YMODEM_H
+
+// end file ymodem.h
@@ -0,0 +1,243 @@
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright (c) 2026 Jakob Kastelic
+
+"""
+Write the packet captures that net_host replays through src/net.c and
+src/ethload.c.
+
+Each capture holds both sides of a conversation with the board, whose MAC
+is BOARD_MAC: frames from other hosts are fed to the stack, and frames from
+the board are what it must send in reply, in that order. The board's frames
+carry real checksums, as a capture on the wire would; net_host ignores them,
+since the MAC inserts them. DHCP transaction IDs are written as zero and
+matched up by net_host.
+
+The ethload and mcload captures carry IMAGE, which net_host also gets as a
+file, to compare with what the board assembled in DDR and wrote out. The
+board's ACK and MREP frames in them are worked out by hand from the
+protocol in src/ethload.h, step by step in the comments below.
+
+    mkpcap.py test/net
+"""
+
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+BOARD_MAC  = bytes.fromhex("020000135001")
+HOST_MAC   = bytes.fromhex("3c7c3fa1b2c3")
+SERVER_MAC = bytes.fromhex("001b21d4e5f6")
+BCAST_MAC  = b"\xff" * 6
+
+MC_GROUP   = bytes.fromhex("0353544d88b5")
+
+BOARD_IP  = "192.168.1.50"
+HOST_IP   = "192.168.1.10"
+SERVER_IP = "192.168.1.1"
+
+
+def ip4(s):
+    return bytes(int(x) for x in s.split("."))
+
+
+def csum(data):
+    if len(data) % 2:
+        data += b"\0"
+    s = sum(struct.unpack(f"!{len(data) // 2}H", data))
+    while s >> 16:
+        s = (s & 0xFFFF) + (s >> 16)
+    return ~s & 0xFFFF
+
+
+def eth(dst, src, etype, payload):
+    f = dst + src + struct.pack("!H", etype) + payload
+    return f + b"\0" * (60 - len(f)) if src != BOARD_MAC else f
+
+
+def arp(op, sha, spa, tha, tpa):
+    return struct.pack("!HHBBH", 1, 0x0800, 6, 4, op) + sha + ip4(spa) + \
+        tha + ip4(tpa)
+
+
+def ipv4(ident, proto, src, dst, payload):
+    h = struct.pack("!BBHHHBBH4s4s", 0x45, 0, 20 + len(payload), ident,
+                    0x4000, 64, proto, 0, ip4(src), ip4(dst))
+    return h[:10] + struct.pack("!H", csum(h)) + h[12:] + payload
+
+
+def icmp_echo(kind, ident, seq, data):
+    h = struct.pack("!BBHHH", kind, 0, 0, ident, seq) + data
+    return h[:2] + struct.pack("!H", csum(h)) + h[4:]
+
+
+def udp(src, dst, sport, dport, data):
+    h = struct.pack("!HHHH", sport, dport, 8 + len(data), 0) + data
+    pseudo = ip4(src) + ip4(dst) + struct.pack("!BBH", 0, 17, len(h))
+    return h[:6] + struct.pack("!H", csum(pseudo + h) or 0xFFFF) + h[8:]
+
+
+def opt(code, value):
+    return bytes([code, len(value)]) + value
+
+
+def bootp(op, yiaddr, siaddr, options):
+    """BOOTP message as dhcp_send() lays it out: broadcast flag set, the
+    options padded to 300 bytes in all."""
+    m = struct.pack("!BBBBIHH4s4s4s4s", op, 1, 6, 0, 0, 0, 0x8000,
+                    bytes(4), ip4(yiaddr), ip4(siaddr), bytes(4))
+    m += BOARD_MAC + bytes(10) + bytes(64) + bytes(128)
+    m += struct.pack("!I", 0x63825363) + options + b"\xff"
+    return m + bytes(max(0, 300 - len(m)))
+
+
+def el(dst, src, op, session, seq, payload=b"", status=0):
+    """ethload frame: u8 op, u8 status, u16 session, u32 seq, payload."""
+    return eth(dst, src, 0x88B5,
+               struct.pack("!BBHI", op, status, session, seq) + payload)
+
+
+def write_pcap(path, frames):
+    out = struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, 65535, 1)
+    for i, f in enumerate(frames):
+        out += struct.pack("<IIII", 1767225600, i * 1000, len(f), len(f))
+        out += f
+    Path(path).write_bytes(out)
+
+
+def arp_icmp():
+    payload = bytes(range(32))
+    return [
+        # who-has 192.168.1.50, answered
+        eth(BCAST_MAC, HOST_MAC, 0x0806,
+            arp(1, HOST_MAC, HOST_IP, bytes(6), BOARD_IP)),
+        eth(HOST_MAC, BOARD_MAC, 0x0806,
+            arp(2, BOARD_MAC, BOARD_IP, HOST_MAC, HOST_IP)),
+        # who-has another address, ignored
+        eth(BCAST_MAC, HOST_MAC, 0x0806,
+            arp(1, HOST_MAC, HOST_IP, bytes(6), "192.168.1.77")),
+        # two pings
+        eth(BOARD_MAC, HOST_MAC, 0x0800,
+            ipv4(0x5a01, 1, HOST_IP, BOARD_IP,
+                 icmp_echo(8, 0x1234, 1, payload))),
+        eth(HOST_MAC, BOARD_MAC, 0x0800,
+            ipv4(0, 1, BOARD_IP, HOST_IP, icmp_echo(0, 0x1234, 1, payload))),
+        eth(BOARD_MAC, HOST_MAC, 0x0800,
+            ipv4(0x5a02, 1, HOST_IP, BOARD_IP,
+                 icmp_echo(8, 0x1234, 2, payload))),
+        eth(HOST_MAC, BOARD_MAC, 0x0800,
+            ipv4(1, 1, BOARD_IP, HOST_IP, icmp_echo(0, 0x1234, 2, payload))),
+        # UDP to a closed port, ignored
+        eth(BOARD_MAC, HOST_MAC, 0x0800,
+            ipv4(0x5a03, 17, HOST_IP, BOARD_IP,
+                 udp(HOST_IP, BOARD_IP, 40000, 9999, b"hello"))),
+    ]
+
+
+def dhcp():
+    params = opt(55, bytes([1, 3, 67]))
+    server = [opt(54, ip4(SERVER_IP)), opt(51, struct.pack("!I", 3600)),
+              opt(1, ip4("255.255.255.0")), opt(3, ip4(SERVER_IP)),
+              opt(67, b"zImage")]
+
+    def to_server(ident, options):
+        return eth(BCAST_MAC, BOARD_MAC, 0x0800,
+                   ipv4(ident, 17, "0.0.0.0", "255.255.255.255",
+                        udp("0.0.0.0", "255.255.255.255", 68, 67,
+                            bootp(1, "0.0.0.0", "0.0.0.0", options))))
+
+    def to_board(kind):
+        options = opt(53, bytes([kind])) + b"".join(server)
+        return eth(BCAST_MAC, SERVER_MAC, 0x0800,
+                   ipv4(0x0100 + kind, 17, SERVER_IP, "255.255.255.255",
+                        udp(SERVER_IP, "255.255.255.255", 67, 68,
+                            bootp(2, BOARD_IP, SERVER_IP, options))))
+
+    return [
+        to_server(0, opt(53, b"\x01") + params),
+        to_board(2),
+        to_server(1, opt(53, b"\x03") + opt(50, ip4(BOARD_IP)) +
+                  opt(54, ip4(SERVER_IP)) + params),
+        to_board(5),
+        # the new address is in use
+        eth(BCAST_MAC, SERVER_MAC, 0x0806,
+            arp(1, SERVER_MAC, SERVER_IP, bytes(6), BOARD_IP)),
+        eth(SERVER_MAC, BOARD_MAC, 0x0806,
+            arp(2, BOARD_MAC, BOARD_IP, SERVER_MAC, SERVER_IP)),
+    ]
+
+
+# ethload: ten chunks of 64 bytes, the last one 40
+IMAGE = bytes((i * 7 + 3) & 0xFF for i in range(9 * 64 + 40))
+CHUNK = 64
+START, DATA, ACK, POLL, MDATA, MEND, MREP = range(1, 8)
+
+
+def chunk(i):
+    return IMAGE[i * CHUNK:(i + 1) * CHUNK]
+
+
+def ethload():
+    s = 0x4C01
+
+    def data(i, session=s):
+        return el(BOARD_MAC, HOST_MAC, DATA, session, i, chunk(i))
+
+    def ack(nxt, held, status=0):
+        return el(HOST_MAC, BOARD_MAC, ACK, s, nxt,
+                  struct.pack("!QI", held, 64), status)
+
+    start = el(BCAST_MAC, HOST_MAC, START, s, 0,
+               struct.pack("!IH", len(IMAGE), CHUNK))
+    return [
+        start, ack(0, 0),
+        start, ack(0, 0),           # a repeated START only asks for an ACK
+        data(0),                    # in order, no ACK yet
+        data(2), ack(1, 0b1),       # first gap: reported at once
+        data(3),                    # same gap, already reported
+        data(3),                    # duplicate
+        data(5),
+        data(1), ack(4, 0b1),       # gap closes onto the next one (4)
+        data(0),                    # old duplicate
+        data(4, session=0x1234),    # another session, ignored
+        el(BOARD_MAC, HOST_MAC, POLL, s, 0), ack(4, 0b1),
+        data(4),
+        data(6), data(7), data(8),
+        data(9), ack(10, 0, status=1),
+        el(BOARD_MAC, HOST_MAC, POLL, s, 0), ack(10, 0, status=1),
+    ]
+
+
+def mcload(crc):
+    s = 0x4D01
+    info = struct.pack("!IHHI", 200, CHUNK, 0, crc)
+
+    def data(i):
+        return el(MC_GROUP, SERVER_MAC, MDATA, s, i,
+                  info + IMAGE[i * CHUNK:min((i + 1) * CHUNK, 200)])
+
+    def rep(have, ranges, status=0):
+        return el(SERVER_MAC, BOARD_MAC, MREP, s, have,
+                  struct.pack(f"!I{len(ranges)}I", 4, *ranges), status)
+
+    end = el(MC_GROUP, SERVER_MAC, MEND, s, 1, info)
+    return [
+        data(0),                    # joins the session, 4 chunks
+        data(2),
+        end, rep(2, [1, 1, 3, 1]),  # missing ranges: first, count
+        data(2),                    # duplicate
+        data(1),
+        data(3), rep(4, [], status=1),
+        end, rep(4, [], status=1),
+    ]
+
+
+if __name__ == "__main__":
+    out = Path(sys.argv[1] if len(sys.argv) > 1 else ".")
+    write_pcap(out / "arp_icmp.pcap", arp_icmp())
+    write_pcap(out / "dhcp.pcap", dhcp())
+    write_pcap(out / "ethload.pcap", ethload())
+    (out / "ethload.bin").write_bytes(IMAGE)
+    (out / "mcload.bin").write_bytes(IMAGE[:200])
+    write_pcap(out / "mcload.pcap", mcload(zlib.crc32(IMAGE[:200])))
+    write_pcap(out / "mcload_badcrc.pcap", mcload(zlib.crc32(b"other")))
@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file net_host.c
+ * @brief Replay a packet capture through net.c and ethload.c on the host
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * The eth.c frame interface is replaced by the capture: frames from other
+ * hosts are handed to net_poll() in order, and each frame the stack sends
+ * must equal the next frame from BOARD_MAC, apart from the checksums the
+ * MAC would insert.  DHCP transaction IDs are taken from what the stack
+ * sends and written into the server's answers.
+ *
+ * For ethload and mcload, DDR is mapped at its address on the board so
+ * that the commands run unchanged, with their default buffers; what ends
+ * up there must equal the image file, and mcload must flash it (through
+ * the flash_write() stub) only if the image matched the sender's CRC-32.
+ *
+ *    net_host file.pcap ip 192.168.1.50     static address, then replay
+ *    net_host file.pcap dhcp 192.168.1.50   net_dhcp() must get this one
+ *    net_host file.pcap ethload image.bin   receive image.bin
+ *    net_host file.pcap mcload image.bin    receive and flash image.bin
+ *    net_host file.pcap mcbad image.bin     receive, refuse to flash
+ */
+
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS */
+
+#include "board.h"
+#include "console.h"
+#include "crc.h"
+#include "defaults.h"
+#include "eth.h"
+#include "ethload.h"
+#include "flash.h"
+#include "net.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define FRAME_MAX  1536U
+#define FRAMES_MAX 64U
+#define POLLS_MAX  5000U
+#define IMAGE_MAX  0x100000U
+
+#define PCAP_MAGIC    0xA1B2C3D4U
+#define PCAP_MAGIC_NS 0xA1B23C4DU
+#define PCAP_ETHERNET 1U
+
+#define DHCP_XID 4U /* offset in the BOOTP message */
+
+struct frame {
+   uint32_t len;
+   uint8_t data[FRAME_MAX];
+};
+
+static const uint8_t board_mac[6] = {0x02, 0x00, 0x00, 0x13, 0x50, 0x01};
+
+static struct frame cap[FRAMES_MAX];
+static uint32_t num;
+static uint32_t next; /* first frame not yet fed or matched */
+static int fed;       /* a frame was fed in this net_poll() */
+static uint8_t rx_buf[FRAME_MAX];
+static uint8_t tx_buf[FRAME_MAX];
+static int tx_busy;
+static uint8_t xid[4];
+static uint32_t tick;
+static void (*link_fn)(int up);
+static uint32_t polls;
+static int failed;
+
+static uint8_t image[IMAGE_MAX];
+static uint32_t image_len;
+static uint32_t flashed; /* bytes flash_write() got, matching image */
+static int flash_calls;
+
+static uint16_t get16(const uint8_t *p)
+{
+   return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+/* pcap files are in the byte order of the machine that wrote them. */
+static uint32_t rd32(const uint8_t *p, int swap)
+{
+   if (swap)
+      return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+             ((uint32_t)p[2] << 8) | p[3];
+   return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) |
+          ((uint32_t)p[1] << 8) | p[0];
+}
+
+static int from_board(const struct frame *f)
+{
+   return f->len >= NET_ETH_HDR && memcmp(&f->data[6], board_mac, 6U) == 0;
+}
+
+/* Whether f is a BOOTP message from UDP port sport. */
+static int is_dhcp(const uint8_t *f, uint32_t len, uint16_t sport)
+{
+   return len >= NET_UDP_DATA + DHCP_XID + 4U &&
+          get16(&f[12]) == 0x0800U && f[NET_ETH_HDR + 9] == 17U &&
+          get16(&f[NET_ETH_HDR + NET_IP_HDR]) == sport;
+}
+
+static void dump(const char *label, const uint8_t *f, uint32_t len)
+{
+   my_printf("%s (%lu bytes):", label, (unsigned long)len);
+   for (uint32_t i = 0; i < len; i++)
+      my_printf("%s%02x", (i % 16U) ? " " : "\r\n  ", f[i]);
+   my_printf("\r\n");
+}
+
+/* Compare a sent frame with the captured one, skipping the IPv4, ICMP and
+ * UDP checksums and the DHCP transaction ID. */
+static int same(const uint8_t *a, const uint8_t *b, uint32_t len)
+{
+   uint8_t skip[FRAME_MAX] = {0};
+   if (len >= NET_UDP_DATA && get16(&a[12]) == 0x0800U) {
+      const uint32_t l4 = NET_ETH_HDR + (a[NET_ETH_HDR] & 0x0FU) * 4U;
+      skip[NET_ETH_HDR + 10] = skip[NET_ETH_HDR + 11] = 1U;
+      if (a[NET_ETH_HDR + 9] == 1U)
+         skip[l4 + 2] = skip[l4 + 3] = 1U;
+      else if (a[NET_ETH_HDR + 9] == 17U)
+         skip[l4 + 6] = skip[l4 + 7] = 1U;
+      if (is_dhcp(a, len, 68U))
+         memset(&skip[NET_UDP_DATA + DHCP_XID], 1, 4U);
+   }
+   for (uint32_t i = 0; i < len; i++)
+      if (!skip[i] && a[i] != b[i])
+         return 0;
+   return 1;
+}
+
+static void load(const char *path)
+{
+   FILE *fp = fopen(path, "rb");
+   uint8_t h[24];
+   if (fp == NULL || fread(h, 1, sizeof(h), fp) != sizeof(h)) {
+      my_printf("%s: cannot read\r\n", path);
+      exit(2);
+   }
+   int swap = 0;
+   uint32_t magic = rd32(h, 0);
+   if (magic != PCAP_MAGIC && magic != PCAP_MAGIC_NS) {
+      swap  = 1;
+      magic = rd32(h, 1);
+   }
+   if ((magic != PCAP_MAGIC && magic != PCAP_MAGIC_NS) ||
+       rd32(&h[20], swap) != PCAP_ETHERNET) {
+      my_printf("%s: not an Ethernet pcap file\r\n", path);
+      exit(2);
+   }
+
+   uint8_t r[16];
+   while (fread(r, 1, sizeof(r), fp) == sizeof(r)) {
+      const uint32_t len = rd32(&r[8], swap);
+      if (num == FRAMES_MAX || len > FRAME_MAX ||
+          fread(cap[num].data, 1, len, fp) != len) {
+         my_printf("%s: frame %lu too long or cut off\r\n", path,
+                   (unsigned long)num);
+         exit(2);
+      }
+      cap[num++].len = len;
+   }
+   fclose(fp);
+}
+
+static void load_image(const char *path)
+{
+   FILE *fp = fopen(path, "rb");
+   if (fp == NULL) {
+      my_printf("%s: cannot read\r\n", path);
+      exit(2);
+   }
+   image_len = (uint32_t)fread(image, 1, sizeof(image), fp);
+   fclose(fp);
+}
+
+/* The board's DDR, where ethload.c expects it. */
+static void map_ddr(void)
+{
+   void *p = mmap((void *)(uintptr_t)DEF_DDR_BASE, DDR_MEM_SIZE,
+                  PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1,
+                  0);
+   if (p != (void *)(uintptr_t)DEF_DDR_BASE) {
+      my_printf("cannot map DDR at 0x%08lx\r\n",
+                (unsigned long)DEF_DDR_BASE);
+      exit(2);
+   }
+}
+
+static void check_ddr(void)
+{
+   if (memcmp((const void *)(uintptr_t)DEF_FASTBOOT_ADDR, image,
+              image_len) != 0) {
+      my_printf("image in DDR differs\r\n");
+      failed = 1;
+   }
+}
+
+static uint32_t parse_ip(const char *s)
+{
+   unsigned a, b, c, d;
+   if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) {
+      my_printf("bad address %s\r\n", s);
+      exit(2);
+   }
+   return (a << 24) | (b << 16) | (c << 8) | d;
+}
+
+/* ------------------------------------------------------------------------
+ * What net.c needs from eth.c, the HAL and the console
+ * ------------------------------------------------------------------------ */
+
+uint32_t HAL_GetTick(void)
+{
+   return tick++; /* each look at the clock is a millisecond */
+}
+
+/* ethload and mcload wait for Ctrl-C if the transfer stalls. */
+int console_interrupted(void)
+{
+   return polls > POLLS_MAX;
+}
+
+uint32_t crc32(const void *buf, uint32_t len)
+{
+   const uint8_t *p = buf;
+   uint32_t c       = 0xFFFFFFFFU;
+   while (len--) {
+      c ^= *p++;
+      for (int k = 0; k < 8; k++)
+         c = (c >> 1) ^ (0xEDB88320U & (0U - (c & 1U)));
+   }
+   return ~c;
+}
+
+int flash_lookup(const char *name, struct flash_part *p)
+{
+   memset(p, 0, sizeof(*p));
+   p->name = name;
+   return 0;
+}
+
+int flash_write(const struct flash_part *p, const uint8_t *img, uint32_t len)
+{
+   (void)p;
+   flash_calls++;
+   if (len == image_len && memcmp(img, image, len) == 0)
+      flashed = len;
+   return 0;
+}
+
+/* net_poll() calls this first; one frame per call, as if each arrived on
+ * its own, so that what the stack does in between is not skipped. */
+void eth_poll(void)
+{
+   fed = 0;
+   polls++;
+}
+
+void eth_mcast_filter(const uint8_t *group)
+{
+   (void)group;
+}
+
+void eth_on_link(void (*fn)(int up))
+{
+   link_fn = fn;
+}
+
+const uint8_t *eth_mac_addr(void)
+{
+   return board_mac;
+}
+
+const uint8_t *eth_rx(uint16_t *len)
+{
+   if (fed || next == num || from_board(&cap[next]))
+      return NULL;
+   fed                   = 1;
+   const struct frame *f = &cap[next++];
+   memcpy(rx_buf, f->data, f->len);
+   if (is_dhcp(rx_buf, f->len, 67U))
+      memcpy(&rx_buf[NET_UDP_DATA + DHCP_XID], xid, 4U);
+   *len = (uint16_t)f->len;
+   return rx_buf;
+}
+
+void eth_rx_done(const uint8_t *frame)
+{
+   (void)frame;
+}
+
+uint8_t *eth_tx_alloc(void)
+{
+   if (tx_busy)
+      return NULL;
+   tx_busy = 1;
+   return tx_buf;
+}
+
+void eth_tx_drop(uint8_t *frame)
+{
+   (void)frame;
+   tx_busy = 0;
+}
+
+int eth_tx(uint8_t *frame, uint16_t len)
+{
+   tx_busy = 0;
+   if (next == num || !from_board(&cap[next])) {
+      my_printf("frame %lu: not expected\r\n", (unsigned long)next);
+      dump("sent", frame, len);
+      failed = 1;
+      return 0;
+   }
+   const struct frame *f = &cap[next++];
+   if (f->len != len || !same(frame, f->data, len)) {
+      my_printf("frame %lu: differs\r\n", (unsigned long)(next - 1U));
+      dump("sent", frame, len);
+      dump("expected", f->data, f->len);
+      failed = 1;
+   }
+   if (is_dhcp(frame, len, 68U))
+      memcpy(xid, &frame[NET_UDP_DATA + DHCP_XID], 4U);
+   return 0;
+}
+
+static void out(char c)
+{
+   (void)putchar(c);
+}
+
+int main(int argc, char **argv)
+{
+   printf_set_output(out);
+   if (argc != 4) {
+      my_printf("usage: net_host file.pcap ip|dhcp address\r\n"
+                "       net_host file.pcap ethload|mcload|mcbad image\r\n");
+      return 2;
+   }
+   load(argv[1]);
+   net_init();
+   if (link_fn != NULL)
+      link_fn(1);
+
+   if (strcmp(argv[2], "ip") == 0) {
+      net_ip_cmd(2, parse_ip(argv[3]), 0xFFFFFF00U, 0U);
+   } else if (strcmp(argv[2], "dhcp") == 0) {
+      if (net_dhcp() != 0 || net_config()->ip != parse_ip(argv[3])) {
+         my_printf("DHCP did not configure %s\r\n", argv[3]);
+         failed = 1;
+      }
+   } else if (strcmp(argv[2], "ethload") == 0) {
+      load_image(argv[3]);
+      map_ddr();
+      ethload_cmd(0, 0U, 0U, 0U);
+      check_ddr();
+   } else if (strcmp(argv[2], "mcload") == 0 ||
+              strcmp(argv[2], "mcbad") == 0) {
+      const int want = strcmp(argv[2], "mcload") == 0;
+      load_image(argv[3]);
+      map_ddr();
+      mcload_cmd(1, 1U, 0U, 0U);
+      check_ddr();
+      if (want ? (flash_calls != 1 || flashed != image_len)
+               : (flash_calls != 0)) {
+         my_printf("image %s, expected it %s\r\n",
+                   flash_calls ? "flashed" : "not flashed",
+                   want ? "flashed" : "refused");
+         failed = 1;
+      }
+   } else {
+      my_printf("unknown mode %s\r\n", argv[2]);
+      return 2;
+   }
+
+   while (polls < POLLS_MAX && next < num && !failed)
+      net_poll();
+   if (next < num && !failed) {
+      my_printf("frame %lu: never sent\r\n", (unsigned long)next);
+      dump("expected", cap[next].data, cap[next].len);
+      failed = 1;
+   }
+   my_printf("%s: %s, %lu frames\r\n", argv[1], failed ? "FAIL" : "ok",
+             (unsigned long)num);
+   return failed;
+}
+
+// end file net_host.c
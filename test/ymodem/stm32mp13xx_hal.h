@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file stm32mp13xx_hal.h
+ * @brief Host stand-in for the HAL header, for ymodem_host
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * ymodem.c only needs the millisecond tick from the HAL.
+ */
+
+#ifndef STM32MP13XX_HAL_H
+#define STM32MP13XX_HAL_H
+
+#include <stdint.h>
+
+uint32_t HAL_GetTick(void);
+
+#endif // STM32MP13XX_HAL_H
+
+// end file stm32mp13xx_hal.h
@@ -0,0 +1,451 @@
+// SPDX-License-Identifier: BSD-3-Clause
+
+/**
+ * @file ymodem_host.c
+ * @brief Run ymodem.c on the host against a simulated YMODEM sender
+ * @author Jakob Kastelic
+ * @copyright 2026 Jakob Kastelic
+ *
+ * The console is replaced by a sender that answers each byte ymodem.c
+ * writes (C, ACK, NAK, CAN) the way sb does, and resends when the
+ * receiver has been silent for SEND_TIMEOUT_MS.  The tick only advances
+ * while the receiver waits for input, so timeouts cost no real time.  Each
+ * mode puts a different fault on the line:
+ *
+ *    ymodem_host clean       no faults
+ *    ymodem_host crc         one corrupted byte: NAK and resend
+ *    ymodem_host dup         one lost ACK: the resent block is a duplicate
+ *    ymodem_host resync      noise before a block, then a cut-off block
+ *    ymodem_host big         header longer than the buffer: cancelled
+ *    ymodem_host nolen       no length in the header, too much data
+ *    ymodem_host noise seed  random corruption and loss both ways
+ *
+ * DDR is mapped at its address on the board, so that ymodem_cmd() runs
+ * unchanged; what ends up there must equal the file sent.
+ */
+
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS */
+
+#include "board.h"
+#include "console.h"
+#include "crc.h"
+#include "defaults.h"
+#include "printf.h"
+#include "stm32mp13xx_hal.h"
+#include "ymodem.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define SOH      0x01U
+#define STX      0x02U
+#define EOT      0x04U
+#define ACK      0x06U
+#define NAK      0x15U
+#define CAN      0x18U
+#define CRC_MODE 'C'
+
+#define YM_BLOCK        1024U
+#define FILE_NAME       "test.bin"
+#define FILE_LEN        (40U * YM_BLOCK + 100U) /* last block is short */
+#define BLOCKS          ((FILE_LEN + YM_BLOCK - 1U) / YM_BLOCK)
+#define SMALL_MAX       4096U /* buffer for big and nolen */
+#define SEND_TIMEOUT_MS 3000U
+#define SEND_RETRIES    20U /* then the sender gives up, as sb does */
+#define LINE_MAX        8192U /* power of two */
+#define LOG_MAX         4096U
+
+/* noise: one byte to the board in NOISE_FLIP is corrupted and one in
+ * NOISE_DROP lost; one reply in NOISE_REPLY is corrupted, and as many
+ * lost. */
+#define NOISE_FLIP  5000U
+#define NOISE_DROP  20000U
+#define NOISE_REPLY 20U
+
+enum mode {
+   M_CLEAN,
+   M_CRC,
+   M_DUP,
+   M_RESYNC,
+   M_BIG,
+   M_NOLEN,
+   M_NOISE,
+};
+
+enum state {
+   S_HEADER,     /* waiting for C */
+   S_HEADER_ACK, /* header sent */
+   S_START,      /* header acknowledged, waiting for C */
+   S_DATA,       /* block cur sent */
+   S_EOT,        /* EOT sent */
+   S_END,        /* EOT acknowledged, waiting for C */
+   S_END_ACK,    /* empty header sent */
+   S_DONE,
+   S_CANCELLED,
+};
+
+static const char *const mode_names[] = {
+    [M_CLEAN] = "clean", [M_CRC] = "crc", [M_DUP] = "dup",
+    [M_RESYNC] = "resync", [M_BIG] = "big", [M_NOLEN] = "nolen",
+    [M_NOISE] = "noise",
+};
+
+static enum mode mode;
+static enum state state;
+static uint8_t image[FILE_LEN];
+static uint32_t cur;               /* data block being sent */
+static uint32_t sends[BLOCKS + 1]; /* times each data block went out */
+static int cans;                   /* CANs in a row */
+static uint32_t naks;
+static uint32_t timeouts;
+
+static uint8_t line[LINE_MAX]; /* sender to board */
+static uint32_t line_head;
+static uint32_t line_tail;
+static uint32_t tick;
+static uint32_t last; /* tick of the last byte either way */
+static int raw;
+static uint32_t rng = 1U;
+
+static char log_buf[LOG_MAX]; /* console output outside raw mode */
+static uint32_t log_len;
+
+/* xorshift32, so that a seed gives the same run everywhere */
+static uint32_t rnd(uint32_t n)
+{
+   rng ^= rng << 13;
+   rng ^= rng >> 17;
+   rng ^= rng << 5;
+   return rng % n;
+}
+
+static uint16_t crc16(const uint8_t *p, uint32_t n)
+{
+   uint16_t crc = 0U;
+   while (n--) {
+      crc ^= (uint16_t)((uint16_t)*p++ << 8);
+      for (int i = 0; i < 8; i++)
+         crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U)
+                               : (uint16_t)(crc << 1);
+   }
+   return crc;
+}
+
+static void to_board(uint8_t c)
+{
+   if (line_tail - line_head == LINE_MAX) {
+      my_printf("line overflow\r\n");
+      exit(2);
+   }
+   line[line_tail++ % LINE_MAX] = c;
+}
+
+/* Noise leaves the first byte alone: a corrupted STX can read as Ctrl-C,
+ * and if it is lost, the number of block 4 reads as EOT.  The receiver
+ * rightly acts on both. */
+static void send_frame(const uint8_t *f, uint32_t n)
+{
+   for (uint32_t i = 0; i < n; i++) {
+      uint8_t c = f[i];
+      if (mode == M_NOISE && i > 0U) {
+         if (rnd(NOISE_DROP) == 0U)
+            continue;
+         if (rnd(NOISE_FLIP) == 0U)
+            c ^= (uint8_t)(1U << rnd(8U));
+      }
+      to_board(c);
+   }
+   last = tick;
+}
+
+/* Frame a block numbered num whose payload is at f[3]; returns its
+ * length. */
+static uint32_t make_block(uint8_t *f, uint32_t n, uint8_t num)
+{
+   f[0]               = (n == YM_BLOCK) ? STX : SOH;
+   f[1]               = num;
+   f[2]               = (uint8_t)~num;
+   const uint16_t crc = crc16(&f[3], n);
+   f[3U + n]          = (uint8_t)(crc >> 8);
+   f[4U + n]          = (uint8_t)crc;
+   return n + 5U;
+}
+
+/* Block 0: the file name and length, or all zeros to end the batch. */
+static void send_header(int end)
+{
+   uint8_t f[128U + 5U] = {0};
+   if (!end) {
+      memcpy(&f[3], FILE_NAME, sizeof(FILE_NAME));
+      if (mode != M_NOLEN)
+         (void)snprintf((char *)&f[3U + sizeof(FILE_NAME)], 32U, "%u 0 0",
+                        (unsigned)FILE_LEN);
+   }
+   send_frame(f, make_block(f, 128U, 0U));
+}
+
+/* Data block blk, 128 bytes if that is enough for the rest of the file,
+ * padded with ^Z.  The mode's faults go on its first transmission. */
+static void send_data(uint32_t blk)
+{
+   uint8_t f[YM_BLOCK + 5U];
+   const uint32_t off = (blk - 1U) * YM_BLOCK;
+   const uint32_t rem = FILE_LEN - off;
+   const uint32_t n   = (rem <= 128U) ? 128U : YM_BLOCK;
+   memset(&f[3], 0x1A, n);
+   memcpy(&f[3], &image[off], (rem < n) ? rem : n);
+
+   if (sends[blk] > SEND_RETRIES) {
+      state = S_CANCELLED;
+      return;
+   }
+   uint32_t len    = make_block(f, n, (uint8_t)blk);
+   const int first = sends[blk]++ == 0U;
+   if (first && mode == M_CRC && blk == 3U)
+      f[3U + 100U] ^= 0x10U;
+   if (first && mode == M_RESYNC && blk == 4U)
+      send_frame((const uint8_t *)"+++\r\n", 5U);
+   if (first && mode == M_RESYNC && blk == 5U)
+      len = 500U;
+   send_frame(f, len);
+}
+
+static void send_eot(void)
+{
+   const uint8_t c = EOT;
+   send_frame(&c, 1U);
+}
+
+/* A byte from the receiver. */
+static void from_board(uint8_t c)
+{
+   if (mode == M_NOISE) {
+      if (rnd(NOISE_REPLY) == 0U)
+         return;
+      if (rnd(NOISE_REPLY) == 0U)
+         c ^= (uint8_t)(1U << rnd(8U));
+   }
+   if (mode == M_DUP && c == ACK && state == S_DATA && cur == 2U &&
+       sends[2] == 1U)
+      return;
+   last = tick;
+
+   cans = (c == CAN) ? cans + 1 : 0;
+   if (cans >= 2) {
+      state = S_CANCELLED;
+      return;
+   }
+   naks += (c == NAK);
+
+   switch (state) {
+      case S_HEADER:
+         if (c == CRC_MODE) {
+            send_header(0);
+            state = S_HEADER_ACK;
+         }
+         break;
+      case S_HEADER_ACK:
+         if (c == ACK)
+            state = S_START;
+         else if (c == NAK || c == CRC_MODE)
+            send_header(0);
+         break;
+      case S_START:
+         if (c == CRC_MODE || c == NAK) {
+            cur = 1U;
+            send_data(cur);
+            state = S_DATA;
+         }
+         break;
+      case S_DATA:
+         if (c == ACK && cur == BLOCKS) {
+            send_eot();
+            state = S_EOT;
+         } else if (c == ACK) {
+            send_data(++cur);
+         } else if (c == NAK) {
+            send_data(cur);
+         }
+         break;
+      case S_EOT:
+         if (c == ACK)
+            state = S_END;
+         else if (c == NAK)
+            send_eot();
+         break;
+      case S_END:
+         if (c == CRC_MODE) {
+            send_header(1);
+            state = S_END_ACK;
+         }
+         break;
+      case S_END_ACK:
+         if (c == ACK)
+            state = S_DONE;
+         else if (c == NAK || c == CRC_MODE)
+            send_header(1);
+         break;
+      default: break;
+   }
+}
+
+/* The receiver has said nothing for SEND_TIMEOUT_MS. */
+static void send_timeout(void)
+{
+   timeouts++;
+   last = tick;
+   switch (state) {
+      case S_HEADER_ACK: send_header(0); break;
+      case S_START:
+         cur   = 1U;
+         state = S_DATA;
+         send_data(cur);
+         break;
+      case S_DATA: send_data(cur); break;
+      case S_EOT: send_eot(); break;
+      case S_END_ACK: send_header(1); break;
+      default: break;
+   }
+}
+
+/* The board's DDR, where ymodem.c expects it. */
+static void map_ddr(void)
+{
+   void *p = mmap((void *)(uintptr_t)DEF_DDR_BASE, DDR_MEM_SIZE,
+                  PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1,
+                  0);
+   if (p != (void *)(uintptr_t)DEF_DDR_BASE) {
+      my_printf("cannot map DDR at 0x%08lx\r\n",
+                (unsigned long)DEF_DDR_BASE);
+      exit(2);
+   }
+}
+
+/* ------------------------------------------------------------------------
+ * What ymodem.c needs from the console, the HAL and the CRC unit
+ * ------------------------------------------------------------------------ */
+
+/* Time passes only while the receiver waits for input, a millisecond each
+ * time it looks at the clock. */
+uint32_t HAL_GetTick(void)
+{
+   if (line_head == line_tail)
+      tick++;
+   return tick;
+}
+
+int console_rx_empty(void)
+{
+   if (raw && line_head == line_tail && tick - last >= SEND_TIMEOUT_MS)
+      send_timeout();
+   return line_head == line_tail;
+}
+
+char console_rx_get(void)
+{
+   return (char)line[line_head++ % LINE_MAX];
+}
+
+void console_set_raw(int on)
+{
+   raw = on;
+}
+
+void uart_flush(void)
+{
+}
+
+uint32_t crc32(const void *buf, uint32_t len)
+{
+   const uint8_t *p = buf;
+   uint32_t c       = 0xFFFFFFFFU;
+   while (len--) {
+      c ^= *p++;
+      for (int k = 0; k < 8; k++)
+         c = (c >> 1) ^ (0xEDB88320U & (0U - (c & 1U)));
+   }
+   return ~c;
+}
+
+/* In raw mode, ymodem.c's protocol bytes go to the sender. */
+static void out(char c)
+{
+   if (raw) {
+      from_board((uint8_t)c);
+      return;
+   }
+   (void)putchar(c);
+   if (log_len < LOG_MAX - 1U)
+      log_buf[log_len++] = c;
+}
+
+static int check(int ok, const char *what)
+{
+   if (!ok)
+      my_printf("%s\r\n", what);
+   return !ok;
+}
+
+int main(int argc, char **argv)
+{
+   printf_set_output(out);
+   int m = 0;
+   while (argc > 1 && m <= M_NOISE && strcmp(argv[1], mode_names[m]) != 0)
+      m++;
+   if (argc < 2 || m > M_NOISE || (argc == 3) != (m == M_NOISE)) {
+      my_printf("usage: ymodem_host clean|crc|dup|resync|big|nolen\r\n"
+                "       ymodem_host noise seed\r\n");
+      return 2;
+   }
+   mode = (enum mode)m;
+
+   for (uint32_t i = 0; i < FILE_LEN; i++)
+      image[i] = (uint8_t)rnd(256U);
+   if (mode == M_NOISE)
+      rng = 2U * (uint32_t)strtoul(argv[2], NULL, 0) + 1U; /* never 0 */
+   map_ddr();
+   uint8_t *const ddr = (uint8_t *)(uintptr_t)DEF_FASTBOOT_ADDR;
+
+   int failed = 0;
+   if (mode == M_BIG || mode == M_NOLEN) {
+      ymodem_cmd(2, DEF_FASTBOOT_ADDR, SMALL_MAX, 0U);
+      failed |= check(strstr(log_buf, "ymodem: file too large") != NULL,
+                      "not refused as too large");
+      failed |= check(state == S_CANCELLED, "sender not cancelled");
+      failed |= check(ddr[SMALL_MAX] == 0U, "wrote past the buffer");
+      if (mode == M_BIG)
+         failed |= check(sends[1] == 0U, "not refused at the header");
+      if (mode == M_NOLEN)
+         failed |= check(memcmp(ddr, image, SMALL_MAX) == 0,
+                         "image in DDR differs");
+   } else {
+      char want[64];
+      (void)snprintf(want, sizeof(want), "ymodem: %s, %u bytes", FILE_NAME,
+                     (unsigned)FILE_LEN);
+      ymodem_cmd(0, 0U, 0U, 0U);
+      failed |= check(strstr(log_buf, want) != NULL, "wrong result");
+      failed |= check(memcmp(ddr, image, FILE_LEN) == 0,
+                      "image in DDR differs");
+      /* Under noise the last ACK or C can be lost, after which the
+       * receiver finishes on its own. */
+      if (mode != M_NOISE)
+         failed |= check(state == S_DONE, "batch not closed");
+      if (mode == M_CRC || mode == M_RESYNC)
+         failed |= check(naks >= 1U, "no NAK");
+      if (mode == M_DUP)
+         failed |= check(timeouts == 1U && sends[2] == 2U,
+                         "block 2 not sent twice");
+      if (mode == M_NOISE)
+         failed |= check(naks + timeouts >= 1U, "no faults hit");
+   }
+
+   my_printf("ymodem_host %s: %s, %lu NAKs, %lu timeouts\r\n", argv[1],
+             failed ? "FAIL" : "ok", (unsigned long)naks,
+             (unsigned long)timeouts);
+   return failed;
+}
+
+// end file ymodem_host.c
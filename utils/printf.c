@@ -154,6 +154,11 @@ void printf_set_output(printf_output_fn_t fn)
    _g_output = fn;
 }
 
+printf_output_fn_t printf_get_output(void)
+{
+   return _g_output;
+}
+
 // internal output-function wrapper used by printf_() / vprintf_()
 static void _out_char(char character, void *buffer, size_t idx, size_t maxlen)
 {
@@ -49,6 +49,12 @@ extern "C" {
 typedef void (*printf_output_fn_t)(char);
 void printf_set_output(printf_output_fn_t fn);
 
+/**
+ * Return the currently registered output function, so that a temporary
+ * console (e.g. USB) can restore it when it goes away.
+ */
+printf_output_fn_t printf_get_output(void);
+
 /**
  * Tiny printf implementation
  * You have to implement _putchar if you use printf()